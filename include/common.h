@@ -14,24 +14,16 @@ enum Corner { TOP_LEFT = 0x00, TOP_RIGHT = 0x01, BOTTOM_LEFT = 0x02, BOTTOM_RIGH
 
 enum CornerBF { TOP_LEFT_BF = 0x01, TOP_RIGHT_BF = 0x02, BOTTOM_LEFT_BF = 0x04, BOTTOM_RIGHT_BF = 0x08 };
 
-struct AtomicBox {
-    std::string id;
-    int page;
-    float x;
-    float y;
-    float width;
-    float height;
-    float stroke_width;
-};
-
 struct Metadata {
     int id;
     int page;
     std::string name;
 };
 
+struct ParserContext;
+
 struct Parser {
-    std::optional<cv::Mat> (*parser)(const cv::Mat& img,
+    std::optional<cv::Mat> (*parser)(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                      cv::Mat debug_img,
 #endif
@@ -41,6 +33,6 @@ struct Parser {
 /**
  * @brief Types de parseurs disponibles pour l'analyse des marqueurs dans l'image
  */
-enum class ParserType { ARUCO, CIRCLE, ZXING, SHAPE, CENTER_PARSER, DEFAULT_PARSER, EMPTY };
+enum class ParserType { ARUCO, CIRCLE, ZXING, SHAPE, CENTER_PARSER, DEFAULT_PARSER, QR_EYE, CROSS, CUSTOM, EMPTY };
 
 #endif
\ No newline at end of file
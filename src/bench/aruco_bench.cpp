@@ -0,0 +1,88 @@
+#include <iostream>
+#include <unordered_map>
+#include <variant>
+#include <random>
+
+#include <common.h>
+
+#include "utils/cli_helper.h"
+#include "utils/benchmark_helper.h"
+#include "utils/parser_helper.h"
+#include "parser/aruco_parser.h"
+#include "aruco_bench.h"
+
+using ArucoFunc = std::vector<std::pair<int, std::vector<cv::Point2f>>> (*)(const cv::Mat&, const cv::Point2i&);
+
+/**
+ * @brief Mesure le temps moyen de détection ArUco sur une copie entière (quatre quadrants)
+ *
+ * Un premier appel non mesuré construit les éventuels caches avant la mesure.
+ *
+ * @return std::pair<double, int> Temps moyen par copie en millisecondes et nombre de marqueurs de coin trouvés
+ */
+static std::pair<double, int> measure_sheet(const std::string& name, const cv::Mat& img, ArucoFunc identify,
+                                            int iterations) {
+#ifdef DEBUG
+    cv::Mat debug_img;
+    cv::cvtColor(img, debug_img, cv::COLOR_GRAY2BGR);
+#endif
+    // réglages par défaut : quadrants analysés séquentiellement, sans arrêt anticipé
+    ParserContext parser_ctx;
+    auto parse_sheet = [&]() {
+        return smaller_parse(parser_ctx, img,
+#ifdef DEBUG
+                             debug_img,
+#endif
+                             identify);
+    };
+
+    int nb_corner_markers = 0;
+    for (const auto& [id, corners] : parse_sheet()) {
+        if (id == 190 || id == 997 || id == 999)
+            nb_corner_markers += 1;
+    }
+
+    double total_ms = Benchmark::measure("  " + name, [&]() {
+        for (int i = 0; i < iterations; ++i) {
+            parse_sheet();
+        }
+    });
+    return { total_ms / iterations, nb_corner_markers };
+}
+
+void aruco_bench(const std::unordered_map<std::string, Config>& config) {
+    MicroBenchSetup setup = prepare_micro_bench(config, true);
+    const int nb_copies = setup.nb_copies, iterations = setup.iterations;
+
+    Csv<std::string, int, double, double, double, int, int> benchmark_csv(
+        setup.csv_path,
+        { "File", "Iterations", "Full_Dictionary_Time_ms", "Cached_Reduced_Time_ms", "Speedup",
+          "Corner_Markers_Full", "Corner_Markers_Reduced" },
+        setup.csv_mode);
+
+    std::mt19937 master_gen = micro_bench_generator(setup.master_seed);
+
+    for (int i = 1; i <= nb_copies; i++) {
+        std::string copy_name = "aruco-copy-" + std::to_string(i);
+        std::cout << "Generating copy " << i << "/" << nb_copies << "..." << std::endl;
+        cv::Mat img = generate_micro_bench_copy(setup, master_gen, copy_name);
+        if (img.empty())
+            continue;
+
+        std::string filename = copy_name + ".png";
+
+        std::cout << "ArUco detection on " << filename << " (" << iterations << " iterations):" << std::endl;
+        auto [full_ms, full_found] =
+            measure_sheet("Full dictionary, rebuilt per call", img, identify_aruco_full_dictionary, iterations);
+        auto [cached_ms, cached_found] = measure_sheet("Reduced dictionary, cached", img, identify_aruco, iterations);
+
+        double speedup = cached_ms > 0 ? full_ms / cached_ms : 0;
+        std::cout << "  Per sheet: " << std::fixed << std::setprecision(3) << full_ms << " ms -> " << cached_ms
+                  << " ms (x" << speedup << "), corner markers: " << full_found << " / " << cached_found
+                  << std::endl;
+
+        benchmark_csv.add_row({ filename, iterations, full_ms, cached_ms, speedup, full_found, cached_found });
+    }
+
+    std::cout << "aruco-bench completed with " << nb_copies << " copies." << std::endl;
+}
@@ -0,0 +1,33 @@
+#ifndef ARUCO_BENCH_H
+#define ARUCO_BENCH_H
+
+/**
+ * @file aruco_bench.h
+ * @brief Micro-benchmark de la détection des marqueurs ArUco.
+ *
+ * Compare, sur les mêmes copies, le temps de détection des marqueurs ArUco par copie
+ * (quatre quadrants via smaller_parse) entre l'ancienne implémentation, qui reconstruit le
+ * détecteur avec le dictionnaire DICT_4X4_1000 complet à chaque appel, et le détecteur mis en
+ * cache par thread avec le dictionnaire réduit aux marqueurs de coin.
+ */
+
+#include <unordered_map>
+#include <string>
+#include <common.h>
+
+/**
+ * @brief Exécute le micro-benchmark de détection ArUco
+ *
+ * @param config Une map non ordonnée contenant les paramètres de configuration incluant:
+ *               - nb-copies: Nombre de copies à générer
+ *               - iterations: Nombre de détections mesurées par copie et par implémentation
+ *               - marker-config: Chaîne de configuration pour la génération de marqueurs
+ *               - encoded-marker-size, unencoded-marker-size, header-marker-size, grey-level, dpi:
+ *                 Paramètres de génération des copies
+ *               - seed: Graine pour le générateur de nombres aléatoires
+ *               - csv-mode: Mode d'ajout ou d'écrasement pour la sortie CSV
+ *               - csv-filename: Nom du fichier CSV de sortie
+ */
+void aruco_bench(const std::unordered_map<std::string, Config>& config);
+
+#endif // ARUCO_BENCH_H
@@ -126,19 +126,15 @@ static double analyze_ink_consumption(const std::filesystem::path& image_path, i
 
 /**
  * @brief Calcule l'aire d'un marqueur en cm²
- * @param marker Pointeur partagé vers le marqueur
+ * @param marker Rectangle du marqueur (en mm)
  * @return Aire du marqueur en cm²
  */
-static double calculate_marker_area_cm2(const std::shared_ptr<AtomicBox>& marker) {
-    if (marker == nullptr) {
-        return 0.0;
-    }
-
-    double width_cm = marker->width * 0.1;
-    double height_cm = marker->height * 0.1;
-    if (marker->stroke_width > 0) {
-        width_cm += marker->stroke_width / 2 * 0.1;
-        height_cm += marker->stroke_width / 2 * 0.1;
+static double calculate_marker_area_cm2(const LayoutRect& marker) {
+    double width_cm = marker.width * 0.1;
+    double height_cm = marker.height * 0.1;
+    if (marker.stroke_width > 0) {
+        width_cm += marker.stroke_width / 2 * 0.1;
+        height_cm += marker.stroke_width / 2 * 0.1;
     }
 
     return width_cm * height_cm;
@@ -146,11 +142,11 @@ static double calculate_marker_area_cm2(const std::shared_ptr<AtomicBox>& marker
 
 /**
  * @brief Analyse l'aire des marqueurs de coin
- * @param corner_markers Vecteur des marqueurs de coin
+ * @param corner_markers Marqueurs de coin, indexés par Corner
  * @return Aire totale des marqueurs de coin en cm²
  */
 static double
-analyze_corner_markers_area(const std::vector<std::optional<std::shared_ptr<AtomicBox>>>& corner_markers) {
+analyze_corner_markers_area(const std::array<std::optional<LayoutRect>, NB_CORNER_MARKERS>& corner_markers) {
     double total_corner_markers_area_cm2 = 0.0;
     std::cout << "\n=== Corner Markers Areas ===" << std::endl;
 
@@ -163,9 +159,7 @@ analyze_corner_markers_area(const std::vector<std::optional<std::shared_ptr<Atom
         double area_cm2 = calculate_marker_area_cm2(corner_markers[i].value());
         total_corner_markers_area_cm2 += area_cm2;
 
-        if (corner_markers[i] != nullptr) {
-            std::cout << corner_names[i] << " marker area: " << area_cm2 << " cm²" << std::endl;
-        }
+        std::cout << corner_names[i] << " marker area: " << area_cm2 << " cm²" << std::endl;
     }
 
     std::cout << "Total corner markers area: " << total_corner_markers_area_cm2 << " cm²" << std::endl;
@@ -251,12 +245,9 @@ void config_analysis_benchmark(const std::unordered_map<std::string, Config>& co
         throw std::runtime_error(std::string("could not json parse file : ") + e.what());
     }
 
-    auto atomic_boxes = json_to_atomicBox(atomic_boxes_json);
-    std::vector<std::optional<std::shared_ptr<AtomicBox>>> corner_markers;
-    std::vector<std::vector<std::shared_ptr<AtomicBox>>> user_boxes_per_page;
-    differentiate_atomic_boxes(atomic_boxes, corner_markers, user_boxes_per_page);
+    const Layout layout = compile_layout(atomic_boxes_json);
 
-    double total_corner_markers_area_cm2 = analyze_corner_markers_area(corner_markers);
+    double total_corner_markers_area_cm2 = analyze_corner_markers_area(layout.corners);
 
     // Ajout des résultats au CSV
     ink_estimation_csv.add_row(std::make_tuple(image_path.filename().string(), copy_marker_config, dpi, ink_volume_ml,
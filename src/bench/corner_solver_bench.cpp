@@ -0,0 +1,188 @@
+#include <iostream>
+#include <unordered_map>
+#include <variant>
+#include <random>
+#include <tuple>
+
+#include <common.h>
+
+#include "utils/cli_helper.h"
+#include "utils/benchmark_helper.h"
+#include "parser/center_marker_parser.h"
+#include "corner_solver_bench.h"
+
+// page A4 à 300 dpi, centres des marqueurs de coin à 1 cm des bords
+#define PAGE_WIDTH 2480
+#define PAGE_HEIGHT 3508
+#define MARKER_OFFSET 118
+// écart maximal (en pixels) entre un coin choisi et le centre réel du marqueur
+#define CORRECT_TOLERANCE 3.f
+
+/**
+ * @brief Vérifie et extrait les paramètres propres à corner-solver-bench (voir prepare_micro_bench pour les autres)
+ * @param config Map de configuration contenant les paramètres
+ * @return Tuple contenant le nombre d'ensembles, de doublons et de centres parasites
+ * @throws std::invalid_argument Si un paramètre requis est manquant ou invalide
+ */
+static std::tuple<int, int, int> validate_parameters(const std::unordered_map<std::string, Config>& config) {
+    try {
+        int nb_sets = std::get<int>(config.at("nb-sets").value);
+        int duplicates = std::get<int>(config.at("duplicates").value);
+        int clutter = std::get<int>(config.at("clutter").value);
+
+        if (duplicates < 1 || clutter < 0) {
+            throw std::invalid_argument("duplicates must be at least 1 and clutter must not be negative");
+        }
+
+        return { nb_sets, duplicates, clutter };
+    } catch (const std::out_of_range& e) {
+        throw std::invalid_argument("Missing required parameter in configuration");
+    } catch (const std::bad_variant_access& e) {
+        throw std::invalid_argument("Invalid parameter type in configuration");
+    }
+}
+
+/**
+ * @brief Génère un ensemble de centres bruités
+ *
+ * Les marqueurs de coin subissent une petite similitude (rotation, échelle, translation) ; chacun
+ * produit un centre exact répété et quelques centres décalés d'un ou deux pixels, puis des centres
+ * parasites sont tirés au hasard près de chaque coin de l'image.
+ *
+ * @param true_corner_points Centres réels des marqueurs de coin, indexés par Corner
+ */
+static std::vector<cv::Point2f> generate_candidates(const std::vector<cv::Point2f>& expected_corner_points,
+                                                    int duplicates, int clutter, std::mt19937& gen,
+                                                    std::vector<cv::Point2f>& true_corner_points) {
+    std::uniform_real_distribution<float> rotation_dist(-0.025f, 0.025f);
+    std::uniform_real_distribution<float> scale_dist(0.97f, 1.03f);
+    std::uniform_real_distribution<float> shift_dist(-15.f, 15.f);
+    std::uniform_int_distribution<int> jitter_dist(-2, 2);
+    std::uniform_int_distribution<int> clutter_dist(0, 300);
+
+    const float rotation = rotation_dist(gen), scale = scale_dist(gen);
+    const cv::Point2f shift(shift_dist(gen), shift_dist(gen));
+    const cv::Point2f page_center(PAGE_WIDTH / 2.f, PAGE_HEIGHT / 2.f);
+
+    std::vector<cv::Point2f> candidates;
+    true_corner_points.clear();
+    for (const auto& expected : expected_corner_points) {
+        const cv::Point2f delta = expected - page_center;
+        const cv::Point2f moved(page_center.x + scale * (delta.x * std::cos(rotation) - delta.y * std::sin(rotation)),
+                                page_center.y + scale * (delta.x * std::sin(rotation) + delta.y * std::cos(rotation)));
+        // les centres de detect_shape sont entiers
+        const cv::Point2f center(std::round(moved.x + shift.x), std::round(moved.y + shift.y));
+        true_corner_points.push_back(center);
+
+        for (int i = 0; i < duplicates; ++i) {
+            candidates.push_back(center);
+            if (i % 2 == 1)
+                candidates.push_back(center + cv::Point2f(jitter_dist(gen), jitter_dist(gen)));
+        }
+    }
+
+    for (int i = 0; i < clutter; ++i) {
+        const int dx = clutter_dist(gen), dy = clutter_dist(gen);
+        candidates.emplace_back(dx, dy);
+        candidates.emplace_back(PAGE_WIDTH - dx, dy);
+        candidates.emplace_back(dx, PAGE_HEIGHT - dy);
+        candidates.emplace_back(PAGE_WIDTH - dx, PAGE_HEIGHT - dy);
+    }
+
+    std::shuffle(candidates.begin(), candidates.end(), gen);
+    return candidates;
+}
+
+/**
+ * @brief Indique si tous les coins choisis correspondent aux centres réels des marqueurs
+ */
+static bool is_correct(const std::vector<cv::Point2f>& corner_points, int flag,
+                       const std::vector<cv::Point2f>& true_corner_points) {
+    if (flag == 0)
+        return false;
+    for (int corner = 0; corner < 4; ++corner) {
+        if (((1 << corner) & flag) && cv::norm(corner_points[corner] - true_corner_points[corner]) > CORRECT_TOLERANCE)
+            return false;
+    }
+    return true;
+}
+
+void corner_solver_bench(const std::unordered_map<std::string, Config>& config) {
+    auto [nb_sets, duplicates, clutter] = validate_parameters(config);
+    MicroBenchSetup setup = prepare_micro_bench(config, false);
+    const int iterations = setup.iterations;
+
+    Csv<int, int, int, double, double, double, int, int, int> benchmark_csv(
+        setup.csv_path,
+        { "Set", "Candidates", "Iterations", "Exhaustive_Time_ms", "Pruned_Time_ms", "Speedup", "Same_Corners",
+          "Exhaustive_Correct", "Pruned_Correct" },
+        setup.csv_mode);
+
+    std::mt19937 gen = micro_bench_generator(setup.master_seed);
+
+    const cv::Size img_size(PAGE_WIDTH, PAGE_HEIGHT);
+    const std::vector<cv::Point2f> expected_corner_points = {
+        { MARKER_OFFSET, MARKER_OFFSET },
+        { PAGE_WIDTH - MARKER_OFFSET, MARKER_OFFSET },
+        { MARKER_OFFSET, PAGE_HEIGHT - MARKER_OFFSET },
+        { PAGE_WIDTH - MARKER_OFFSET, PAGE_HEIGHT - MARKER_OFFSET },
+    };
+
+    int nb_mismatches = 0, nb_exhaustive_correct = 0, nb_pruned_correct = 0;
+    double total_exhaustive_ms = 0, total_pruned_ms = 0;
+    std::vector<cv::Point2f> true_corner_points;
+    for (int set = 1; set <= nb_sets; ++set) {
+        auto candidates = generate_candidates(expected_corner_points, duplicates, clutter, gen, true_corner_points);
+
+        int exhaustive_flag = 0, pruned_flag = 0;
+        auto exhaustive_points = find_closest_point_corner_exhaustive(candidates, img_size, exhaustive_flag);
+        auto pruned_points = find_closest_point_corner(candidates, img_size, expected_corner_points, pruned_flag);
+        const bool same_corners = exhaustive_flag == pruned_flag && exhaustive_points == pruned_points;
+        if (!same_corners)
+            nb_mismatches += 1;
+        const bool exhaustive_correct = is_correct(exhaustive_points, exhaustive_flag, true_corner_points);
+        const bool pruned_correct = is_correct(pruned_points, pruned_flag, true_corner_points);
+
+        std::cout << "Set " << set << "/" << nb_sets << " (" << candidates.size() << " candidates, " << iterations
+                  << " iterations):" << std::endl;
+        double exhaustive_ms = Benchmark::measure("  Exhaustive search", [&]() {
+            for (int i = 0; i < iterations; ++i) {
+                int flag = 0;
+                find_closest_point_corner_exhaustive(candidates, img_size, flag);
+            }
+        });
+        double pruned_ms = Benchmark::measure("  Pruned search", [&]() {
+            for (int i = 0; i < iterations; ++i) {
+                int flag = 0;
+                find_closest_point_corner(candidates, img_size, expected_corner_points, flag);
+            }
+        });
+        exhaustive_ms /= iterations;
+        pruned_ms /= iterations;
+        total_exhaustive_ms += exhaustive_ms;
+        total_pruned_ms += pruned_ms;
+        nb_exhaustive_correct += exhaustive_correct ? 1 : 0;
+        nb_pruned_correct += pruned_correct ? 1 : 0;
+
+        double speedup = pruned_ms > 0 ? exhaustive_ms / pruned_ms : 0;
+        std::cout << "  Per search: " << std::fixed << std::setprecision(4) << exhaustive_ms << " ms -> " << pruned_ms
+                  << " ms (x" << std::setprecision(1) << speedup << "), same corners: " << (same_corners ? "yes" : "no")
+                  << ", correct: " << (exhaustive_correct ? "yes" : "no") << " / " << (pruned_correct ? "yes" : "no")
+                  << std::endl;
+
+        benchmark_csv.add_row({ set, (int) candidates.size(), iterations, exhaustive_ms, pruned_ms, speedup,
+                                same_corners ? 1 : 0, exhaustive_correct ? 1 : 0, pruned_correct ? 1 : 0 });
+    }
+
+    // vitesse moyenne sur ces ensembles bruités (--duplicates, --clutter) et justesse de chaque recherche
+    if (nb_sets > 0) {
+        std::cout << "Average per search (" << duplicates << " duplicates, " << clutter << " clutter): " << std::fixed
+                  << std::setprecision(4) << total_exhaustive_ms / nb_sets << " ms -> " << total_pruned_ms / nb_sets
+                  << " ms (x" << std::setprecision(1)
+                  << (total_pruned_ms > 0 ? total_exhaustive_ms / total_pruned_ms : 0) << "), correct corners: "
+                  << nb_exhaustive_correct << "/" << nb_sets << " exhaustive, " << nb_pruned_correct << "/" << nb_sets
+                  << " pruned" << std::endl;
+    }
+    std::cout << "corner-solver-bench completed with " << nb_sets << " sets, " << nb_mismatches
+              << " with different corners." << std::endl;
+}
@@ -0,0 +1,32 @@
+#ifndef CORNER_SOLVER_BENCH_H
+#define CORNER_SOLVER_BENCH_H
+
+/**
+ * @file corner_solver_bench.h
+ * @brief Micro-benchmark du choix des coins du parseur CENTER_PARSER.
+ *
+ * Compare la recherche exhaustive des triplets de coins (find_closest_point_corner_exhaustive)
+ * et la recherche élaguée (find_closest_point_corner) sur des ensembles de centres bruités :
+ * chaque marqueur apparaît plusieurs fois (contours imbriqués) et des centres parasites sont
+ * ajoutés près de chaque coin, comme sur une copie numérisée de mauvaise qualité.
+ */
+
+#include <unordered_map>
+#include <string>
+#include <common.h>
+
+/**
+ * @brief Exécute le micro-benchmark du choix des coins
+ *
+ * @param config Une map non ordonnée contenant les paramètres de configuration incluant:
+ *               - nb-sets: Nombre d'ensembles de centres générés
+ *               - duplicates: Nombre de centres produits par chaque marqueur
+ *               - clutter: Nombre de centres parasites près de chaque coin
+ *               - iterations: Nombre de recherches mesurées par ensemble et par implémentation
+ *               - seed: Graine pour le générateur de nombres aléatoires
+ *               - csv-mode: Mode d'ajout ou d'écrasement pour la sortie CSV
+ *               - csv-filename: Nom du fichier CSV de sortie
+ */
+void corner_solver_bench(const std::unordered_map<std::string, Config>& config);
+
+#endif // CORNER_SOLVER_BENCH_H
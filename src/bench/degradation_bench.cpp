@@ -0,0 +1,81 @@
+#include <iostream>
+#include <unordered_map>
+#include <variant>
+#include <random>
+
+#include <common.h>
+
+#include "external-tools/modifier.h"
+#include "utils/cli_helper.h"
+#include "utils/benchmark_helper.h"
+#include "degradation_bench.h"
+
+using DegradationFunc = void (*)(cv::Mat&, cv::Mat&, int, uint64_t);
+
+/**
+ * @brief Mesure le temps moyen de dégradation d'une copie
+ *
+ * Chaque itération dégrade une copie neuve de l'image, l'itération servant d'indice de copie pour
+ * les flux aléatoires ; la copie de l'image n'est pas comptée dans le temps mesuré.
+ *
+ * @param seed Graine maîtresse, identique pour les deux implémentations
+ * @param first_matrix Matrice de modification retournée par la première itération
+ * @return double Temps moyen par copie en millisecondes
+ */
+static double measure_sheet(const std::string& name, const cv::Mat& img, DegradationFunc degrade, int iterations,
+                            int seed, cv::Mat& first_matrix) {
+    std::vector<cv::Mat> images(iterations);
+    for (auto& image : images) {
+        image = img.clone();
+    }
+
+    std::vector<cv::Mat> matrices(iterations);
+    double total_ms = Benchmark::measure("  " + name, [&]() {
+        for (int i = 0; i < iterations; ++i) {
+            degrade(images[i], matrices[i], seed, i);
+        }
+    });
+    first_matrix = matrices.front();
+    return total_ms / iterations;
+}
+
+void degradation_bench(const std::unordered_map<std::string, Config>& config) {
+    MicroBenchSetup setup = prepare_micro_bench(config, true);
+    const int nb_copies = setup.nb_copies, iterations = setup.iterations;
+
+    Csv<std::string, int, double, double, double, int> benchmark_csv(
+        setup.csv_path, { "File", "Iterations", "Sequential_Time_ms", "Fused_Time_ms", "Speedup", "Same_Matrix" },
+        setup.csv_mode);
+
+    std::mt19937 master_gen = micro_bench_generator(setup.master_seed);
+
+    for (int i = 1; i <= nb_copies; i++) {
+        std::string copy_name = "degradation-copy-" + std::to_string(i);
+        std::cout << "Generating copy " << i << "/" << nb_copies << "..." << std::endl;
+        cv::Mat img = generate_micro_bench_copy(setup, master_gen, copy_name);
+        if (img.empty())
+            continue;
+
+        std::string filename = copy_name + ".png";
+
+        // une graine nulle ferait tirer l'heure courante : elle est remplacée pour garder les mêmes tirages
+        int seed = (int) master_gen();
+        if (seed == 0)
+            seed = 1;
+
+        std::cout << "Degradation of " << filename << " (" << iterations << " iterations):" << std::endl;
+        cv::Mat sequential_matrix, fused_matrix;
+        double sequential_ms =
+            measure_sheet("Sequential", img, random_exec_sequential, iterations, seed, sequential_matrix);
+        double fused_ms = measure_sheet("Fused", img, random_exec, iterations, seed, fused_matrix);
+
+        const bool same_matrix = cv::norm(sequential_matrix, fused_matrix, cv::NORM_INF) == 0;
+        double speedup = fused_ms > 0 ? sequential_ms / fused_ms : 0;
+        std::cout << "  Per sheet: " << std::fixed << std::setprecision(3) << sequential_ms << " ms -> " << fused_ms
+                  << " ms (x" << speedup << "), same matrix: " << (same_matrix ? "yes" : "no") << std::endl;
+
+        benchmark_csv.add_row({ filename, iterations, sequential_ms, fused_ms, speedup, same_matrix ? 1 : 0 });
+    }
+
+    std::cout << "degradation-bench completed with " << nb_copies << " copies." << std::endl;
+}
@@ -0,0 +1,34 @@
+#ifndef DEGRADATION_BENCH_H
+#define DEGRADATION_BENCH_H
+
+/**
+ * @file degradation_bench.h
+ * @brief Micro-benchmark de la dégradation aléatoire des copies.
+ *
+ * Compare, sur les mêmes copies et avec les mêmes graines, le temps de dégradation par copie
+ * entre random_exec_sequential, qui applique chaque effet l'un après l'autre sur l'image entière,
+ * et random_exec, qui compose les transformations géométriques en un seul warpAffine et fusionne
+ * les opérations par pixel en un seul parcours parallèle. Vérifie aussi que les deux versions
+ * retournent la même matrice de modification.
+ */
+
+#include <unordered_map>
+#include <string>
+#include <common.h>
+
+/**
+ * @brief Exécute le micro-benchmark de dégradation
+ *
+ * @param config Une map non ordonnée contenant les paramètres de configuration incluant:
+ *               - nb-copies: Nombre de copies à générer
+ *               - iterations: Nombre de dégradations mesurées par copie et par implémentation
+ *               - marker-config: Chaîne de configuration pour la génération de marqueurs
+ *               - encoded-marker-size, unencoded-marker-size, header-marker-size, grey-level, dpi:
+ *                 Paramètres de génération des copies
+ *               - seed: Graine pour le générateur de nombres aléatoires
+ *               - csv-mode: Mode d'ajout ou d'écrasement pour la sortie CSV
+ *               - csv-filename: Nom du fichier CSV de sortie
+ */
+void degradation_bench(const std::unordered_map<std::string, Config>& config);
+
+#endif // DEGRADATION_BENCH_H
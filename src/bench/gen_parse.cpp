@@ -15,16 +15,26 @@
 #include "utils/benchmark_helper.h"
 #include "utils/json_helper.h"
 #include "utils/parser_helper.h"
+#include "utils/layout_cache.h"
 #include "utils/math_utils.h"
 #include "utils/draw_helper.h"
 #include "gen_parse.h"
 #include <modifier.h>
+#include <degradation_pipeline.h>
 
 struct CopyInfo {
     std::string filename;
     double generation_time;
 };
 
+/**
+ * @brief Réglages appliqués lors d'une passe de parsing sur une copie
+ */
+struct ParsingPass {
+    CircleDetector circle_detector;
+    BarcodeBackend barcode_backend;
+};
+
 /**
  * @brief Vérifie et extrait les paramètres de configuration
  * @param config Map de configuration contenant les paramètres
@@ -100,7 +110,7 @@ validate_parameters(const std::unordered_map<std::string, Config>& config) {
 }
 
 void warmup_copy(int warmup_iterations, const CopyStyleParams& style_params,
-                 const CopyMarkerConfig& copy_marker_config) {
+                 const CopyMarkerConfig& copy_marker_config, std::mt19937& gen) {
     if (warmup_iterations > 0) {
         std::cout << "Performing " << warmup_iterations << " warm-up iterations..." << std::endl;
     } else {
@@ -108,9 +118,6 @@ void warmup_copy(int warmup_iterations, const CopyStyleParams& style_params,
         return;
     }
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-
     for (int i = 0; i < warmup_iterations; i++) {
         std::string warmup_copy_name = "warmup" + std::to_string(i + 1);
 
@@ -129,14 +136,13 @@ std::vector<CopyInfo> bench_copy(int nb_copies, const CopyStyleParams& style_par
                                  const CopyMarkerConfig& copy_marker_config, std::mt19937& master_gen) {
     std::vector<CopyInfo> generated_copies;
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    // le suffixe est tiré de la graine maîtresse : avec --seed, les noms des copies sont reproductibles
     std::uniform_int_distribution<> dist(1000, 9999);
 
     for (int i = 1; i <= nb_copies; i++) {
         std::cout << "Generating copy " << i << "/" << nb_copies << "..." << std::endl;
 
-        int random_suffix = dist(gen);
+        int random_suffix = dist(master_gen);
         std::string copy_name = "copy-" + std::to_string(i) + "-" + std::to_string(random_suffix);
         std::string filename = copy_name + ".png";
 
@@ -160,8 +166,9 @@ std::vector<CopyInfo> bench_copy(int nb_copies, const CopyStyleParams& style_par
     return generated_copies;
 }
 
-void warmup_parsing(int warmup_iterations, const cv::Point2f& src_img_size, ParserType selected_parser,
-                    const CopyMarkerConfig& copy_marker_config) {
+void warmup_parsing(ParserContext& parser_ctx, LayoutCache& layout_cache, int warmup_iterations,
+                    const cv::Point2f& src_img_size, ParserType selected_parser,
+                    const CopyMarkerConfig& copy_marker_config, const std::vector<BarcodeBackend>& barcode_backends) {
     if (warmup_iterations > 0) {
         std::cout << "\nParsing warmup iterations..." << std::endl;
     } else {
@@ -185,17 +192,14 @@ void warmup_parsing(int warmup_iterations, const cv::Point2f& src_img_size, Pars
         }
 
         // Lire les métadonnées spécifiques à cette copie d'échauffement
-        json atomic_boxes_json = parse_json_file(json_path);
-        if (atomic_boxes_json.empty()) {
-            std::cerr << "  Error: Failed to parse metadata for warmup: " << json_path << std::endl;
+        std::shared_ptr<const Layout> layout_ptr;
+        try {
+            layout_ptr = layout_cache.load(json_path);
+        } catch (const std::exception& e) {
+            std::cerr << "  Error: Failed to parse metadata for warmup: " << e.what() << std::endl;
             continue;
         }
-
-        std::vector<std::optional<std::shared_ptr<AtomicBox>>> corner_markers;
-        std::vector<std::vector<std::shared_ptr<AtomicBox>>> user_boxes_per_page;
-
-        auto atomic_boxes = json_to_atomicBox(atomic_boxes_json);
-        differentiate_atomic_boxes(atomic_boxes, corner_markers, user_boxes_per_page);
+        const Layout& layout = *layout_ptr;
 
         cv::Mat img = cv::imread("./copies/" + warmup_filename, cv::IMREAD_GRAYSCALE);
         if (!img.data) {
@@ -204,35 +208,91 @@ void warmup_parsing(int warmup_iterations, const cv::Point2f& src_img_size, Pars
         }
 
         const cv::Point2f dst_img_size(img.cols, img.rows);
-        auto dst_corner_points = calculate_center_of_marker(corner_markers, src_img_size, dst_img_size);
-        Metadata meta = { 0, 1, "" };
+        auto dst_corner_points = calculate_center_of_marker(layout, src_img_size, dst_img_size);
+        set_page_geometry(parser_ctx, layout, src_img_size);
 
-        std::optional<cv::Mat> transform = run_parser(selected_parser, img,
+        // chaque bibliothèque comparée crée son décodeur pendant le préchauffage, pas pendant la mesure
+        for (BarcodeBackend backend : barcode_backends) {
+            parser_ctx.settings.barcode_backend = backend;
+            Metadata meta = { 0, 1, "" };
+
+            std::optional<cv::Mat> transform =
+                run_parser(parser_ctx, selected_parser, img,
 #ifdef DEBUG
-                                                      cv::Mat(),
+                           cv::Mat(),
 #endif
-                                                      meta, dst_corner_points, copy_config_to_flag(copy_marker_config));
+                           meta, dst_corner_points, copy_config_to_flag(copy_marker_config));
 
-        std::cout << "  Warmup parsing " << (i + 1) << "/" << warmup_iterations << " completed with "
-                  << (transform.has_value() ? "success" : "failure") << std::endl;
+            std::cout << "  Warmup parsing " << (i + 1) << "/" << warmup_iterations << " ["
+                      << barcode_backend_to_string(backend) << "] completed with "
+                      << (transform.has_value() ? "success" : "failure") << std::endl;
+        }
     }
 }
 
-void bench_parsing(std::vector<CopyInfo>& generated_copies, const cv::Point2f& src_img_size, ParserType selected_parser,
-                   const CopyMarkerConfig& copy_marker_config,
-                   Csv<std::string, double, double, int, std::string, CopyMarkerConfig, int, double, double, double,
-                       double, double>& benchmark_csv,
-                   std::string output_dir, std::mt19937& master_gen) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+/**
+ * @brief Nom de la méthode de détection des marqueurs utilisée par un parseur avec ces réglages
+ */
+static std::string detector_name(const ParserSettings& settings, ParserType parser_type) {
+    switch (parser_type) {
+        case ParserType::CIRCLE:
+            return circle_detector_to_string(settings.circle_detector);
+        case ParserType::SHAPE:
+        case ParserType::CENTER_PARSER:
+            return settings.shape_detector == ShapeDetector::COMPONENTS ? "components" : "contours";
+        default:
+            return "default";
+    }
+}
 
-    auto add_error_to_csv = [&](const CopyInfo& copy_info, int seed = -1) {
+void bench_parsing(ParserContext& parser_ctx, LayoutCache& layout_cache, std::vector<CopyInfo>& generated_copies,
+                   const cv::Point2f& src_img_size,
+                   ParserType selected_parser, const CopyMarkerConfig& copy_marker_config,
+                   Csv<std::string, double, double, int, std::string, CopyMarkerConfig, int, int, double, double,
+                       double, double, double, int, std::string, std::string>& benchmark_csv,
+                   std::string output_dir, std::mt19937& master_gen,
+                   const std::vector<CircleDetector>& circle_detectors,
+                   const std::vector<BarcodeBackend>& barcode_backends, const DegradationPipeline& degradation,
+                   bool sequential_degradation) {
+    // chaque copie modifiée est analysée une fois par méthode de détection des cercles (parseur CIRCLE)
+    // et par bibliothèque de décodage des codes-barres
+    const std::vector<CircleDetector> detectors =
+        selected_parser == ParserType::CIRCLE ? circle_detectors
+                                              : std::vector<CircleDetector>{ parser_ctx.settings.circle_detector };
+    std::vector<ParsingPass> passes;
+    for (CircleDetector detector : detectors) {
+        for (BarcodeBackend backend : barcode_backends)
+            passes.push_back({ detector, backend });
+    }
+    std::vector<double> total_parsing_ms(passes.size(), 0);
+    std::vector<int> nb_success(passes.size(), 0);
+    int nb_parsed = 0;
+
+    auto pass_name = [&](const ParsingPass& pass) {
+        std::string name;
+        if (detectors.size() > 1)
+            name = circle_detector_to_string(pass.circle_detector);
+        if (barcode_backends.size() > 1)
+            name += (name.empty() ? "" : "-") + barcode_backend_to_string(pass.barcode_backend);
+        return name;
+    };
+
+    auto add_error_to_csv = [&](const CopyInfo& copy_info, size_t sheet, int seed = -1) {
         benchmark_csv.add_row({ copy_info.filename, copy_info.generation_time, 0, 0,
-                                parser_type_to_string(selected_parser), copy_marker_config, seed, 
-                                std::nan(""), std::nan(""), std::nan(""), std::nan(""), std::nan("") });
+                                parser_type_to_string(selected_parser), copy_marker_config, seed, (int) sheet,
+                                std::nan(""), std::nan(""), std::nan(""), std::nan(""), std::nan(""), 0,
+                                detector_name(parser_ctx.settings, selected_parser),
+                                barcode_backend_to_string(parser_ctx.settings.barcode_backend) });
     };
 
-    for (const auto& copy_info : generated_copies) {
+    // graine maîtresse des dégradations : chaque copie est dégradée dans ses propres flux (graine, indice de
+    // la copie), indépendamment de l'ordre de traitement ; 0 ferait tirer l'heure courante
+    int degradation_seed = master_gen();
+    if (degradation_seed == 0)
+        degradation_seed = 1;
+
+    for (size_t sheet = 0; sheet < generated_copies.size(); ++sheet) {
+        const CopyInfo& copy_info = generated_copies[sheet];
         std::cout << "Parsing copy: " << copy_info.filename << "..." << std::endl;
 
         std::string filename_without_ext = copy_info.filename.substr(0, copy_info.filename.find_last_of('.'));
@@ -241,104 +301,135 @@ void bench_parsing(std::vector<CopyInfo>& generated_copies, const cv::Point2f& s
 
         if (!std::filesystem::exists(json_path)) {
             std::cerr << "  Error: Metadata file not found: " << json_path << std::endl;
-            add_error_to_csv(copy_info);
+            add_error_to_csv(copy_info, sheet);
             continue;
         }
 
-        json atomic_boxes_json = parse_json_file(json_path);
-        if (atomic_boxes_json.empty()) {
-            std::cerr << "  Error: Failed to parse metadata from: " << json_path << std::endl;
-            add_error_to_csv(copy_info);
+        std::shared_ptr<const Layout> layout_ptr;
+        try {
+            layout_ptr = layout_cache.load(json_path);
+        } catch (const std::exception& e) {
+            std::cerr << "  Error: Failed to parse metadata: " << e.what() << std::endl;
+            add_error_to_csv(copy_info, sheet);
             continue;
         }
-
-        std::vector<std::optional<std::shared_ptr<AtomicBox>>> corner_markers;
-        std::vector<std::vector<std::shared_ptr<AtomicBox>>> user_boxes_per_page;
-
-        auto atomic_boxes = json_to_atomicBox(atomic_boxes_json);
-        differentiate_atomic_boxes(atomic_boxes, corner_markers, user_boxes_per_page);
+        const Layout& layout = *layout_ptr;
 
         cv::Mat img = cv::imread("./copies/" + copy_info.filename, cv::IMREAD_GRAYSCALE);
         if (!img.data) {
             std::cerr << "Error: Could not read generated image: " << copy_info.filename << std::endl;
-            add_error_to_csv(copy_info);
+            add_error_to_csv(copy_info, sheet);
             continue;
         }
 
         const cv::Point2f original_img_size(img.cols, img.rows);
 
         cv::Mat mat;
-        int unique_seed = master_gen();
-        random_exec(img, mat, unique_seed);
+        // même chaîne et même marge, appliquées effet par effet sur l'image entière
+        if (sequential_degradation)
+            random_exec_sequential(img, mat, degradation_seed, sheet);
+        else
+            degradation.run(img, mat, degradation_seed, sheet);
 
         std::string modified_filename = "./copies/" + copy_info.filename;
         cv::imwrite(modified_filename, img);
         std::cout << "  Saved modified image: " << modified_filename << std::endl;
 
+        nb_parsed += 1;
+        for (size_t pass = 0; pass < passes.size(); ++pass) {
+            parser_ctx.settings.circle_detector = passes[pass].circle_detector;
+            parser_ctx.settings.barcode_backend = passes[pass].barcode_backend;
+            const std::string detector = detector_name(parser_ctx.settings, selected_parser);
+            const std::string name = pass_name(passes[pass]);
+            const std::string pass_suffix = passes.size() > 1 ? " [" + name + "]" : "";
+
 #ifdef DEBUG
-        cv::Mat debug_img;
-        cv::cvtColor(img, debug_img, cv::COLOR_GRAY2BGR);
+            cv::Mat debug_img;
+            cv::cvtColor(img, debug_img, cv::COLOR_GRAY2BGR);
 #endif
 
-        const cv::Point2f dst_img_size(img.cols, img.rows);
-        auto dst_corner_points = calculate_center_of_marker(corner_markers, src_img_size, dst_img_size);
-        Metadata meta = { 0, 1, "" };
+            const cv::Point2f dst_img_size(img.cols, img.rows);
+            auto dst_corner_points = calculate_center_of_marker(layout, src_img_size, dst_img_size);
+            // taille réelle du marqueur sur la copie, pour le rendu du modèle du parseur CUSTOM
+            set_page_geometry(parser_ctx, layout, src_img_size);
+            Metadata meta = { 0, 1, "" };
 
-        std::optional<cv::Mat> affine_transform;
+            std::optional<cv::Mat> affine_transform;
+            const int fallbacks_before = parser_ctx.barcode_fallbacks;
 
-        auto parse_lambda = [&]() {
-            affine_transform = run_parser(selected_parser, img,
+            auto parse_lambda = [&]() {
+                affine_transform = run_parser(parser_ctx, selected_parser, img,
 #ifdef DEBUG
-                                          debug_img,
+                                              debug_img,
 #endif
-                                          meta, dst_corner_points, copy_config_to_flag(copy_marker_config));
-        };
-
-        double parsing_milliseconds = Benchmark::measure("  Parsing time", parse_lambda);
-
-        bool parsing_success = affine_transform.has_value();
-        parsing_success = parsing_success && meta.id == 0;
-        parsing_success = parsing_success && meta.page > 0;
-        std::cout << "  Success: " << (parsing_success ? "Yes" : "No") << std::endl;
-
-        std::filesystem::path output_img_path_fname = std::filesystem::path(copy_info.filename);
+                                              meta, dst_corner_points, copy_config_to_flag(copy_marker_config));
+            };
+
+            double parsing_milliseconds = Benchmark::measure("  Parsing time" + pass_suffix, parse_lambda);
+            total_parsing_ms[pass] += parsing_milliseconds;
+            const int barcode_fallbacks = parser_ctx.barcode_fallbacks - fallbacks_before;
+
+            bool parsing_success = affine_transform.has_value();
+            parsing_success = parsing_success && meta.id == 0;
+            parsing_success = parsing_success && meta.page > 0;
+            std::cout << "  Success: " << (parsing_success ? "Yes" : "No") << std::endl;
+            nb_success[pass] += parsing_success ? 1 : 0;
+
+            std::filesystem::path output_img_path_fname = std::filesystem::path(copy_info.filename);
+            if (passes.size() > 1) {
+                output_img_path_fname = output_img_path_fname.stem().string() + "-" + name +
+                                        output_img_path_fname.extension().string();
+            }
 
 #ifdef DEBUG
-        save_debug_img(debug_img, output_dir, output_img_path_fname);
+            save_debug_img(debug_img, output_dir, output_img_path_fname);
 #endif
 
-        std::vector<double> precision_errors = { 
-            std::nan(""), std::nan(""), std::nan(""), std::nan(""), std::nan("")
-        };
-        if (parsing_success) {
-            auto calibrated_img_col = redress_image(img, affine_transform.value());
-
-            precision_errors =
-                calculate_precision_error(dst_img_size, mat, affine_transform.value(), MARGIN_COPY_MODIFIED);
-            std::cout << "  Precision error: " << std::fixed << std::setprecision(3) << precision_errors.back()
-                      << " pixels" << std::endl;
-
-            for (auto box : user_boxes_per_page[meta.page - 1]) {
-                draw_box_outline(box, calibrated_img_col, src_img_size, dst_img_size, cv::Scalar(255, 0, 255));
-            }
+            std::vector<double> precision_errors = { 
+                std::nan(""), std::nan(""), std::nan(""), std::nan(""), std::nan("")
+            };
+            if (parsing_success) {
+                auto calibrated_img_col = redress_image(img, affine_transform.value());
+
+                precision_errors =
+                    calculate_precision_error(dst_img_size, mat, affine_transform.value(), degradation.margin());
+                std::cout << "  Precision error: " << std::fixed << std::setprecision(3) << precision_errors.back()
+                          << " pixels" << std::endl;
+
+                const PageBoxes& page_boxes = layout.pages[meta.page - 1];
+                for (size_t i = 0; i < page_boxes.size(); ++i) {
+                    draw_box_outline(page_boxes.rect(i), calibrated_img_col, src_img_size, dst_img_size,
+                                     cv::Scalar(255, 0, 255));
+                }
 
-            for (auto box : corner_markers) {
-                if (!box.has_value()) {
-                    continue;
+                for (const auto& marker : layout.corners) {
+                    if (!marker.has_value()) {
+                        continue;
+                    }
+                    draw_box_outline(*marker, calibrated_img_col, src_img_size, dst_img_size, cv::Scalar(255, 0, 0));
+                    draw_box_center(*marker, calibrated_img_col, src_img_size, dst_img_size, cv::Scalar(0, 255, 0));
                 }
-                auto marker = box.value();
-                draw_box_outline(marker, calibrated_img_col, src_img_size, dst_img_size, cv::Scalar(255, 0, 0));
-                draw_box_center(marker, calibrated_img_col, src_img_size, dst_img_size, cv::Scalar(0, 255, 0));
+
+                save_image(calibrated_img_col, output_dir, output_img_path_fname);
             }
 
-            save_image(calibrated_img_col, output_dir, output_img_path_fname);
+            // Écrire les résultats dans le CSV
+            benchmark_csv.add_row({ copy_info.filename, copy_info.generation_time, parsing_milliseconds,
+                                    parsing_success ? 1 : 0, parser_type_to_string(selected_parser),
+                                    copy_marker_config, degradation_seed, (int) sheet, precision_errors.back(),
+                                    precision_errors[0], precision_errors[1], precision_errors[2], precision_errors[3],
+                                    barcode_fallbacks,
+                                    detector, barcode_backend_to_string(passes[pass].barcode_backend) });
         }
+    }
 
-        // Écrire les résultats dans le CSV
-        benchmark_csv.add_row({ copy_info.filename, copy_info.generation_time, parsing_milliseconds,
-                                parsing_success ? 1 : 0, parser_type_to_string(selected_parser), copy_marker_config,
-                                unique_seed, precision_errors.back(), precision_errors[0], precision_errors[1],
-                                precision_errors[2], precision_errors[3] });
+    if (passes.size() > 1 && nb_parsed > 0) {
+        std::cout << "Average parsing time and success per pass:" << std::endl;
+        for (size_t pass = 0; pass < passes.size(); ++pass) {
+            std::cout << "  " << pass_name(passes[pass]) << ": " << std::fixed << std::setprecision(3)
+                      << total_parsing_ms[pass] / nb_parsed << " ms, " << nb_success[pass] << "/" << nb_parsed
+                      << " parsed" << std::endl;
+        }
     }
 }
 
@@ -346,20 +437,76 @@ void gen_parse(const std::unordered_map<std::string, Config>& config) {
     auto [warmup_iterations, nb_copies, style_params, copy_marker_config, selected_parser, master_seed, csv_mode,
           csv_filename] = validate_parameters(config);
 
+    // réglages du contexte du parseur ; les méthodes comparées sont changées entre deux passes
+    ParserSettings parser_settings = parser_settings_from_config(config);
+    if (config.find("shape-detector") != config.end()) {
+        auto detector_name = std::get<std::string>(config.at("shape-detector").value);
+        auto detector = string_to_shape_detector(detector_name);
+        if (!detector.has_value()) {
+            throw std::invalid_argument("Unknown shape detector: " + detector_name);
+        }
+        parser_settings.shape_detector = detector.value();
+    }
+    std::vector<CircleDetector> circle_detectors = { parser_settings.circle_detector };
+    if (config.find("circle-detector") != config.end()) {
+        auto detector_name = std::get<std::string>(config.at("circle-detector").value);
+        if (detector_name == "both") {
+            circle_detectors = { CircleDetector::HOUGH, CircleDetector::BLOBS };
+        } else {
+            auto detector = string_to_circle_detector(detector_name);
+            if (!detector.has_value()) {
+                throw std::invalid_argument("Unknown circle detector: " + detector_name);
+            }
+            circle_detectors = { detector.value() };
+        }
+        parser_settings.circle_detector = circle_detectors.front();
+    }
+    std::vector<BarcodeBackend> barcode_backends = { parser_settings.barcode_backend };
+    if (config.find("barcode-backend") != config.end()) {
+        auto backend_name = std::get<std::string>(config.at("barcode-backend").value);
+        if (backend_name == "all") {
+            barcode_backends = available_barcode_backends();
+        } else {
+            auto backend = string_to_barcode_backend(backend_name);
+            if (!backend.has_value() || !barcode_backend_available(backend.value())) {
+                throw std::invalid_argument("Unknown or unavailable barcode backend: " + backend_name);
+            }
+            barcode_backends = { backend.value() };
+        }
+        parser_settings.barcode_backend = barcode_backends.front();
+    }
+
+    // sans description, les copies sont dégradées comme par random_exec
+    DegradationPipeline degradation = default_degradation_pipeline();
+    if (config.find("degradation-spec") != config.end()) {
+        auto spec_path = std::get<std::string>(config.at("degradation-spec").value);
+        if (!spec_path.empty()) {
+            degradation = DegradationPipeline::load(spec_path);
+            std::cout << "Degradation pipeline: " << degradation.describe() << std::endl;
+        }
+    }
+    const bool sequential_degradation = config.find("sequential-degradation") != config.end() &&
+                                        std::get<int>(config.at("sequential-degradation").value) != 0;
+    if (sequential_degradation) {
+        if (config.find("degradation-spec") != config.end() &&
+            !std::get<std::string>(config.at("degradation-spec").value).empty())
+            throw std::invalid_argument("--sequential-degradation only applies to the built-in degradation chain");
+        std::cout << "Degradation: random_exec_sequential (one pass per effect)" << std::endl;
+    }
+
     BenchmarkSetup benchmark_setup = prepare_benchmark_directories("./output", true, true, csv_mode);
 
-    Csv<std::string, double, double, int, std::string, CopyMarkerConfig, int, double, double, double, double, double>
+    Csv<std::string, double, double, int, std::string, CopyMarkerConfig, int, int, double, double, double, double,
+        double, int, std::string, std::string>
         benchmark_csv(benchmark_setup.csv_output_dir / csv_filename,
                       { "File", "Generation_Time_ms", "Parsing_Time_ms", "Parsing_Success", "Parser_Type",
-                        "Copy_Config", "Seed", "Precision_Error_Avg_px", "Precision_Error_TopLeft_px",
+                        "Copy_Config", "Seed", "Sheet", "Precision_Error_Avg_px", "Precision_Error_TopLeft_px",
                         "Precision_Error_TopRight_px", "Precision_Error_BottomLeft_px",
-                        "Precision_Error_BottomRight_px" },
+                        "Precision_Error_BottomRight_px", "Barcode_Fallbacks", "Detector", "Barcode_Backend" },
                       csv_mode);
 
     std::cout << "ÉTAPE 1: Génération des copies..." << std::endl;
 
-    warmup_copy(warmup_iterations, style_params, copy_marker_config);
-
     std::mt19937 master_gen;
     if (master_seed != 0) {
         std::cout << "Using master seed: " << master_seed << std::endl;
@@ -370,6 +517,10 @@ void gen_parse(const std::unordered_map<std::string, Config>& config) {
         std::cout << "No master seed provided, using random initialization" << std::endl;
     }
 
+    // un seul tirage pour le préchauffage : les copies mesurées ne dépendent pas du nombre d'itérations
+    std::mt19937 warmup_gen(master_gen());
+    warmup_copy(warmup_iterations, style_params, copy_marker_config, warmup_gen);
+
     auto generated_copies = bench_copy(nb_copies, style_params, copy_marker_config, master_gen);
 
     if (generated_copies.empty()) {
@@ -378,13 +529,24 @@ void gen_parse(const std::unordered_map<std::string, Config>& config) {
 
     const cv::Point2f src_img_size{ 210, 297 };
 
-    warmup_parsing(warmup_iterations, src_img_size, selected_parser, copy_marker_config);
+    // créé une seule fois : le préchauffage dimensionne aussi les tampons réutilisés pendant la mesure
+    ParserContext parser_ctx;
+    parser_ctx.settings = parser_settings;
+    parser_ctx.template_dir = "./copies/templates";
+    // les copies d'un même examen partagent la même description des zones : compilée une seule fois
+    LayoutCache layout_cache(config.find("layout-sidecar") != config.end() &&
+                             std::get<int>(config.at("layout-sidecar").value) != 0);
+    warmup_parsing(parser_ctx, layout_cache, warmup_iterations, src_img_size, selected_parser, copy_marker_config,
+                   barcode_backends);
 
     std::cout << "\nÉTAPE 2: Parsing des copies générées..." << std::endl;
 
-    bench_parsing(generated_copies, src_img_size, selected_parser, copy_marker_config, benchmark_csv,
-                  benchmark_setup.output_dir, master_gen);
+    bench_parsing(parser_ctx, layout_cache, generated_copies, src_img_size, selected_parser, copy_marker_config,
+                  benchmark_csv, benchmark_setup.output_dir, master_gen, circle_detectors, barcode_backends,
+                  degradation, sequential_degradation);
 
+    std::cout << "Layout cache: " << layout_cache.size() << " distinct layout(s), " << layout_cache.hits()
+              << " reused, " << layout_cache.sidecar_loads() << " loaded from sidecar" << std::endl;
     std::cout << "gen-parse benchmark completed with " << warmup_iterations << " warmup iterations and " << nb_copies
               << " copies." << std::endl;
 }
\ No newline at end of file
@@ -4,12 +4,15 @@
 #include <cmath>
 #include <common.h>
 #include "external-tools/modifier.h"
+#include "external-tools/degradation_pipeline.h"
 #include <cli_helper.h>
 #include <parser_helper.h>
 #include <csv_utils.h>
 #include <benchmark_helper.h>
 #include <math_utils.h>
+#include <random_stream.h>
 #include <json_helper.h>
+#include <layout_cache.h>
 #include <draw_helper.h>
 
 #include "limite_bench.h"
@@ -34,14 +37,29 @@ std::string param_to_string(param_t param) {
     return "";
 }
 
+/**
+ * @brief Scénario de limite-bench : un paramètre balayé de start à end
+ *
+ * Le paramètre modifie soit le style de la copie générée (style), soit la chaîne de dégradation qui lui est
+ * appliquée (degradation, voir degradation_pipeline.h) ; les champs inutilisés valent nullptr.
+ */
 struct option {
     param_t start;
     param_t end;
     param_t (*step)(param_t current, param_t start, param_t end, bool& stop);
-    void (*tranformer)(cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                       CopyMarkerConfig marker_config, std::string copy_name, int& margin_size);
+    /// Reporte le paramètre sur le style de la copie générée
+    void (*style)(CopyStyleParams& style, param_t param);
+    /// Chaîne de dégradation du paramètre, pour une copie générée de taille img_size
+    json (*degradation)(param_t param, const cv::Size& img_size);
 };
 
+/**
+ * @brief Chaîne réduite à une opération, sans marge
+ */
+static json single_op(const json& op) {
+    return { { "ops", json::array({ op }) } };
+}
+
 std::vector<std::pair<std::string, option>> all_config = {
     { "simulate_printer_effects",
       option{ 0.0f, 100.0f,
@@ -52,15 +70,9 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::get<float>(current) + 10.0f };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  simulate_printer_effects(img, rng, std::get<float>(param));
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
+              nullptr,
+              [](param_t param, const cv::Size&) {
+                  return single_op({ { "op", "printer_effects" }, { "intensity", std::get<float>(param) } });
               } } },
     { "add_salt_pepper_noise",
       option{ 0.0f, 0.3f,
@@ -71,15 +83,10 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::get<float>(current) + 0.01f };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  add_salt_pepper_noise(img, rng, std::get<float>(param), std::get<float>(param));
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
+              nullptr,
+              [](param_t param, const cv::Size&) {
+                  const float amount = std::get<float>(param);
+                  return single_op({ { "op", "salt_pepper" }, { "salt", amount }, { "pepper", amount } });
               } } },
     { "add_gaussian_noise",
       option{ std::tuple{ 0.0f, 0.0f }, std::tuple{ 100.0f, 100.0f },
@@ -97,16 +104,10 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::make_tuple(dispersion, offset) };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  add_gaussian_noise(img, rng, std::get<0>(std::get<std::tuple<float, float>>(param)),
-                                     std::get<1>(std::get<std::tuple<float, float>>(param)));
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
+              nullptr,
+              [](param_t param, const cv::Size&) {
+                  auto [dispersion, offset] = std::get<std::tuple<float, float>>(param);
+                  return single_op({ { "op", "gaussian_noise" }, { "dispersion", dispersion }, { "offset", offset } });
               } } },
     { "contrast_brightness_modifier",
       option{ std::tuple{ -100, -100 }, std::tuple{ 100, 100 },
@@ -124,16 +125,10 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::make_tuple(contrast, bright) };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  contrast_brightness_modifier(img, std::get<0>(std::get<std::tuple<int, int>>(param)),
-                                               std::get<1>(std::get<std::tuple<int, int>>(param)));
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
+              nullptr,
+              [](param_t param, const cv::Size&) {
+                  auto [contrast, bright] = std::get<std::tuple<int, int>>(param);
+                  return single_op({ { "op", "contrast_brightness" }, { "contrast", contrast }, { "bright", bright } });
               } } },
     { "add_ink_stain",
       option{ std::tuple{ 1, MIN_RMIN, MIN_RMAX }, std::tuple{ MAX_NB_SPOT, MAX_RMIN, MAX_RMAX },
@@ -155,17 +150,13 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::make_tuple(nombreTaches, rayonMin, rayonMax) };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  add_ink_stain(img, rng, std::get<0>(std::get<std::tuple<int, int, int>>(param)),
-                                std::get<1>(std::get<std::tuple<int, int, int>>(param)),
-                                std::get<2>(std::get<std::tuple<int, int, int>>(param)));
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
+              nullptr,
+              [](param_t param, const cv::Size&) {
+                  auto [count, radius_min, radius_max] = std::get<std::tuple<int, int, int>>(param);
+                  return single_op({ { "op", "ink_stain" },
+                                     { "count", count },
+                                     { "radius_min", radius_min },
+                                     { "radius_max", radius_max } });
               } } },
     { "rotate_img",
       option{ -360.0f, 360.0f,
@@ -176,22 +167,13 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::get<float>(current) + 15.0f };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  margin_size = std::max(img.cols, img.rows) - std::min(img.cols, img.rows);
-                  margin_size /= 2;
-                  int height = img.rows;
-                  int width = img.cols;
-                  cv::copyMakeBorder(img, img, margin_size, margin_size, margin_size, margin_size, cv::BORDER_CONSTANT,
-                                     cv::Scalar(255, 255, 255));
-                  affine_transformation = rotate_center(std::get<float>(param), width / 2.0f, height / 2.0f);
-                  affine_transformation = affine_transformation(cv::Rect(0, 0, 3, 2));
-                  rotate_img(img, std::get<float>(param));
+              nullptr,
+              [](param_t param, const cv::Size& img_size) {
+                  // marge pour que la page tournée reste dans l'image agrandie
+                  const int margin =
+                      (std::max(img_size.width, img_size.height) - std::min(img_size.width, img_size.height)) / 2;
+                  const json op = { { "op", "rotate" }, { "angle", std::get<float>(param) } };
+                  return json{ { "margin", margin }, { "ops", json::array({ op }) } };
               } } },
     { "translate_img",
       option{ std::tuple{ -100, -100 }, std::tuple{ 100, 100 },
@@ -209,21 +191,11 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::make_tuple(dx, dy) };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
+              nullptr,
+              [](param_t param, const cv::Size&) {
                   auto [dx, dy] = std::get<std::tuple<int, int>>(param);
-                  margin_size = std::max(std::abs(dx), std::abs(dy));
-                  int height = img.rows;
-                  int width = img.cols;
-                  cv::copyMakeBorder(img, img, margin_size, margin_size, margin_size, margin_size, cv::BORDER_CONSTANT,
-                                     cv::Scalar(255, 255, 255));
-                  affine_transformation = (cv::Mat_<float>(2, 3) << 1, 0, dx, 0, 1, dy);
-                  translate_img(img, dx, dy);
+                  const json op = { { "op", "translate" }, { "dx", dx }, { "dy", dy } };
+                  return json{ { "margin", std::max(std::abs(dx), std::abs(dy)) }, { "ops", json::array({ op }) } };
               } } },
     { "apply_jpeg_compression",
       option{ 0, 100,
@@ -234,15 +206,9 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::get<int>(current) + 10 };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  apply_jpeg_compression(img, std::get<int>(param));
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
+              nullptr,
+              [](param_t param, const cv::Size&) {
+                  return single_op({ { "op", "jpeg_compression" }, { "quality", std::get<int>(param) } });
               } } },
     { "encoded_marker_size",
       option{ 3, 25,
@@ -253,17 +219,11 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::get<int>(current) + 2 };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
+              [](CopyStyleParams& style, param_t param) {
                   style.encoded_marker_size = std::get<int>(param);
                   style.header_marker_size = std::get<int>(param);
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
-              } } },
+              },
+              nullptr } },
     { "unencoded_marker_size",
       option{ 5, 25,
               [](param_t current, param_t start, param_t end, bool& stop) {
@@ -273,16 +233,8 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::get<int>(current) + 2 };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  style.unencoded_marker_size = std::get<int>(param);
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
-              } } },
+              [](CopyStyleParams& style, param_t param) { style.unencoded_marker_size = std::get<int>(param); },
+              nullptr } },
     { "grey_level",
       option{ 0, 255,
               [](param_t current, param_t start, param_t end, bool& stop) {
@@ -292,16 +244,7 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::get<int>(current) + 10 };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  style.grey_level = std::get<int>(param);
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
-              } } },
+              [](CopyStyleParams& style, param_t param) { style.grey_level = std::get<int>(param); }, nullptr } },
     { "dpi",
       option{ 100, 300,
               [](param_t current, param_t start, param_t end, bool& stop) {
@@ -311,16 +254,7 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::get<int>(current) + 100 };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  style.dpi = std::get<int>(param);
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
-              } } },
+              [](CopyStyleParams& style, param_t param) { style.dpi = std::get<int>(param); }, nullptr } },
     { "stroke_width",
       option{ 1, 10,
               [](param_t current, param_t start, param_t end, bool& stop) {
@@ -330,18 +264,28 @@ std::vector<std::pair<std::string, option>> all_config = {
                   }
                   return param_t{ std::get<int>(current) + 2 };
               },
-              [](cv::Mat& img, cv::RNG& rng, param_t param, cv::Mat& affine_transformation, CopyStyleParams style,
-                 CopyMarkerConfig marker_config, std::string copy_name, int& margin_size) {
-                  style.stroke_width = std::get<int>(param);
-                  bool copy_success = create_copy(style, marker_config, copy_name, false);
-                  if (!copy_success) {
-                      throw std::runtime_error("Failed to create copy: " + copy_name);
-                  }
-                  img = cv::imread("./copies/" + copy_name + ".png", cv::IMREAD_GRAYSCALE);
-                  affine_transformation = cv::Mat::eye(2, 3, CV_32F);
-              } } },
+              [](CopyStyleParams& style, param_t param) { style.stroke_width = std::get<int>(param); }, nullptr } },
 };
 
+/**
+ * @brief Chaîne de dégradation d'une copie : celle du scénario, suivie des opérations de --degradation-spec
+ *
+ * La marge est la plus grande des deux ; sans chaîne du scénario ni --degradation-spec, la copie n'est pas
+ * modifiée et la matrice retournée par run est l'identité.
+ *
+ * @param extra_spec Description de --degradation-spec, déjà validée, ou null
+ */
+static DegradationPipeline copy_pipeline(const option& opt, param_t param, const cv::Size& img_size,
+                                         const json& extra_spec) {
+    json spec = opt.degradation ? opt.degradation(param, img_size) : json{ { "ops", json::array() } };
+    if (!extra_spec.is_null()) {
+        spec["margin"] = std::max(spec.value("margin", 0), extra_spec.value("margin", 0));
+        for (const json& op : extra_spec["ops"])
+            spec["ops"].push_back(op);
+    }
+    return DegradationPipeline::compile(spec);
+}
+
 static std::tuple<int, int, CopyStyleParams, CopyMarkerConfig, ParserType, int, CsvMode, std::string>
 validate_parameters(const std::unordered_map<std::string, Config>& config) {
     try {
@@ -414,19 +358,81 @@ void limite_bench(const std::unordered_map<std::string, Config>& config) {
     auto [warmup_iterations, nb_copies, style_params, copy_marker_config, selected_parser, master_seed, csv_mode,
           csv_filename] = validate_parameters(config);
 
+    // réglages du contexte du parseur ; les détecteurs comparés sont changés entre deux passes
+    ParserSettings parser_settings = parser_settings_from_config(config);
+    // "both" analyse chaque copie avec les deux détecteurs, pour comparer temps et précision côte à côte
+    std::vector<ShapeDetector> shape_detectors = { parser_settings.shape_detector };
+    if (config.find("shape-detector") != config.end()) {
+        auto detector_name = std::get<std::string>(config.at("shape-detector").value);
+        if (detector_name == "both") {
+            if (selected_parser != ParserType::SHAPE && selected_parser != ParserType::CENTER_PARSER) {
+                throw std::invalid_argument("\"both\" shape detectors requires the SHAPE or CENTER_PARSER parser");
+            }
+            shape_detectors = { ShapeDetector::CONTOURS, ShapeDetector::COMPONENTS };
+        } else {
+            auto detector = string_to_shape_detector(detector_name);
+            if (!detector.has_value()) {
+                throw std::invalid_argument("Unknown shape detector: " + detector_name);
+            }
+            shape_detectors = { detector.value() };
+        }
+    }
+    auto shape_detector_name = [](ShapeDetector detector) {
+        return std::string(detector == ShapeDetector::COMPONENTS ? "components" : "contours");
+    };
+    if (config.find("circle-detector") != config.end()) {
+        auto detector_name = std::get<std::string>(config.at("circle-detector").value);
+        auto detector = string_to_circle_detector(detector_name);
+        if (!detector.has_value()) {
+            throw std::invalid_argument("Unknown circle detector (\"both\" is only supported by gen-parse): " +
+                                        detector_name);
+        }
+        parser_settings.circle_detector = detector.value();
+    }
+    if (config.find("barcode-backend") != config.end()) {
+        auto backend_name = std::get<std::string>(config.at("barcode-backend").value);
+        auto backend = string_to_barcode_backend(backend_name);
+        if (!backend.has_value() || !barcode_backend_available(backend.value())) {
+            throw std::invalid_argument("Unknown or unavailable barcode backend (\"all\" is only supported by "
+                                        "gen-parse): " + backend_name);
+        }
+        parser_settings.barcode_backend = backend.value();
+    }
+    // chaque scénario décrit sa propre chaîne de dégradation ; celle de --degradation-spec est appliquée à la
+    // suite, sur toutes les copies
+    json extra_spec;
+    if (config.find("degradation-spec") != config.end()) {
+        auto spec_path = std::get<std::string>(config.at("degradation-spec").value);
+        if (!spec_path.empty()) {
+            extra_spec = parse_json_file(spec_path);
+            std::cout << "Degradation pipeline: " << DegradationPipeline::compile(extra_spec).describe()
+                      << " (after each scenario)" << std::endl;
+        }
+    }
+    if (config.find("sequential-degradation") != config.end() &&
+        std::get<int>(config.at("sequential-degradation").value) != 0) {
+        throw std::invalid_argument("--sequential-degradation is only supported by gen-parse");
+    }
+
     BenchmarkSetup benchmark_setup = prepare_benchmark_directories("./output", true, true, csv_mode);
 
     const cv::Point2f src_img_size{ 210, 297 };
 
     Csv<std::string, float, int, std::string, CopyMarkerConfig, int, std::string, std::string, double, double, double,
-        double, double>
+        double, double, std::string>
         benchmark_csv(benchmark_setup.csv_output_dir / csv_filename,
                       { "File", "Parsing_Time_ms", "Parsing_Success", "Parser_Type", "Copy_Config", "Seed",
                         "Modification_Type", "Value_Mofication", "Precision_Error_Avg_px", "Precision_Error_TopLeft_px",
                         "Precision_Error_TopRight_px", "Precision_Error_BottomLeft_px",
-                        "Precision_Error_BottomRight_px" },
+                        "Precision_Error_BottomRight_px", "Shape_Detector" },
                       csv_mode);
 
+    // totaux par détecteur, pour le résumé final
+    std::vector<double> total_parsing_ms(shape_detectors.size(), 0);
+    std::vector<double> total_precision_error(shape_detectors.size(), 0);
+    std::vector<int> nb_success(shape_detectors.size(), 0);
+    int nb_parsed = 0;
+
     for (int i = 0; i < warmup_iterations; i++) {
         std::string warmup_copy_name = "warmup" + std::to_string(i + 1);
         bool copy_success = create_copy(style_params, copy_marker_config, warmup_copy_name, false);
@@ -438,21 +444,40 @@ void limite_bench(const std::unordered_map<std::string, Config>& config) {
 
     std::string output_dir = benchmark_setup.output_dir.string();
 
-    cv::RNG rng(master_seed);
+    // chaque copie tire ses nombres dans son propre flux (graine, scénario, pas du scénario, copie du pas) : les
+    // copies d'un scénario restent identiques quels que soient les scénarios qui le précèdent
+    ParserContext parser_ctx;
+    parser_ctx.settings = parser_settings;
+    parser_ctx.template_dir = "./copies/templates";
+    LayoutCache layout_cache(config.find("layout-sidecar") != config.end() &&
+                             std::get<int>(config.at("layout-sidecar").value) != 0);
 
-    for (const auto& [name, opt] : all_config) {
+    for (size_t scenario = 0; scenario < all_config.size(); ++scenario) {
+        const auto& [name, opt] = all_config[scenario];
         param_t current = opt.start;
         param_t end = opt.end;
         bool stop = false;
-        while (!stop) {
+        for (uint64_t step = 0; !stop; ++step) {
             for (int i = 0; i < nb_copies; i++) {
                 // std::string copy_name = name + "_" + param_to_string(current);
                 std::string copy_name = name + "_" + std::to_string(i + 1) + "_" + param_to_string(current);
-                cv::Mat img;
-                cv::Mat mat;
-                int margin_size = 0;
-                opt.tranformer(img, rng, current, mat, style_params, copy_marker_config, copy_name, margin_size);
+                CopyStyleParams copy_style = style_params;
+                if (opt.style)
+                    opt.style(copy_style, current);
+                if (!create_copy(copy_style, copy_marker_config, copy_name, false))
+                    throw std::runtime_error("Failed to create copy: " + copy_name);
                 std::string copy_full_name = copy_name + ".png";
+                cv::Mat img = cv::imread("./copies/" + copy_full_name, cv::IMREAD_GRAYSCALE);
+                if (img.empty()) {
+                    std::cerr << "Error: Could not read generated image " << copy_full_name << std::endl;
+                    continue;
+                }
+
+                cv::Mat mat;
+                const DegradationPipeline pipeline = copy_pipeline(opt, current, img.size(), extra_spec);
+                const int margin_size = pipeline.margin();
+                cv::RNG rng = stream_rng((uint32_t) master_seed, step, (uint32_t) scenario, (uint32_t) i);
+                pipeline.run(img, mat, (int) (rng.next() | 1));
                 cv::imwrite("./copies/" + copy_full_name, img);
                 std::cout << "  Copy " << copy_name << " created" << std::endl;
                 img = cv::imread("./copies/" + copy_full_name, cv::IMREAD_GRAYSCALE);
@@ -464,78 +489,111 @@ void limite_bench(const std::unordered_map<std::string, Config>& config) {
                 // std::string local_copy_name = copy_name + "_" + std::to_string(i + 1) + ".png";
                 std::string local_copy_name = copy_full_name;
 
-                json atomic_boxes_json = parse_json_file(get_metadata_path(copy_name));
-                auto atomic_boxes = json_to_atomicBox(atomic_boxes_json);
-                std::vector<std::optional<std::shared_ptr<AtomicBox>>> corner_markers;
-                std::vector<std::vector<std::shared_ptr<AtomicBox>>> user_boxes_per_page;
-                differentiate_atomic_boxes(atomic_boxes, corner_markers, user_boxes_per_page);
+                const std::shared_ptr<const Layout> layout_ptr = layout_cache.load(get_metadata_path(copy_name));
+                const Layout& layout = *layout_ptr;
+
+                const cv::Point2f dst_img_size(img.cols, img.rows);
+                auto dst_corner_points = calculate_center_of_marker(layout, src_img_size, dst_img_size);
+                // taille réelle du marqueur sur la copie, pour le rendu du modèle du parseur CUSTOM
+                set_page_geometry(parser_ctx, layout, src_img_size);
+                nb_parsed += 1;
+
+                for (size_t pass = 0; pass < shape_detectors.size(); ++pass) {
+                    parser_ctx.settings.shape_detector = shape_detectors[pass];
+                    const std::string detector = shape_detector_name(shape_detectors[pass]);
+                    const std::string pass_suffix = shape_detectors.size() > 1 ? " [" + detector + "]" : "";
 
 #ifdef DEBUG
-                cv::Mat debug_img;
-                cv::cvtColor(img, debug_img, cv::COLOR_GRAY2BGR);
+                    cv::Mat debug_img;
+                    cv::cvtColor(img, debug_img, cv::COLOR_GRAY2BGR);
 #endif
 
-                const cv::Point2f dst_img_size(img.cols, img.rows);
-                auto dst_corner_points = calculate_center_of_marker(corner_markers, src_img_size, dst_img_size);
-                Metadata meta = { 0, 1, "" };
+                    Metadata meta = { 0, 1, "" };
 
-                std::optional<cv::Mat> affine_transform;
+                    std::optional<cv::Mat> affine_transform;
 
-                auto parse_lambda = [&]() {
-                    affine_transform = run_parser(selected_parser, img,
+                    auto parse_lambda = [&]() {
+                        affine_transform = run_parser(parser_ctx, selected_parser, img,
 #ifdef DEBUG
-                                                  debug_img,
+                                                      debug_img,
 #endif
-                                                  meta, dst_corner_points, copy_config_to_flag(copy_marker_config));
-                };
+                                                      meta, dst_corner_points,
+                                                      copy_config_to_flag(copy_marker_config));
+                    };
 
-                double parsing_milliseconds = Benchmark::measure("  Parsing time", parse_lambda);
+                    double parsing_milliseconds = Benchmark::measure("  Parsing time" + pass_suffix, parse_lambda);
+                    total_parsing_ms[pass] += parsing_milliseconds;
 
-                bool parsing_success = affine_transform.has_value();
-                parsing_success = parsing_success && meta.id == 0;
-                parsing_success = parsing_success && meta.page > 0;
-                std::cout << "  Success: " << (parsing_success ? "Yes" : "No") << std::endl;
+                    bool parsing_success = affine_transform.has_value();
+                    parsing_success = parsing_success && meta.id == 0;
+                    parsing_success = parsing_success && meta.page > 0;
+                    std::cout << "  Success: " << (parsing_success ? "Yes" : "No") << std::endl;
 
-                std::filesystem::path output_img_path_fname = std::filesystem::path(local_copy_name);
+                    std::filesystem::path output_img_path_fname = std::filesystem::path(local_copy_name);
+                    if (shape_detectors.size() > 1)
+                        output_img_path_fname = copy_name + "_" + detector + ".png";
 
 #ifdef DEBUG
-                save_debug_img(debug_img, output_dir, output_img_path_fname);
+                    save_debug_img(debug_img, output_dir, output_img_path_fname);
 #endif
 
-                std::vector<double> precision_errors = { 
-                    std::nan(""), std::nan(""), std::nan(""), std::nan(""), std::nan("")
-                };
-                if (parsing_success) {
-                    auto calibrated_img_col = redress_image(img, affine_transform.value());
-
-                    precision_errors =
-                        calculate_precision_error(dst_img_size, mat, affine_transform.value(), margin_size);
-                    std::cout << "  Precision error: " << std::fixed << std::setprecision(3) << precision_errors.back()
-                              << " pixels" << std::endl;
-
-                    for (auto box : user_boxes_per_page[meta.page - 1]) {
-                        draw_box_outline(box, calibrated_img_col, src_img_size, dst_img_size, cv::Scalar(255, 0, 255));
-                    }
+                    std::vector<double> precision_errors = { 
+                        std::nan(""), std::nan(""), std::nan(""), std::nan(""), std::nan("")
+                    };
+                    if (parsing_success) {
+                        auto calibrated_img_col = redress_image(img, affine_transform.value());
+
+                        precision_errors =
+                            calculate_precision_error(dst_img_size, mat, affine_transform.value(), margin_size);
+                        std::cout << "  Precision error: " << std::fixed << std::setprecision(3)
+                                  << precision_errors.back() << " pixels" << std::endl;
+                        nb_success[pass] += 1;
+                        total_precision_error[pass] += precision_errors.back();
+
+                        const PageBoxes& page_boxes = layout.pages[meta.page - 1];
+                        for (size_t i = 0; i < page_boxes.size(); ++i) {
+                            draw_box_outline(page_boxes.rect(i), calibrated_img_col, src_img_size, dst_img_size,
+                                             cv::Scalar(255, 0, 255));
+                        }
 
-                    for (auto box : corner_markers) {
-                        if (!box.has_value()) {
-                            continue;
+                        for (const auto& marker : layout.corners) {
+                            if (!marker.has_value()) {
+                                continue;
+                            }
+                            draw_box_outline(*marker, calibrated_img_col, src_img_size, dst_img_size,
+                                             cv::Scalar(255, 0, 0));
+                            draw_box_center(*marker, calibrated_img_col, src_img_size, dst_img_size,
+                                            cv::Scalar(0, 255, 0));
                         }
-                        auto marker = box.value();
-                        draw_box_outline(marker, calibrated_img_col, src_img_size, dst_img_size, cv::Scalar(255, 0, 0));
-                        draw_box_center(marker, calibrated_img_col, src_img_size, dst_img_size, cv::Scalar(0, 255, 0));
+
+                        save_image(calibrated_img_col, output_dir, output_img_path_fname);
                     }
 
-                    save_image(calibrated_img_col, output_dir, output_img_path_fname);
+                    // Écrire les résultats dans le CSV
+                    benchmark_csv.add_row({ copy_name, parsing_milliseconds, parsing_success ? 1 : 0,
+                                            parser_type_to_string(selected_parser), copy_marker_config, master_seed,
+                                            name, param_to_string(current), precision_errors.back(),
+                                            precision_errors[0], precision_errors[1], precision_errors[2],
+                                            precision_errors[3], detector });
                 }
-
-                // Écrire les résultats dans le CSV
-                benchmark_csv.add_row({ copy_name, parsing_milliseconds, parsing_success ? 1 : 0,
-                                        parser_type_to_string(selected_parser), copy_marker_config, master_seed, name,
-                                        param_to_string(current), precision_errors.back(), precision_errors[0],
-                                        precision_errors[1], precision_errors[2], precision_errors[3] });
             }
             current = opt.step(current, opt.start, opt.end, stop);
         }
     }
-}
\ No newline at end of file
+
+    if (shape_detectors.size() > 1 && nb_parsed > 0) {
+        std::cout << "Average parsing time, success and corner error per shape detector:" << std::endl;
+        for (size_t pass = 0; pass < shape_detectors.size(); ++pass) {
+            std::cout << "  " << shape_detector_name(shape_detectors[pass]) << ": " << std::fixed
+                      << std::setprecision(3) << total_parsing_ms[pass] / nb_parsed << " ms, " << nb_success[pass]
+                      << "/" << nb_parsed << " parsed, ";
+            if (nb_success[pass] > 0)
+                std::cout << total_precision_error[pass] / nb_success[pass] << " px" << std::endl;
+            else
+                std::cout << "no corner error (nothing parsed)" << std::endl;
+        }
+    }
+
+    std::cout << "Layout cache: " << layout_cache.size() << " distinct layout(s), " << layout_cache.hits()
+              << " reused, " << layout_cache.sidecar_loads() << " loaded from sidecar" << std::endl;
+}
@@ -20,6 +20,9 @@
 #include "bench/config_analysis.h"
 #include "bench/gen_parse.h"
 #include "bench/limite_bench.h"
+#include "bench/aruco_bench.h"
+#include "bench/corner_solver_bench.h"
+#include "bench/degradation_bench.h"
 #include "external-tools/create_copy.h"
 
 /**
@@ -37,7 +40,7 @@ std::vector<std::pair<std::string, Config>> default_config = {
     { "parser-type",
       { "Parser type",
         "The type of parser to use (ARUCO, CIRCLE, ZXING, SHAPE, CENTER_PARSER, DEFAULT_PARSER, "
-        "EMPTY)",
+        "QR_EYE, CROSS, CUSTOM, EMPTY)",
         std::string("ZXING") } },
     { "encoded-marker-size", { "Encoded marker size", "The size of the encoded markers", 13 } },
     { "unencoded-marker-size", { "Unencoded marker size", "The size of the unencoded markers", 10 } },
@@ -45,6 +48,54 @@ std::vector<std::pair<std::string, Config>> default_config = {
     { "grey-level", { "Grey level", "The grey level of the markers", 0 } },
     { "dpi", { "DPI", "The resolution in dots per inch", 300 } },
     { "seed", { "Random seed", "Seed for the random number generator (0 means use a time-based random seed)", 0 } },
+    { "parallel-quadrants",
+      { "Parallel quadrants", "Parse the four corner quadrants of each sheet concurrently (0 or 1)", 0 } },
+    { "early-quadrant-stop",
+      { "Early quadrant stop",
+        "Skip the bottom-right quadrant once the corner solver accepts the three other corners (0 or 1)", 0 } },
+    { "barcode-search-radius",
+      { "Barcode search radius",
+        "Half-size in pixels of the windows decoded around the expected barcode positions (0 means full page)", 0 } },
+    { "pyramid-scale",
+      { "Pyramid scale",
+        "Downscale factor for the coarse marker detection pass, refined at full resolution (1, 2 or 4)", 1 } },
+    { "shape-detector",
+      { "Shape detector",
+        "Solid marker detection of the SHAPE and CENTER_PARSER parsers: 'contours', 'components', or 'both' to "
+        "compare both side by side (limite-bench)",
+        std::string("contours") } },
+    { "corner-layout-pruning",
+      { "Corner layout pruning",
+        "CENTER_PARSER only evaluates corner triples consistent with the expected layout (0 or 1)", 0 } },
+    { "circle-detector",
+      { "Circle detector",
+        "Circle detection of the CIRCLE parser: 'hough', 'blobs', or 'both' to time both side by side (gen-parse)",
+        std::string("hough") } },
+    { "barcode-backend",
+      { "Barcode backend",
+        "Barcode decoding library: 'zxing', 'zbar' (builds with ENABLE_ZBAR), 'opencv-qr' (QR codes only), or 'all' "
+        "to time every available library side by side (gen-parse)",
+        std::string("zxing") } },
+    { "layout-sidecar",
+      { "Layout sidecar",
+        "Keep each compiled layout in a binary '.layout' file next to its metadata JSON and reload it instead of "
+        "parsing the JSON when the content is unchanged (0 or 1)",
+        0 } },
+    { "qr-locate-only",
+      { "QR locate only",
+        "Locate the non-metadata corner QR codes of the ZXING parser by their finder patterns instead of decoding "
+        "them (0 or 1)",
+        0 } },
+    { "degradation-spec",
+      { "Degradation spec",
+        "JSON file describing the degradation pipeline applied to each copy; limite-bench applies it after "
+        "each scenario's degradation; empty means the built-in random_exec pipeline (gen-parse) or none",
+        std::string("") } },
+    { "sequential-degradation",
+      { "Sequential degradation",
+        "Degrade each copy with random_exec_sequential, one full-image pass per effect, instead of the fused "
+        "pipeline (gen-parse only, 0 or 1; not combinable with --degradation-spec)",
+        0 } },
     { "csv-mode",
       { "CSV Mode", "How to handle existing CSV files: 'append' to add data or 'overwrite' to delete and recreate",
         std::string("overwrite") } },
@@ -72,6 +123,66 @@ std::vector<std::pair<std::string, Config>> config_analysis_config = {
       { "CSV Filename", "Name of the CSV file for benchmark results", std::string("benchmark_results.csv") } },
 };
 
+/**
+ * @brief Configuration par défaut pour le micro-benchmark de détection ArUco
+ */
+std::vector<std::pair<std::string, Config>> aruco_bench_config = {
+    { "nb-copies", { "Number of copies", "The number of copies to generate", 1 } },
+    { "iterations", { "Iterations", "Number of timed detections per copy and implementation", 20 } },
+    { "marker-config",
+      { "Marker configuration", "The configuration of the markers to use", "(aruco,aruco,aruco,qrcode-e,#)" } },
+    { "encoded-marker-size", { "Encoded marker size", "The size of the encoded markers", 13 } },
+    { "unencoded-marker-size", { "Unencoded marker size", "The size of the unencoded markers", 10 } },
+    { "header-marker-size", { "Header marker size", "The size of the header marker", 7 } },
+    { "grey-level", { "Grey level", "The grey level of the markers", 0 } },
+    { "dpi", { "DPI", "The resolution in dots per inch", 300 } },
+    { "seed", { "Random seed", "Seed for the random number generator (0 means use a time-based random seed)", 0 } },
+    { "csv-mode",
+      { "CSV Mode", "How to handle existing CSV files: 'append' to add data or 'overwrite' to delete and recreate",
+        std::string("overwrite") } },
+    { "csv-filename",
+      { "CSV Filename", "Name of the CSV file for benchmark results", std::string("aruco_bench_results.csv") } },
+};
+
+/**
+ * @brief Configuration par défaut pour le micro-benchmark du choix des coins
+ */
+std::vector<std::pair<std::string, Config>> corner_solver_bench_config = {
+    { "nb-sets", { "Number of sets", "The number of noisy candidate sets to generate", 10 } },
+    { "duplicates", { "Duplicates", "Number of detected centers produced by each corner marker", 12 } },
+    { "clutter", { "Clutter", "Number of spurious centers added near each corner of the page", 0 } },
+    { "iterations", { "Iterations", "Number of timed searches per set and implementation", 20 } },
+    { "seed", { "Random seed", "Seed for the random number generator (0 means use a time-based random seed)", 0 } },
+    { "csv-mode",
+      { "CSV Mode", "How to handle existing CSV files: 'append' to add data or 'overwrite' to delete and recreate",
+        std::string("overwrite") } },
+    { "csv-filename",
+      { "CSV Filename", "Name of the CSV file for benchmark results",
+        std::string("corner_solver_bench_results.csv") } },
+};
+
+/**
+ * @brief Configuration par défaut pour le micro-benchmark de la dégradation des copies
+ */
+std::vector<std::pair<std::string, Config>> degradation_bench_config = {
+    { "nb-copies", { "Number of copies", "The number of copies to generate", 1 } },
+    { "iterations", { "Iterations", "Number of timed degradations per copy and implementation", 10 } },
+    { "marker-config",
+      { "Marker configuration", "The configuration of the markers to use",
+        "(qrcode-e,qrcode-e,qrcode-e,qrcode-e,#)" } },
+    { "encoded-marker-size", { "Encoded marker size", "The size of the encoded markers", 13 } },
+    { "unencoded-marker-size", { "Unencoded marker size", "The size of the unencoded markers", 10 } },
+    { "header-marker-size", { "Header marker size", "The size of the header marker", 7 } },
+    { "grey-level", { "Grey level", "The grey level of the markers", 0 } },
+    { "dpi", { "DPI", "The resolution in dots per inch", 300 } },
+    { "seed", { "Random seed", "Seed for the random number generator (0 means use a time-based random seed)", 0 } },
+    { "csv-mode",
+      { "CSV Mode", "How to handle existing CSV files: 'append' to add data or 'overwrite' to delete and recreate",
+        std::string("overwrite") } },
+    { "csv-filename",
+      { "CSV Filename", "Name of the CSV file for benchmark results", std::string("degradation_bench_results.csv") } },
+};
+
 /**
  * @brief Structure définissant un type de benchmark disponible
  *
@@ -95,6 +206,10 @@ std::unordered_map<std::string, BenchmarkConfig> benchmark_map = {
       { "Ink consumption and total area benchmark", config_analysis_benchmark, config_analysis_config } },
     { "gen-parse", { "Generation and parsing benchmark", gen_parse, default_config } },
     { "limite-bench", { "Limite benchmark", limite_bench, default_config } },
+    { "aruco-bench", { "ArUco detector micro-benchmark", aruco_bench, aruco_bench_config } },
+    { "corner-solver-bench",
+      { "Center parser corner solver micro-benchmark", corner_solver_bench, corner_solver_bench_config } },
+    { "degradation-bench", { "Random degradation micro-benchmark", degradation_bench, degradation_bench_config } },
 };
 
 /**
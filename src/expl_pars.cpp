@@ -14,6 +14,10 @@
 #include <cmath>
 #include <filesystem>
 #include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
 
 #include <common.h>
 #include "utils/json_helper.h"
@@ -21,158 +25,667 @@
 #include "utils/string_helper.h"
 #include "utils/math_utils.h"
 #include "utils/draw_helper.h"
+#include "utils/thread_pool.h"
+#include "utils/bounded_queue.h"
+#include "utils/box_stats.h"
 
 /**
- * @brief Point d'entrée du programme d'analyse d'images
- *
- * Ce programme analyse des images contenant des marqueurs, extrait des zones
- * spécifiées dans un fichier de description JSON, et sauvegarde:
- * - Les images redressées avec les zones d'intérêt surlignées
- * - Les sous-images correspondant à chaque zone d'intérêt
- *
- * @param argc Nombre d'arguments passés au programme
- * @param argv Tableau des arguments:
- *        - argv[1]: Répertoire de sortie
- *        - argv[2]: Fichier JSON de description des zones à extraire (AtomicBox)
- *        - argv[3...]: Images à analyser
- * @return int Code de retour (0 en cas de succès, 1 en cas d'erreur)
+ * @brief Options de la ligne de commande du parseur
  */
-int main(int argc, char* argv[]) {
-    if (argc < 4) {
-        fprintf(stderr, "usage: parser OUTPUT_DIR ATOMIC_BOXES IMAGE...\n");
-        return 1;
-    }
+struct ParserOptions {
+    int jobs = 1;                     ///< Nombre de copies analysées en parallèle (0: autant que de cœurs)
+    bool pipeline = false;            ///< Active le pipeline décodage → détection → extraction → écriture
+    int decode_threads = 1;           ///< Threads de l'étage de décodage des images
+    int detect_threads = 0;           ///< Threads de l'étage de détection des marqueurs (0: autant que de cœurs)
+    int extract_threads = 1;          ///< Threads de l'étage de redressement et d'extraction des zones
+    int write_threads = 2;            ///< Threads de l'étage d'écriture des images
+    int max_in_flight = 8;            ///< Nombre maximal de copies en mémoire dans le pipeline
+    bool roi_extract = false;         ///< Extrait les zones depuis l'image source sans redresser la page
+    bool preview = true;              ///< Produit l'image calibrée annotée (cal-*.png)
+    bool parallel_quadrants = false;  ///< Analyse en parallèle les quatre coins de chaque copie
+    bool early_stop = false;          ///< N'analyse pas le coin BR si les trois autres sont validés
+    int barcode_search_radius = 0;    ///< Rayon de recherche des codes-barres (0: page entière)
+    int pyramid_scale = 1;            ///< Facteur de réduction de la détection grossière (1: désactivée)
+    ShapeDetector shape_detector{};   ///< Méthode de détection des formes (défaut: contours)
+    BarcodeBackend barcode_backend{}; ///< Bibliothèque de décodage des codes-barres (défaut: ZXing)
+    bool write_subimg = true;         ///< Écrit les sous-images subimg/raw-*.png
+    std::string box_stats;            ///< Fichier de statistiques des zones (.csv ou .jsonl), vide si désactivé
+    int dark_threshold = 128;         ///< Seuil en dessous duquel un pixel est considéré sombre
+    int inner_margin = -1;            ///< Marge intérieure en pixels en plus de la bordure (< 0: désactivé)
+    std::vector<std::string> positional;
+};
 
-    std::filesystem::path output_dir{ argv[1] };
-    std::filesystem::create_directories(output_dir);
+/**
+ * @brief Résultat de l'analyse d'une copie, utilisé pour le récapitulatif final
+ */
+struct SheetResult {
+    bool success = false;
+    int id = -1;
+    int page = -1;
+    int nb_boxes = 0;
+    int barcode_fallbacks = 0; ///< Replis du décodage des codes-barres sur la page entière
+};
 
-    std::filesystem::path subimg_output_dir = output_dir.string() + std::string("/subimg");
-    std::filesystem::create_directories(subimg_output_dir);
+/**
+ * @brief Données partagées (en lecture seule) entre toutes les copies d'un lot
+ */
+struct SheetContext {
+    std::filesystem::path output_dir;
+    Layout layout;
+    cv::Point2f src_img_size;
+    ParserSettings parser_settings;             ///< Réglages du parseur, copiés dans le contexte de chaque thread
+    bool roi_extract = false;                   ///< Extrait les zones depuis l'image source sans redresser la page
+    bool preview = true;                        ///< Produit l'image calibrée annotée (cal-*.png)
+    bool write_subimg = true;                   ///< Écrit les sous-images subimg/raw-*.png
+    BoxStatsWriter* box_stats_writer = nullptr; ///< Sortie des statistiques des zones (nullptr: désactivé)
+    int dark_threshold = 128;
+    int inner_margin = -1;
+};
 
-    std::ifstream atomic_boxes_file(argv[2]);
-    if (!atomic_boxes_file.is_open()) {
-        fprintf(stderr, "could not open file '%s'\n", argv[2]);
-        return 1;
-    }
-    json atomic_boxes_json;
-    try {
-        atomic_boxes_json = json::parse(atomic_boxes_file);
-    } catch (const json::exception& e) {
-        fprintf(stderr, "could not json parse file '%s': %s", argv[2], e.what());
-        return 1;
-    }
-    // printf("atomic_boxes: %s\n", atomic_boxes_json.dump(2).c_str());
+/**
+ * @brief État d'une copie au cours de son traitement
+ *
+ * Chaque étage complète la structure puis la transmet à l'étage suivant. Une copie en échec
+ * (failed) traverse les étages restants sans traitement afin d'être comptabilisée à la fin.
+ */
+struct SheetJob {
+    size_t index = 0; ///< Position de l'image dans les arguments
+    std::string image_path;
+    std::filesystem::path output_img_path_fname;
+    cv::Mat img;
+#ifdef DEBUG
+    cv::Mat debug_img;
+#endif
+    Metadata meta;
+    std::optional<cv::Mat> affine_transform;
+    std::vector<std::pair<std::string, cv::Mat>> subimages;  ///< Sous-images à écrire (chemin, image)
+    std::vector<std::pair<std::string, BoxStats>> box_stats; ///< Statistiques de chaque zone
+    std::string calibrated_fname;
+    cv::Mat calibrated_img;
+    SheetResult result;
+    bool failed = false;
+};
 
-    auto atomic_boxes = json_to_atomicBox(atomic_boxes_json);
-    std::vector<std::optional<std::shared_ptr<AtomicBox>>> corner_markers;
-    std::vector<std::vector<std::shared_ptr<AtomicBox>>> user_boxes_per_page;
-    differentiate_atomic_boxes(atomic_boxes, corner_markers, user_boxes_per_page);
+/**
+ * @brief Analyse les options de la ligne de commande
+ *
+ * Les options (préfixées par "--") peuvent apparaître n'importe où ; les autres arguments
+ * sont conservés dans l'ordre comme arguments positionnels.
+ *
+ * @return std::optional<ParserOptions> Options lues, ou nullopt si une option est invalide
+ */
+static std::optional<ParserOptions> parse_options(int argc, char* argv[]) {
+    const std::unordered_map<std::string, int ParserOptions::*> int_options = {
+        { "--jobs", &ParserOptions::jobs },
+        { "-j", &ParserOptions::jobs },
+        { "--decode-threads", &ParserOptions::decode_threads },
+        { "--detect-threads", &ParserOptions::detect_threads },
+        { "--extract-threads", &ParserOptions::extract_threads },
+        { "--write-threads", &ParserOptions::write_threads },
+        { "--max-in-flight", &ParserOptions::max_in_flight },
+        { "--dark-threshold", &ParserOptions::dark_threshold },
+        { "--inner-margin", &ParserOptions::inner_margin },
+        { "--barcode-search-radius", &ParserOptions::barcode_search_radius },
+        { "--pyramid", &ParserOptions::pyramid_scale },
+    };
 
-    /// TODO: load page.json
-    const cv::Point2f src_img_size{ 210, 297 }; // TODO: do not assume A4
+    ParserOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto it = int_options.find(arg);
+        if (it != int_options.end()) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "missing value for %s\n", arg.c_str());
+                return {};
+            }
+            try {
+                options.*(it->second) = std::stoi(argv[++i]);
+            } catch (const std::exception&) {
+                fprintf(stderr, "invalid value for %s: '%s'\n", arg.c_str(), argv[i]);
+                return {};
+            }
+        } else if (arg == "--pipeline") {
+            options.pipeline = true;
+        } else if (arg == "--roi-extract") {
+            options.roi_extract = true;
+        } else if (arg == "--no-preview") {
+            options.preview = false;
+        } else if (arg == "--parallel-quadrants") {
+            options.parallel_quadrants = true;
+        } else if (arg == "--early-quadrant-stop") {
+            options.early_stop = true;
+        } else if (arg == "--no-subimg") {
+            options.write_subimg = false;
+        } else if (arg == "--shape-detector") {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "missing value for %s\n", arg.c_str());
+                return {};
+            }
+            auto detector = string_to_shape_detector(argv[++i]);
+            if (!detector.has_value()) {
+                fprintf(stderr, "invalid value for %s: '%s'\n", arg.c_str(), argv[i]);
+                return {};
+            }
+            options.shape_detector = detector.value();
+        } else if (arg == "--barcode-backend") {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "missing value for %s\n", arg.c_str());
+                return {};
+            }
+            auto backend = string_to_barcode_backend(argv[++i]);
+            if (!backend.has_value() || !barcode_backend_available(backend.value())) {
+                fprintf(stderr, "invalid or unavailable value for %s: '%s'\n", arg.c_str(), argv[i]);
+                return {};
+            }
+            options.barcode_backend = backend.value();
+        } else if (arg == "--box-stats") {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "missing value for %s\n", arg.c_str());
+                return {};
+            }
+            options.box_stats = argv[++i];
+        } else if (starts_with(arg, "--")) {
+            fprintf(stderr, "unknown option '%s'\n", arg.c_str());
+            return {};
+        } else {
+            options.positional.emplace_back(arg);
+        }
+    }
+    return options;
+}
 
-    for (int i = 3; i < argc; ++i) {
-        cv::Mat img = cv::imread(argv[i], cv::IMREAD_GRAYSCALE);
-        const cv::Point2f dst_img_size(img.cols, img.rows);
-        /// TODO: use min and max for 90 ° rotate if needed
-        // printf("dst_img_size: (%f, %f)\n", dst_img_size.x, dst_img_size.y);
+/**
+ * @brief Étage 1 : lecture et décodage de l'image
+ */
+static void decode_sheet(SheetJob& job) {
+    std::filesystem::path input_img_path{ job.image_path };
+    job.output_img_path_fname = input_img_path.filename().replace_extension(".png");
 
-        auto dst_corner_points = calculate_center_of_marker(corner_markers, src_img_size, dst_img_size);
+    job.img = cv::imread(job.image_path, cv::IMREAD_GRAYSCALE);
+    if (job.img.empty()) {
+        fprintf(stderr, "could not read image '%s'\n", job.image_path.c_str());
+        job.failed = true;
+    }
+}
 
-#ifdef DEBUG
-        cv::Mat debug_img;
-        cv::cvtColor(img, debug_img, cv::COLOR_GRAY2BGR);
-#endif
+/**
+ * @brief Étage 2 : détection des marqueurs et calcul de la transformation affine
+ */
+static void detect_sheet(SheetJob& job, const SheetContext& ctx) {
+    const cv::Point2f dst_img_size(job.img.cols, job.img.rows);
+    /// TODO: use min and max for 90 ° rotate if needed
+    // printf("dst_img_size: (%f, %f)\n", dst_img_size.x, dst_img_size.y);
 
-        std::filesystem::path input_img_path{ argv[i] };
-        std::filesystem::path output_img_path_fname = input_img_path.filename().replace_extension(".png");
+    auto dst_corner_points = calculate_center_of_marker(ctx.layout, ctx.src_img_size, dst_img_size);
 
-        Metadata meta;
-        auto affine_transform = run_parser(ParserType::SHAPE, img,
 #ifdef DEBUG
-                                           debug_img,
+    cv::cvtColor(job.img, job.debug_img, cv::COLOR_GRAY2BGR);
 #endif
-                                           meta, dst_corner_points);
 
-        if (!affine_transform.has_value()) {
+    // un contexte par thread de détection, réutilisé pour toutes les copies qu'il traite
+    thread_local ParserContext parser_ctx;
+    parser_ctx.settings = ctx.parser_settings;
+    set_page_geometry(parser_ctx, ctx.layout, ctx.src_img_size);
+    parser_ctx.template_dir = (ctx.output_dir / "templates").string();
+    const int fallbacks_before = parser_ctx.barcode_fallbacks;
+    job.affine_transform = run_parser(parser_ctx, ParserType::SHAPE, job.img,
 #ifdef DEBUG
-            save_debug_img(debug_img, output_dir, output_img_path_fname);
+                                      job.debug_img,
 #endif
-            fprintf(stderr, "could not parse image '%s'\n", argv[i]);
-            return 1;
-        }
+                                      job.meta, dst_corner_points);
+    job.result.barcode_fallbacks = parser_ctx.barcode_fallbacks - fallbacks_before;
 
-        auto calibrated_img_col = redress_image(img, affine_transform.value());
+    if (!job.affine_transform.has_value()) {
+        fprintf(stderr, "could not parse image '%s'\n", job.image_path.c_str());
+        job.failed = true;
+        return;
+    }
 
-        cv::Point2f dimension(calibrated_img_col.cols, calibrated_img_col.rows);
+    if (job.meta.page < 1 || job.meta.page > (int) ctx.layout.pages.size()) {
+        fprintf(stderr, "image '%s' has an unexpected page number (%d)\n", job.image_path.c_str(), job.meta.page);
+        job.failed = true;
+    }
+}
 
-        for (auto box : user_boxes_per_page[meta.page - 1]) {
-            const std::vector<cv::Point2f> vec_box = { cv::Point2f{ box->x, box->y },
-                                                       cv::Point2f{ box->x + box->width, box->y },
-                                                       cv::Point2f{ box->x + box->width, box->y + box->height },
-                                                       cv::Point2f{ box->x, box->y + box->height } };
+/**
+ * @brief Étage 3 : redressement de l'image et découpage des zones d'intérêt
+ *
+ * En mode ctx.roi_extract, chaque zone est rééchantillonnée directement depuis l'image source
+ * et la page entière n'est redressée que si l'aperçu calibré est demandé (ctx.preview).
+ * Si ctx.box_stats_writer est défini, les statistiques de remplissage de chaque zone sont
+ * calculées sur l'image redressée (avant annotation) à l'aide d'une image intégrale.
+ * Les images produites ne sont pas écrites ici mais conservées dans job pour l'étage d'écriture.
+ */
+static void extract_sheet(SheetJob& job, const SheetContext& ctx) {
+    const auto& src_img_size = ctx.src_img_size;
+    const auto& affine_transform = job.affine_transform.value();
 
-            std::vector<cv::Point> raster_box = convert_to_raster(vec_box, src_img_size, dimension);
+    // l'image redressée a la taille de l'image source
+    cv::Point2f dimension(job.img.cols, job.img.rows);
 
-            int min_x = INT_MAX;
-            int min_y = INT_MAX;
-            int max_x = INT_MIN;
-            int max_y = INT_MIN;
-            for (auto v : raster_box) {
-                min_x = std::min(min_x, v.x);
-                min_y = std::min(min_y, v.y);
-                max_x = std::max(max_x, v.x);
-                max_y = std::max(max_y, v.y);
-            }
+    const bool compute_stats = ctx.box_stats_writer != nullptr;
+    // épaisseur de la bordure des zones : mm → pixels
+    const float px_per_mm = dimension.x / src_img_size.x;
+
+    cv::Mat calibrated_img_col;
+    if (!ctx.roi_extract || ctx.preview)
+        calibrated_img_col = redress_image(job.img, affine_transform);
+
+    // en mode pleine page, une seule image intégrale sert à toutes les zones
+    std::optional<FillIntegral> page_integral;
+    if (compute_stats && !ctx.roi_extract)
+        page_integral.emplace(calibrated_img_col, ctx.dark_threshold);
+
+    // toutes les zones de la page sont converties en pixels en une seule passe sur les tableaux du Layout
+    const PageBoxes& page_boxes = ctx.layout.pages[job.meta.page - 1];
+    std::vector<cv::Rect> box_rects;
+    raster_rects(page_boxes, src_img_size, dimension, box_rects);
 
+    for (size_t i = 0; i < page_boxes.size(); ++i) {
+        const std::string& box_id = ctx.layout.id(page_boxes, i);
+        const cv::Rect& box_rect = box_rects[i];
+        const int min_x = box_rect.x, min_y = box_rect.y;
+        const int max_x = box_rect.x + box_rect.width, max_y = box_rect.y + box_rect.height;
+
+        // printf("%d,%s: (%d,%d) -> (%d,%d)\n", copy, box_id.c_str(), min_x, min_y, max_x, max_y);
+        cv::Mat subimg;
+        if (ctx.roi_extract && (ctx.write_subimg || compute_stats)) {
+            subimg = redress_roi(job.img, affine_transform, box_rect);
+        } else if (ctx.write_subimg) {
             cv::Range rows(min_y, max_y);
             cv::Range cols(min_x, max_x);
-            // printf("%d,%s: (%d,%d) -> (%d,%d)\n", copy, box->id.c_str(), min_x, min_y, max_x, max_y);
-            cv::Mat subimg = calibrated_img_col(rows, cols);
+            // copie : l'image redressée est annotée ci-dessous avant l'écriture
+            subimg = calibrated_img_col(rows, cols).clone();
+        }
+
+        if (compute_stats) {
+            int inner_margin = -1;
+            if (ctx.inner_margin >= 0)
+                inner_margin = (int) std::ceil(page_boxes.stroke_width[i] * px_per_mm) + ctx.inner_margin;
+
+            if (page_integral.has_value()) {
+                job.box_stats.emplace_back(box_id, page_integral->box_stats(box_rect, inner_margin));
+            } else {
+                FillIntegral roi_integral(subimg, ctx.dark_threshold);
+                job.box_stats.emplace_back(box_id, roi_integral.box_stats(cv::Rect(0, 0, subimg.cols, subimg.rows),
+                                                                           inner_margin));
+            }
+        }
 
+        if (ctx.write_subimg) {
             char* output_img_fname = nullptr;
-            int nb =
-                asprintf(&output_img_fname, "%s/subimg/raw-%d-%s.png", output_dir.c_str(), meta.id, box->id.c_str());
+            int nb = asprintf(&output_img_fname, "%s/subimg/raw-%d-%s.png", ctx.output_dir.c_str(), job.meta.id,
+                              box_id.c_str());
             (void) nb;
-            printf("box fname: %s\n", output_img_fname);
-            cv::imwrite(output_img_fname, subimg);
+            job.subimages.emplace_back(output_img_fname, subimg);
             free(output_img_fname);
-
-            cv::polylines(calibrated_img_col, raster_box, true, cv::Scalar(255, 0, 255), 2);
         }
 
-        for (auto box : corner_markers) {
-            if (box.has_value() == false) {
-                continue;
-            }
-            auto marker = box.value();
-            const std::vector<cv::Point2f> vec_box = {
-                cv::Point2f{ marker->x, marker->y }, cv::Point2f{ marker->x + marker->width, marker->y },
-                cv::Point2f{ marker->x + marker->width, marker->y + marker->height },
-                cv::Point2f{ marker->x, marker->y + marker->height }
-            };
-            std::vector<cv::Point> raster_box = convert_to_raster(vec_box, src_img_size, dimension);
-
-            cv::polylines(calibrated_img_col, raster_box, true, cv::Scalar(255, 0, 0), 2);
-
-            cv::circle(
-                calibrated_img_col,
-                convert_to_raster({ cv::Point2f{ marker->x + marker->width / 2, marker->y + marker->height / 2 } },
-                                  src_img_size, dimension)[0],
-                3, cv::Scalar(0, 255, 0), -1);
+        if (ctx.preview)
+            cv::rectangle(calibrated_img_col, box_rect.tl(), box_rect.br(), cv::Scalar(255, 0, 255), 2);
+        job.result.nb_boxes += 1;
+    }
+
+    // l'image source n'est plus utile, on libère la mémoire au plus tôt
+    job.img.release();
+
+    if (!ctx.preview)
+        return;
+
+    for (const auto& marker : ctx.layout.corners) {
+        if (marker.has_value() == false) {
+            continue;
         }
+        const std::vector<cv::Point2f> vec_box = { cv::Point2f{ marker->x, marker->y },
+                                                   cv::Point2f{ marker->x + marker->width, marker->y },
+                                                   cv::Point2f{ marker->x + marker->width, marker->y + marker->height },
+                                                   cv::Point2f{ marker->x, marker->y + marker->height } };
+        std::vector<cv::Point> raster_box = convert_to_raster(vec_box, src_img_size, dimension);
+
+        cv::polylines(calibrated_img_col, raster_box, true, cv::Scalar(255, 0, 0), 2);
+
+        cv::circle(calibrated_img_col, convert_to_raster({ marker->center() }, src_img_size, dimension)[0], 3,
+                   cv::Scalar(0, 255, 0), -1);
+    }
+
+    char* output_img_fname = nullptr;
+    int nb = asprintf(&output_img_fname, "%s/cal-%s", ctx.output_dir.c_str(), job.output_img_path_fname.c_str());
+    (void) nb;
+    job.calibrated_fname = output_img_fname;
+    job.calibrated_img = calibrated_img_col;
+    free(output_img_fname);
+}
+
+/**
+ * @brief Étage 4 : encodage et écriture des images produites, puis bilan de la copie
+ */
+static void write_sheet(SheetJob& job, const SheetContext& ctx) {
+    for (const auto& [fname, subimg] : job.subimages) {
+        printf("box fname: %s\n", fname.c_str());
+        cv::imwrite(fname, subimg);
+    }
+    job.subimages.clear();
 
-        char* output_img_fname = nullptr;
-        int nb = asprintf(&output_img_fname, "%s/cal-%s", output_dir.c_str(), output_img_path_fname.c_str());
-        (void) nb;
-        cv::imwrite(output_img_fname, calibrated_img_col);
-        printf("output image: %s\n", output_img_fname);
-        free(output_img_fname);
+    if (ctx.box_stats_writer != nullptr && !job.failed) {
+        ctx.box_stats_writer->write(job.meta.id, job.meta.page, job.box_stats);
+    }
+    job.box_stats.clear();
+
+    if (!job.calibrated_img.empty()) {
+        cv::imwrite(job.calibrated_fname, job.calibrated_img);
+        printf("output image: %s\n", job.calibrated_fname.c_str());
+        job.calibrated_img.release();
+    }
 
 #ifdef DEBUG
-        save_debug_img(debug_img, output_dir, output_img_path_fname);
+    if (!job.debug_img.empty()) {
+        save_debug_img(job.debug_img, ctx.output_dir, job.output_img_path_fname);
+        job.debug_img.release();
+    }
+#else
+    (void) ctx;
 #endif
+
+    if (!job.failed) {
+        job.result.success = true;
+        job.result.id = job.meta.id;
+        job.result.page = job.meta.page;
+    }
+}
+
+/**
+ * @brief Analyse complète d'une copie en enchaînant les étages dans le thread courant
+ *
+ * Cette fonction ne modifie que des données locales à la copie, elle peut donc être appelée
+ * depuis plusieurs threads en parallèle.
+ *
+ * @param image_path Chemin de l'image à analyser
+ * @param ctx Données partagées du lot
+ * @return SheetResult Résultat de l'analyse
+ */
+static SheetResult process_sheet(const std::string& image_path, const SheetContext& ctx) {
+    SheetJob job;
+    job.image_path = image_path;
+    decode_sheet(job);
+    if (!job.failed)
+        detect_sheet(job, ctx);
+    if (!job.failed)
+        extract_sheet(job, ctx);
+    write_sheet(job, ctx);
+    return job.result;
+}
+
+/**
+ * @brief Lance les threads d'un étage du pipeline
+ *
+ * Chaque thread retire une copie de la file d'entrée, lui applique l'étage (sauf si elle est
+ * déjà en échec) puis la pousse dans la file de sortie. Le dernier thread de l'étage à se
+ * terminer ferme la file de sortie, ce qui propage la fin du lot à l'étage suivant.
+ */
+template <typename StageFn>
+static void launch_stage(std::vector<std::thread>& threads, int nb_threads, BoundedQueue<SheetJob>& input,
+                         BoundedQueue<SheetJob>& output, StageFn stage) {
+    if (nb_threads <= 0)
+        nb_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    auto remaining = std::make_shared<std::atomic<int>>(nb_threads);
+    for (int t = 0; t < nb_threads; ++t) {
+        threads.emplace_back([&input, &output, stage, remaining]() {
+            SheetJob job;
+            while (input.pop(job)) {
+                if (!job.failed) {
+                    try {
+                        stage(job);
+                    } catch (const std::exception& e) {
+                        fprintf(stderr, "error while processing image '%s': %s\n", job.image_path.c_str(), e.what());
+                        job.failed = true;
+                    }
+                }
+                output.push(std::move(job));
+                job = SheetJob{};
+            }
+            if (remaining->fetch_sub(1) == 1)
+                output.close();
+        });
+    }
+}
+
+/**
+ * @brief Analyse un lot de copies avec un pipeline à étages
+ *
+ * Décodage, détection, redressement/extraction et écriture s'exécutent dans des groupes de
+ * threads distincts reliés par des files bornées : les étages limités par les entrées/sorties
+ * se recouvrent avec les étages de calcul. Le nombre de copies présentes en mémoire entre le
+ * début du décodage et la fin de l'écriture est limité par options.max_in_flight.
+ *
+ * @param images Chemins des images à analyser
+ * @param ctx Données partagées du lot
+ * @param options Nombre de threads par étage et limite de copies en mémoire
+ * @param results Résultats, indexés comme images
+ */
+static void run_pipeline(const std::vector<std::string>& images, const SheetContext& ctx,
+                         const ParserOptions& options, std::vector<SheetResult>& results) {
+    const size_t max_in_flight = std::max(1, options.max_in_flight);
+
+    // jetons de mémoire : un jeton est pris avant le décodage et rendu après l'écriture
+    BoundedQueue<int> tokens(max_in_flight);
+    for (size_t i = 0; i < max_in_flight; ++i) {
+        tokens.push(0);
+    }
+
+    BoundedQueue<SheetJob> decoded(max_in_flight);
+    BoundedQueue<SheetJob> detected(max_in_flight);
+    BoundedQueue<SheetJob> extracted(max_in_flight);
+
+    std::vector<std::thread> threads;
+
+    // étage 1 : décodage, les images sont distribuées dans l'ordre des arguments
+    std::atomic<size_t> next_image{ 0 };
+    const int decode_threads =
+        options.decode_threads > 0 ? options.decode_threads : std::max(1u, std::thread::hardware_concurrency());
+    auto decode_remaining = std::make_shared<std::atomic<int>>(decode_threads);
+    for (int t = 0; t < decode_threads; ++t) {
+        threads.emplace_back([&, decode_remaining]() {
+            int token;
+            while (tokens.pop(token)) {
+                size_t i = next_image.fetch_add(1);
+                if (i >= images.size()) {
+                    tokens.push(token);
+                    break;
+                }
+                SheetJob job;
+                job.index = i;
+                job.image_path = images[i];
+                try {
+                    decode_sheet(job);
+                } catch (const std::exception& e) {
+                    fprintf(stderr, "error while reading image '%s': %s\n", job.image_path.c_str(), e.what());
+                    job.failed = true;
+                }
+                decoded.push(std::move(job));
+            }
+            if (decode_remaining->fetch_sub(1) == 1)
+                decoded.close();
+        });
+    }
+
+    launch_stage(threads, options.detect_threads, decoded, detected, [&ctx](SheetJob& job) { detect_sheet(job, ctx); });
+    launch_stage(threads, options.extract_threads, detected, extracted,
+                 [&ctx](SheetJob& job) { extract_sheet(job, ctx); });
+
+    // étage 4 : écriture, puis restitution du jeton de mémoire
+    const int write_threads =
+        options.write_threads > 0 ? options.write_threads : std::max(1u, std::thread::hardware_concurrency());
+    for (int t = 0; t < write_threads; ++t) {
+        threads.emplace_back([&]() {
+            SheetJob job;
+            while (extracted.pop(job)) {
+                try {
+                    write_sheet(job, ctx);
+                } catch (const std::exception& e) {
+                    fprintf(stderr, "error while writing image '%s': %s\n", job.image_path.c_str(), e.what());
+                    job.result.success = false;
+                }
+                results[job.index] = job.result;
+                job = SheetJob{};
+                tokens.push(0);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Point d'entrée du programme d'analyse d'images
+ *
+ * Ce programme analyse des images contenant des marqueurs, extrait des zones
+ * spécifiées dans un fichier de description JSON, et sauvegarde:
+ * - Les images redressées avec les zones d'intérêt surlignées
+ * - Les sous-images correspondant à chaque zone d'intérêt
+ *
+ * Avec l'option --jobs N, les copies sont analysées en parallèle sur un pool de N threads
+ * à vol de tâches. Avec --pipeline, chaque étage (décodage, détection, extraction, écriture)
+ * dispose de ses propres threads. Le récapitulatif final est toujours affiché dans l'ordre
+ * des arguments, quel que soit le nombre de threads.
+ *
+ * @param argc Nombre d'arguments passés au programme
+ * @param argv Tableau des arguments:
+ *        - [--jobs N]: Nombre de copies analysées en parallèle (défaut: 1, 0: nombre de cœurs)
+ *        - [--pipeline]: Active le pipeline à étages
+ *        - [--decode-threads N] [--detect-threads N] [--extract-threads N] [--write-threads N]:
+ *          Nombre de threads de chaque étage du pipeline (0: nombre de cœurs)
+ *        - [--max-in-flight N]: Nombre maximal de copies en mémoire dans le pipeline
+ *        - [--roi-extract]: Redresse uniquement les zones extraites au lieu de la page entière
+ *        - [--no-preview]: N'écrit pas l'image calibrée annotée (cal-*.png)
+ *        - [--parallel-quadrants]: Analyse en parallèle les quatre coins de chaque copie
+ *        - [--early-quadrant-stop]: N'analyse pas le quadrant inférieur droit lorsque les trois autres
+ *          coins sont validés par la mise en page attendue
+ *        - [--barcode-search-radius N]: Décode les codes-barres dans des fenêtres de N pixels autour des
+ *          positions attendues, avec repli sur la page entière (défaut: 0, page entière)
+ *        - [--pyramid N]: Cherche les marqueurs sur l'image réduite N fois (2 ou 4) puis les affine
+ *          à pleine résolution (défaut: 1, désactivé)
+ *        - [--shape-detector contours|components]: Détection des marqueurs pleins par contours de Canny
+ *          ou par seuillage et composantes connexes (défaut: contours)
+ *        - [--barcode-backend zxing|zbar|opencv-qr]: Bibliothèque de décodage des codes-barres
+ *          (défaut: zxing ; zbar uniquement avec ENABLE_ZBAR)
+ *        - [--no-subimg]: N'écrit pas les sous-images (subimg/raw-*.png)
+ *        - [--box-stats FILE]: Écrit les statistiques de remplissage des zones
+ *          (CSV, ou JSONL si FILE finit par .jsonl)
+ *        - [--dark-threshold N]: Seuil en dessous duquel un pixel est sombre (défaut: 128)
+ *        - [--inner-margin N]: Calcule aussi le ratio de pixels sombres à l'intérieur de la bordure
+ *          (stroke-width), en retirant N pixels supplémentaires de chaque côté
+ *        - OUTPUT_DIR: Répertoire de sortie
+ *        - ATOMIC_BOXES: Fichier JSON de description des zones à extraire (AtomicBox)
+ *        - IMAGE...: Images à analyser
+ * @return int Code de retour (0 si toutes les images ont été analysées, 1 sinon)
+ */
+int main(int argc, char* argv[]) {
+    auto opt_options = parse_options(argc, argv);
+    if (!opt_options.has_value() || opt_options->positional.size() < 3) {
+        fprintf(stderr, "usage: parser [--jobs N] [--pipeline [--decode-threads N] [--detect-threads N] "
+                        "[--extract-threads N] [--write-threads N] [--max-in-flight N]] [--parallel-quadrants] "
+                        "[--early-quadrant-stop] [--barcode-search-radius N] [--pyramid N] "
+                        "[--shape-detector contours|components] [--roi-extract] [--no-preview] [--no-subimg] "
+                        "[--box-stats FILE [--dark-threshold N] [--inner-margin N]] "
+                        "OUTPUT_DIR ATOMIC_BOXES IMAGE...\n");
+        return 1;
+    }
+    const auto& options = opt_options.value();
+    const auto& output_dir_arg = options.positional[0];
+    const auto& atomic_boxes_arg = options.positional[1];
+    const std::vector<std::string> images(options.positional.begin() + 2, options.positional.end());
+
+    SheetContext ctx;
+    ctx.output_dir = std::filesystem::path{ output_dir_arg };
+    std::filesystem::create_directories(ctx.output_dir);
+
+    if (options.write_subimg) {
+        std::filesystem::path subimg_output_dir = ctx.output_dir.string() + std::string("/subimg");
+        std::filesystem::create_directories(subimg_output_dir);
+    }
+
+    std::unique_ptr<BoxStatsWriter> box_stats_writer;
+    if (!options.box_stats.empty()) {
+        try {
+            box_stats_writer = std::make_unique<BoxStatsWriter>(options.box_stats);
+        } catch (const std::runtime_error& e) {
+            fprintf(stderr, "%s\n", e.what());
+            return 1;
+        }
+    }
+
+    std::ifstream atomic_boxes_file(atomic_boxes_arg);
+    if (!atomic_boxes_file.is_open()) {
+        fprintf(stderr, "could not open file '%s'\n", atomic_boxes_arg.c_str());
+        return 1;
+    }
+    json atomic_boxes_json;
+    try {
+        atomic_boxes_json = json::parse(atomic_boxes_file);
+    } catch (const json::exception& e) {
+        fprintf(stderr, "could not json parse file '%s': %s", atomic_boxes_arg.c_str(), e.what());
+        return 1;
+    }
+    // printf("atomic_boxes: %s\n", atomic_boxes_json.dump(2).c_str());
+
+    try {
+        ctx.layout = compile_layout(atomic_boxes_json);
+    } catch (const std::exception& e) {
+        fprintf(stderr, "invalid atomic boxes in '%s': %s\n", atomic_boxes_arg.c_str(), e.what());
+        return 1;
+    }
+
+    /// TODO: load page.json
+    ctx.src_img_size = cv::Point2f{ 210, 297 }; // TODO: do not assume A4
+    ctx.parser_settings.parallel_quadrants = options.parallel_quadrants;
+    ctx.parser_settings.early_quadrant_stop = options.early_stop;
+    ctx.parser_settings.barcode_search_radius = options.barcode_search_radius;
+    ctx.parser_settings.pyramid_scale = pyramid_scale_factor(options.pyramid_scale);
+    ctx.parser_settings.shape_detector = options.shape_detector;
+    ctx.parser_settings.barcode_backend = options.barcode_backend;
+    ctx.roi_extract = options.roi_extract;
+    ctx.preview = options.preview;
+    ctx.write_subimg = options.write_subimg;
+    ctx.box_stats_writer = box_stats_writer.get();
+    ctx.dark_threshold = options.dark_threshold;
+    ctx.inner_margin = options.inner_margin;
+
+    std::vector<SheetResult> results(images.size());
+
+    if (options.pipeline) {
+        run_pipeline(images, ctx, options, results);
+    } else if (options.jobs == 1) {
+        for (size_t i = 0; i < images.size(); ++i) {
+            results[i] = process_sheet(images[i], ctx);
+        }
+    } else {
+        ThreadPool pool(options.jobs);
+        for (size_t i = 0; i < images.size(); ++i) {
+            pool.submit([&, i]() { results[i] = process_sheet(images[i], ctx); });
+        }
+        pool.wait();
+    }
+
+    // Récapitulatif dans l'ordre des arguments : identique quel que soit le nombre de threads
+    int nb_success = 0;
+    int barcode_fallbacks = 0;
+    printf("summary:\n");
+    for (size_t i = 0; i < images.size(); ++i) {
+        const auto& r = results[i];
+        barcode_fallbacks += r.barcode_fallbacks;
+        if (r.success) {
+            nb_success += 1;
+            printf("  %s: ok (id=%d, page=%d, boxes=%d)\n", images[i].c_str(), r.id, r.page, r.nb_boxes);
+        } else {
+            printf("  %s: failed\n", images[i].c_str());
+        }
     }
+    printf("parsed %d/%zu images\n", nb_success, images.size());
+    if (options.barcode_search_radius > 0)
+        printf("barcode full-page fallbacks: %d\n", barcode_fallbacks);
 
-    return 0;
+    return nb_success == (int) images.size() ? 0 : 1;
 }
@@ -209,4 +209,19 @@ bool create_copy(const CopyStyleParams& style_params, const CopyMarkerConfig& ma
 
     std::cout << "Copy generation completed successfully" << std::endl;
     return true;
+}
+
+bool render_marker_template(const std::string& marker_asset, float marker_size, int dpi,
+                            const std::string& output_filename) {
+    std::string root = ".";
+    std::string compile_cmd = "typst compile --root \"" + root + "\" --input marker=\"" + marker_asset + "\" " +
+                              "--input size=" + std::to_string(marker_size) + " \"" + root +
+                              "/typst/marker_template.typ\" \"" + output_filename + "\" --format png --ppi " +
+                              std::to_string(dpi) + getOutputRedirection();
+
+    if (system(compile_cmd.c_str()) != 0) {
+        std::cerr << "Error during marker template compilation command" << std::endl;
+        return false;
+    }
+    return true;
 }
\ No newline at end of file
@@ -233,4 +233,20 @@ struct CopyStyleParams {
 bool create_copy(const CopyStyleParams& style_params, const CopyMarkerConfig& marker_config,
                  const std::string& filename = "copy", bool verbose = false);
 
+/**
+ * @brief Rend un marqueur SVG seul en PNG, à la taille et à la résolution d'une copie
+ *
+ * Le marqueur est rendu par Typst (typst/marker_template.typ), comme sur les copies générées,
+ * sans rotation ni marge.
+ *
+ * @param marker_asset Chemin du SVG relatif au répertoire typst (ex. "assets/marker-custom.svg")
+ * @param marker_size Taille du marqueur en mm
+ * @param dpi Résolution en points par pouce
+ * @param output_filename Chemin du PNG à écrire
+ * @return true si le rendu a réussi
+ * @return false si une erreur est survenue
+ */
+bool render_marker_template(const std::string& marker_asset, float marker_size, int dpi,
+                            const std::string& output_filename);
+
 #endif
\ No newline at end of file
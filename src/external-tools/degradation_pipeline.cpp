@@ -0,0 +1,536 @@
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+
+#include <common.h>
+#include "utils/math_utils.h"
+#include "utils/random_stream.h"
+#include "modifier.h"
+#include "degradation_pipeline.h"
+
+// hauteur des bandes de lignes traitées par un même thread dans un parcours fusionné
+#define DEGRADATION_BAND_ROWS 64
+
+namespace {
+struct ParamDefinition {
+    const char* name;
+    bool integer;  ///< Tirage entier (cv::RNG::uniform(int, int))
+    bool optional; ///< Vaut 0 s'il est absent
+};
+
+struct OpDefinition {
+    const char* name;
+    DegradationOp stream; ///< Flux des tirages de l'opération
+    std::vector<ParamDefinition> params;
+};
+
+/// Description des opérations, dans l'ordre de DegradationOpKind
+const OpDefinition op_definitions[] = {
+    { "rotate", DegradationOp::GEOMETRY, { { "flip_percent", true, true }, { "angle", false, false } } },
+    { "translate", DegradationOp::GEOMETRY, { { "dx", true, false }, { "dy", true, false } } },
+    { "salt_pepper", DegradationOp::SALT_PEPPER, { { "salt", false, false }, { "pepper", false, false } } },
+    { "gaussian_noise",
+      DegradationOp::GAUSSIAN_NOISE,
+      { { "dispersion", false, false }, { "offset", false, false } } },
+    { "contrast_brightness",
+      DegradationOp::CONTRAST_BRIGHTNESS,
+      { { "contrast", true, false }, { "bright", true, false } } },
+    { "ink_stain",
+      DegradationOp::INK_STAIN,
+      { { "count", true, false }, { "radius_min", true, false }, { "radius_max", true, false } } },
+    { "printer_effects", DegradationOp::PRINTER_EFFECTS, { { "intensity", true, false } } },
+    { "jpeg_compression", DegradationOp::JPEG_COMPRESSION, { { "quality", true, false } } },
+};
+
+const OpDefinition& definition(DegradationOpKind kind) {
+    return op_definitions[(int) kind];
+}
+
+PipelineStage::Type stage_type(DegradationOpKind kind) {
+    switch (kind) {
+        case DegradationOpKind::ROTATE:
+        case DegradationOpKind::TRANSLATE:
+            return PipelineStage::WARP;
+        case DegradationOpKind::GAUSSIAN_NOISE:
+        case DegradationOpKind::CONTRAST_BRIGHTNESS:
+        case DegradationOpKind::INK_STAIN:
+        case DegradationOpKind::PRINTER_EFFECTS:
+            return PipelineStage::PIXELS;
+        default:
+            return PipelineStage::SINGLE;
+    }
+}
+
+ParamRange parse_param(const json& value, const ParamDefinition& param, const std::string& op) {
+    ParamRange range;
+    range.integer = param.integer;
+    if (value.is_number()) {
+        range.min = range.max = value.get<float>();
+        return range;
+    }
+    if (value.is_array() && value.size() == 2 && value[0].is_number() && value[1].is_number()) {
+        range.min = value[0].get<float>();
+        range.max = value[1].get<float>();
+        if (range.min <= range.max)
+            return range;
+    }
+    throw std::invalid_argument("op '" + op + "': parameter '" + param.name +
+                                "' must be a number or an interval [min, max]");
+}
+
+/**
+ * @brief Vérifie les bornes des paramètres qui en ont, pour toute valeur que peut prendre un intervalle
+ */
+void check_bounds(const DegradationStep& step, const std::string& name) {
+    if (step.kind == DegradationOpKind::INK_STAIN) {
+        if (step.params[0].min < 0)
+            throw std::invalid_argument("op '" + name + "': 'count' must not be negative");
+        if (step.params[1].min < 0 || step.params[1].max > step.params[2].min)
+            throw std::invalid_argument("op '" + name + "': 'radius_min' must be between 0 and 'radius_max'");
+    } else if (step.kind == DegradationOpKind::JPEG_COMPRESSION) {
+        if (step.params[0].min < 0 || step.params[0].max > 100)
+            throw std::invalid_argument("op '" + name + "': 'quality' must be between 0 and 100");
+    }
+}
+
+DegradationStep parse_step(const json& op) {
+    if (!op.is_object() || !op.contains("op") || !op["op"].is_string())
+        throw std::invalid_argument("each degradation op must be an object with an 'op' name");
+
+    const std::string name = op["op"];
+    for (size_t i = 0; i < std::size(op_definitions); ++i) {
+        const OpDefinition& op_definition = op_definitions[i];
+        if (name != op_definition.name)
+            continue;
+
+        DegradationStep step;
+        step.kind = (DegradationOpKind) i;
+        for (const ParamDefinition& param : op_definition.params) {
+            if (op.contains(param.name))
+                step.params.push_back(parse_param(op[param.name], param, name));
+            else if (param.optional)
+                step.params.push_back(ParamRange{ 0, 0, param.integer });
+            else
+                throw std::invalid_argument("op '" + name + "': missing parameter '" + param.name + "'");
+        }
+        for (const auto& [key, value] : op.items()) {
+            bool known = key == "op";
+            for (const ParamDefinition& param : op_definition.params)
+                known = known || key == param.name;
+            if (!known)
+                throw std::invalid_argument("op '" + name + "': unknown parameter '" + key + "'");
+        }
+        check_bounds(step, name);
+        return step;
+    }
+    throw std::invalid_argument("unknown degradation op '" + name + "'");
+}
+
+/**
+ * @brief Transformation d'une étape WARP, dans les coordonnées de l'image agrandie
+ *
+ * Les opérations sont composées dans l'ordre de la chaîne (la première est appliquée en premier à
+ * l'image) et tirent leurs nombres l'une après l'autre dans le flux de l'étape ; les rotations se font
+ * autour du centre de l'image agrandie.
+ */
+cv::Mat stage_geometry(const std::vector<DegradationStep>& steps, const PipelineStage& stage, cv::RNG& rng,
+                       const cv::Size& padded_size) {
+    cv::Mat geometry = cv::Mat::eye(3, 3, CV_32F);
+    for (size_t index : stage.steps) {
+        const DegradationStep& step = steps[index];
+        if (step.kind == DegradationOpKind::ROTATE) {
+            const float flip_percent = step.params[0].draw(rng);
+            const bool flip = flip_percent > 0 && rng.uniform(0, 100) < flip_percent;
+            const float angle = step.params[1].draw(rng);
+            geometry = rotate_center(flip ? 180.0f + angle : angle, padded_size.width / 2, padded_size.height / 2) *
+                       geometry;
+        } else {
+            const float dx = step.params[0].draw(rng);
+            const float dy = step.params[1].draw(rng);
+            geometry = translate(dx, dy) * geometry;
+        }
+    }
+    return geometry;
+}
+
+/**
+ * @brief Passe d'un parcours fusionné : bruit gaussien, ou table de correspondance par parité du damier
+ */
+struct PixelPass {
+    bool noise = false;
+    double dispersion = 0; ///< Premier paramètre du tirage gaussien (comme add_gaussian_noise)
+    double offset = 0;     ///< Second paramètre du tirage gaussien (comme add_gaussian_noise)
+    uint32_t stream = 0;   ///< Flux de l'opération, dont les sous-flux 1, 2... sont ceux des bandes
+    std::array<std::array<uchar, 256>, 2> lut; ///< Valeur de sortie pour x + y pair ([0]) et impair ([1])
+};
+
+/**
+ * @brief Taches d'encre d'un parcours fusionné, dessinées après lui avec leur valeur finale
+ */
+struct StainOverlay {
+    std::vector<cv::Vec3i> stains; ///< Centre (x, y) et rayon de chaque tache
+    std::array<uchar, 2> value;    ///< Valeur finale d'une tache pour x + y pair ([0]) et impair ([1])
+};
+
+/**
+ * @brief Ajoute une opération déterministe à la dernière table de correspondance et aux taches déjà tirées
+ *
+ * @param f Nouvelle valeur d'un pixel en fonction de sa valeur et de la parité de x + y
+ */
+template <typename F>
+void apply_pointwise(std::vector<PixelPass>& passes, std::vector<StainOverlay>& overlays, const F& f) {
+    if (passes.empty() || passes.back().noise) {
+        PixelPass& identity = passes.emplace_back();
+        for (int parity = 0; parity < 2; parity++) {
+            for (int v = 0; v < 256; v++)
+                identity.lut[parity][v] = (uchar) v;
+        }
+    }
+    PixelPass& pass = passes.back();
+    for (int parity = 0; parity < 2; parity++) {
+        for (int v = 0; v < 256; v++)
+            pass.lut[parity][v] = f(pass.lut[parity][v], parity);
+        for (StainOverlay& overlay : overlays)
+            overlay.value[parity] = f(overlay.value[parity], parity);
+    }
+}
+
+/**
+ * @brief Applique les passes d'une étape PIXELS en un seul parcours de l'image
+ *
+ * L'image est découpée en bandes de DEGRADATION_BAND_ROWS lignes traitées en parallèle ; le bruit
+ * d'une bande est tiré ligne par ligne par un générateur dédié, si bien que le résultat ne dépend pas
+ * du nombre de threads. Chaque valeur est arrondie et saturée entre deux opérations, comme lorsque les
+ * opérations sont appliquées l'une après l'autre.
+ */
+template <int CN>
+void run_pixel_passes(cv::Mat& img, const std::vector<PixelPass>& passes, uint64_t master_seed, uint64_t sheet) {
+    const int width = img.cols * CN;
+    const int nb_bands = (img.rows + DEGRADATION_BAND_ROWS - 1) / DEGRADATION_BAND_ROWS;
+
+    cv::parallel_for_(cv::Range(0, nb_bands), [&](const cv::Range& range) {
+        cv::Mat noise(1, width, CV_32F);
+        std::vector<cv::RNG> band_rngs(passes.size());
+        for (int band = range.start; band < range.end; band++) {
+            // le bruit de chaque bande a son propre sous-flux : l'indice 0 est celui des paramètres
+            for (size_t i = 0; i < passes.size(); i++) {
+                if (passes[i].noise)
+                    band_rngs[i] = stream_rng(master_seed, sheet, passes[i].stream, (uint32_t) band + 1);
+            }
+
+            const int y_end = std::min(img.rows, (band + 1) * DEGRADATION_BAND_ROWS);
+            for (int y = band * DEGRADATION_BAND_ROWS; y < y_end; y++) {
+                uchar* row = img.ptr<uchar>(y);
+                for (size_t i = 0; i < passes.size(); i++) {
+                    const PixelPass& pass = passes[i];
+                    if (pass.noise) {
+                        band_rngs[i].fill(noise, cv::RNG::NORMAL, pass.dispersion, pass.offset);
+                        const float* n = noise.ptr<float>();
+                        for (int k = 0; k < width; k++)
+                            row[k] = cv::saturate_cast<uchar>(row[k] + n[k]);
+                        continue;
+                    }
+
+                    // tables des colonnes paires et impaires de la ligne y
+                    const uchar* luts[2] = { pass.lut[y & 1].data(), pass.lut[(y & 1) ^ 1].data() };
+                    for (int x = 0; x < img.cols; x++) {
+                        const uchar* lut = luts[x & 1];
+                        for (int c = 0; c < CN; c++)
+                            row[x * CN + c] = lut[row[x * CN + c]];
+                    }
+                }
+            }
+        }
+    });
+}
+
+/**
+ * @brief Dessine des taches d'encre avec leur valeur finale, alternée en damier
+ *
+ * Les pixels de chaque tache sont calculés sur un masque limité au carré englobant son disque.
+ */
+void paint_stains(cv::Mat& img, const StainOverlay& overlay) {
+    const int cn = img.channels();
+    const cv::Rect bounds(0, 0, img.cols, img.rows);
+    cv::Mat mask;
+    for (const cv::Vec3i& stain : overlay.stains) {
+        const int radius = stain[2];
+        const cv::Rect box = cv::Rect(stain[0] - radius, stain[1] - radius, 2 * radius + 1, 2 * radius + 1) & bounds;
+        if (box.empty())
+            continue;
+
+        mask = cv::Mat::zeros(box.size(), CV_8U);
+        cv::circle(mask, cv::Point(stain[0] - box.x, stain[1] - box.y), radius, cv::Scalar(255), -1);
+        for (int my = 0; my < box.height; my++) {
+            const int y = box.y + my;
+            const uchar* m = mask.ptr<uchar>(my);
+            uchar* row = img.ptr<uchar>(y);
+            for (int mx = 0; mx < box.width; mx++) {
+                if (!m[mx])
+                    continue;
+                const int x = box.x + mx;
+                const uchar value = overlay.value[(x ^ y) & 1];
+                for (int c = 0; c < cn; c++)
+                    row[x * cn + c] = value;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Exécute une étape PIXELS
+ *
+ * Les paramètres de toutes les opérations sont tirés avant le parcours, chacun dans le flux de son
+ * opération. Les opérations déterministes consécutives sont réduites à une table de correspondance ;
+ * une tache d'encre vaut 1 avant les opérations qui la suivent dans l'étape (la compilation garantit
+ * qu'aucun bruit n'est tiré après elle), sa valeur finale est donc connue avant le parcours.
+ */
+void run_pixel_stage(cv::Mat& img, const std::vector<DegradationStep>& steps, const PipelineStage& stage,
+                     uint64_t master_seed, uint64_t sheet) {
+    std::vector<PixelPass> passes;
+    std::vector<StainOverlay> overlays;
+    bool printer_effects = false;
+    cv::RNG printer_rng;
+    float intensity_factor = 0;
+
+    for (size_t index : stage.steps) {
+        const DegradationStep& step = steps[index];
+        cv::RNG rng = stream_rng(master_seed, sheet, step.stream);
+        switch (step.kind) {
+            case DegradationOpKind::GAUSSIAN_NOISE: {
+                PixelPass& pass = passes.emplace_back();
+                pass.noise = true;
+                // paramètres tronqués en entiers, comme ceux de add_gaussian_noise
+                const int dispersion = (int) step.params[0].draw(rng);
+                const int offset = (int) step.params[1].draw(rng);
+                pass.dispersion = percentage_to_dispersion(img.depth(), dispersion);
+                pass.offset = percentage_to_offset(img.depth(), offset);
+                pass.stream = step.stream;
+                break;
+            }
+            case DegradationOpKind::CONTRAST_BRIGHTNESS: {
+                const int contrast = (int) step.params[0].draw(rng);
+                const int bright = (int) step.params[1].draw(rng);
+                float alpha, beta;
+                std::tie(alpha, beta) = contrast_brightness_coefficients(contrast, bright);
+                apply_pointwise(passes, overlays,
+                                [&](uchar v, int) { return cv::saturate_cast<uchar>(alpha * v + beta); });
+                break;
+            }
+            case DegradationOpKind::INK_STAIN: {
+                const int count = (int) step.params[0].draw(rng);
+                const int radius_min = (int) step.params[1].draw(rng);
+                const int radius_max = (int) step.params[2].draw(rng);
+                StainOverlay& overlay = overlays.emplace_back();
+                overlay.value = { 1, 1 };
+                overlay.stains.resize(std::max(0, count));
+                for (cv::Vec3i& stain : overlay.stains) {
+                    stain[0] = rng.uniform(radius_max, img.cols - radius_max);
+                    stain[1] = rng.uniform(radius_max, img.rows - radius_max);
+                    stain[2] = rng.uniform(radius_min, radius_max);
+                }
+                break;
+            }
+            case DegradationOpKind::PRINTER_EFFECTS: {
+                const float intensity = step.params[0].draw(rng);
+                intensity_factor = std::max(0.0f, std::min(100.0f, intensity)) / 100.0f;
+                uchar even_adjustment, odd_adjustment;
+                std::tie(even_adjustment, odd_adjustment) = dithering_adjustments(intensity_factor);
+                apply_pointwise(passes, overlays, [&](uchar v, int parity) {
+                    return cv::saturate_cast<uchar>(v + (parity ? odd_adjustment : even_adjustment));
+                });
+                // le défaut d'impression est dessiné après le parcours (l'effet termine l'étape)
+                printer_effects = true;
+                printer_rng = rng;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (!passes.empty()) {
+        if (img.channels() == 3)
+            run_pixel_passes<3>(img, passes, master_seed, sheet);
+        else
+            run_pixel_passes<1>(img, passes, master_seed, sheet);
+    }
+    for (const StainOverlay& overlay : overlays)
+        paint_stains(img, overlay);
+    if (printer_effects)
+        add_printer_defect(img, printer_rng, intensity_factor);
+}
+
+/**
+ * @brief Exécute une étape SINGLE (bruit sel et poivre ou compression JPEG)
+ */
+void run_single_step(cv::Mat& img, const DegradationStep& step, uint64_t master_seed, uint64_t sheet) {
+    cv::RNG rng = stream_rng(master_seed, sheet, step.stream);
+    if (step.kind == DegradationOpKind::SALT_PEPPER) {
+        const float salt = step.params[0].draw(rng);
+        const float pepper = step.params[1].draw(rng);
+        add_salt_pepper_noise(img, rng, pepper, salt);
+    } else {
+        apply_jpeg_compression(img, (int) step.params[0].draw(rng));
+    }
+}
+} // namespace
+
+float ParamRange::draw(cv::RNG& rng) const {
+    if (min == max)
+        return min;
+    if (integer)
+        return (float) rng.uniform((int) min, (int) max);
+    return rng.uniform(min, max);
+}
+
+DegradationPipeline DegradationPipeline::compile(const json& spec) {
+    if (!spec.is_object())
+        throw std::invalid_argument("a degradation spec must be a JSON object");
+
+    DegradationPipeline pipeline;
+    if (spec.contains("margin")) {
+        if (!spec["margin"].is_number_integer() || spec["margin"].get<int>() < 0)
+            throw std::invalid_argument("'margin' must be a non-negative integer");
+        pipeline.margin_ = spec["margin"];
+    }
+    if (!spec.contains("ops") || !spec["ops"].is_array())
+        throw std::invalid_argument("a degradation spec needs an 'ops' array");
+
+    // chaque flux est celui de l'opération, plus 256 fois le nombre de ses occurrences précédentes
+    std::map<DegradationOp, uint32_t> occurrences;
+    auto next_stream = [&](DegradationOp op) { return (uint32_t) op + (occurrences[op]++ << 8); };
+
+    for (const json& op : spec["ops"]) {
+        DegradationStep step = parse_step(op);
+        const PipelineStage::Type type = stage_type(step.kind);
+
+        PipelineStage* current = pipeline.stages_.empty() ? nullptr : &pipeline.stages_.back();
+        bool join = current && current->type == type && type != PipelineStage::SINGLE;
+        if (join && type == PipelineStage::PIXELS) {
+            for (size_t index : current->steps) {
+                const DegradationOpKind kind = pipeline.steps_[index].kind;
+                // le défaut d'impression est dessiné à la fin de l'étape : rien ne peut suivre le tramage, et
+                // une tache n'a une valeur connue d'avance que si aucun bruit n'est tiré après elle
+                if (kind == DegradationOpKind::PRINTER_EFFECTS ||
+                    (kind == DegradationOpKind::INK_STAIN && step.kind == DegradationOpKind::GAUSSIAN_NOISE))
+                    join = false;
+            }
+        }
+
+        if (type == PipelineStage::WARP) {
+            // les opérations géométriques d'une même étape partagent un flux
+            step.stream = join ? pipeline.steps_[current->steps.front()].stream : next_stream(DegradationOp::GEOMETRY);
+        } else {
+            step.stream = next_stream(definition(step.kind).stream);
+        }
+        if (!join)
+            pipeline.stages_.push_back(PipelineStage{ type, {} });
+        pipeline.stages_.back().steps.push_back(pipeline.steps_.size());
+        pipeline.steps_.push_back(step);
+    }
+    return pipeline;
+}
+
+DegradationPipeline DegradationPipeline::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open())
+        throw std::runtime_error("could not open file '" + path + "'");
+
+    json spec;
+    try {
+        spec = json::parse(file);
+    } catch (const json::exception& e) {
+        throw std::runtime_error("could not json parse file '" + path + "': " + e.what());
+    }
+    return compile(spec);
+}
+
+void DegradationPipeline::run(cv::Mat& img, cv::Mat& modification_matrix, int seed, uint64_t sheet) const {
+    if (img.depth() != CV_8U || (img.channels() != 1 && img.channels() != 3))
+        throw std::invalid_argument("degradation pipelines only apply to 8-bit images with 1 or 3 channels");
+
+    const uint64_t master_seed = resolve_master_seed(seed);
+    const cv::Size padded_size(img.cols + 2 * margin_, img.rows + 2 * margin_);
+    cv::Mat geometry = cv::Mat::eye(3, 3, CV_32F);
+    bool padded = false;
+    auto pad = [&]() {
+        if (!padded && margin_ > 0)
+            cv::copyMakeBorder(img, img, margin_, margin_, margin_, margin_, cv::BORDER_CONSTANT,
+                               cv::Scalar(255, 255, 255));
+        padded = true;
+    };
+
+    for (const PipelineStage& stage : stages_) {
+        switch (stage.type) {
+            case PipelineStage::WARP: {
+                cv::RNG rng = stream_rng(master_seed, sheet, steps_[stage.steps.front()].stream);
+                const cv::Mat transformation = stage_geometry(steps_, stage, rng, padded_size);
+                geometry = transformation * geometry;
+
+                // la marge blanche n'est pas recopiée avant le premier warpAffine : la translation de la
+                // marge est composée avec la transformation, et le fond blanc de warpAffine en tient lieu
+                const cv::Mat warp = padded ? transformation : transformation * translate(margin_, margin_);
+                padded = true;
+                cv::Mat warped;
+                cv::warpAffine(img, warped, warp(cv::Rect(0, 0, 3, 2)), padded_size, cv::INTER_LINEAR,
+                               cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
+                img = warped;
+                break;
+            }
+            case PipelineStage::PIXELS:
+                pad();
+                run_pixel_stage(img, steps_, stage, master_seed, sheet);
+                break;
+            case PipelineStage::SINGLE:
+                pad();
+                run_single_step(img, steps_[stage.steps.front()], master_seed, sheet);
+                break;
+        }
+    }
+    pad();
+    modification_matrix = geometry(cv::Rect(0, 0, 3, 2)).clone();
+}
+
+std::string DegradationPipeline::describe() const {
+    std::string description;
+    for (const PipelineStage& stage : stages_) {
+        std::string names;
+        for (size_t index : stage.steps)
+            names += (names.empty() ? "" : ", ") + std::string(definition(steps_[index].kind).name);
+
+        if (!description.empty())
+            description += " -> ";
+        if (stage.type == PipelineStage::WARP)
+            description += "warp(" + names + ")";
+        else if (stage.type == PipelineStage::PIXELS)
+            description += "pixels(" + names + ")";
+        else
+            description += names;
+    }
+    return description;
+}
+
+const DegradationPipeline& default_degradation_pipeline() {
+    static const DegradationPipeline pipeline = DegradationPipeline::compile({
+        { "margin", MARGIN_COPY_MODIFIED },
+        { "ops", json::array({
+                     { { "op", "translate" }, { "dx", { MIN_TRANS, MAX_TRANS } }, { "dy", { MIN_TRANS, MAX_TRANS } } },
+                     { { "op", "rotate" }, { "flip_percent", FLIP_PERCENT }, { "angle", { MIN_ROTATE, MAX_ROTATE } } },
+                     { { "op", "salt_pepper" }, { "salt", { MIN_SALT, MAX_SALT } },
+                       { "pepper", { MIN_PEPPER, MAX_PEPPER } } },
+                     { { "op", "gaussian_noise" }, { "dispersion", { MIN_DISP, MAX_DISP } },
+                       { "offset", { MIN_OFFSET, MAX_OFFSET } } },
+                     { { "op", "contrast_brightness" }, { "contrast", { MIN_CONTRAST, MAX_CONTRAST } },
+                       { "bright", { MIN_BRIGHT, MAX_BRIGHT } } },
+                     { { "op", "ink_stain" }, { "count", { MIN_NB_SPOT, MAX_NB_SPOT } },
+                       { "radius_min", { MIN_RMIN, MAX_RMIN } }, { "radius_max", { MIN_RMAX, MAX_RMAX } } },
+                     { { "op", "printer_effects" }, { "intensity", { 60, 70 } } },
+                     { { "op", "jpeg_compression" }, { "quality", { 45, 55 } } },
+                 }) },
+    });
+    return pipeline;
+}
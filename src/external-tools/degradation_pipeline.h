@@ -0,0 +1,151 @@
+#ifndef DEGRADATION_PIPELINE_H
+#define DEGRADATION_PIPELINE_H
+
+/**
+ * @file degradation_pipeline.h
+ * @brief Chaînes de dégradation décrites en JSON et compilées en étapes fusionnées.
+ *
+ * Une chaîne est décrite par une marge et une liste ordonnée d'opérations :
+ *
+ *     { "margin": 100,
+ *       "ops": [ { "op": "translate", "dx": [-5, 5], "dy": [-5, 5] },
+ *                { "op": "rotate", "flip_percent": 20, "angle": [-5, 5] },
+ *                { "op": "gaussian_noise", "dispersion": [1, 5], "offset": [1, 5] },
+ *                { "op": "jpeg_compression", "quality": 50 } ] }
+ *
+ * Un paramètre est soit un nombre (valeur fixe), soit un intervalle [min, max] du JSON dans lequel la
+ * valeur est tirée uniformément à chaque exécution, max exclu : [min, max[ (par exemple, "count": [0, 8]
+ * donne de 0 à 7 taches). Les opérations sont appliquées dans l'ordre de la liste ;
+ * elles et leurs paramètres sont :
+ *   - rotate : flip_percent (probabilité en % d'ajouter 180 degrés, 0 par défaut), angle, autour du
+ *     centre de l'image agrandie ;
+ *   - translate : dx, dy ;
+ *   - salt_pepper : salt, pepper ;
+ *   - gaussian_noise : dispersion, offset ;
+ *   - contrast_brightness : contrast, bright ;
+ *   - ink_stain : count (positif), radius_min, radius_max (0 <= radius_min <= radius_max) ;
+ *   - printer_effects : intensity ;
+ *   - jpeg_compression : quality (de 0 à 100).
+ *
+ * La compilation regroupe les opérations en étapes : les rotations et translations consécutives sont
+ * composées en un seul warpAffine (la marge étant composée avec la première), les opérations par pixel
+ * consécutives (bruit gaussien, contraste, tramage et taches d'encre) sont appliquées en un seul
+ * parcours parallèle par bandes de lignes, les suites d'opérations déterministes y étant réduites à
+ * une table de correspondance. Les autres opérations restent des étapes isolées : le sel et poivre
+ * ne modifie le plus souvent qu'une fraction des pixels, tirés en bloc (add_salt_pepper_noise), et la
+ * compression JPEG porte sur l'image entière.
+ *
+ * Chaque opération tire ses nombres dans son propre flux (voir random_stream.h) : le résultat ne
+ * dépend que de la chaîne, de la graine maîtresse et de l'indice de la copie.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <common.h>
+
+/**
+ * @brief Opérations de dégradation connues des chaînes
+ */
+enum class DegradationOpKind {
+    ROTATE,
+    TRANSLATE,
+    SALT_PEPPER,
+    GAUSSIAN_NOISE,
+    CONTRAST_BRIGHTNESS,
+    INK_STAIN,
+    PRINTER_EFFECTS,
+    JPEG_COMPRESSION,
+};
+
+/**
+ * @brief Paramètre d'une opération : valeur fixe (min == max) ou tirée uniformément dans [min, max[
+ */
+struct ParamRange {
+    float min = 0;
+    float max = 0;
+    bool integer = false; ///< Tirage entier (cv::RNG::uniform(int, int))
+
+    /**
+     * @brief Valeur du paramètre ; rng n'est avancé que si le paramètre est un intervalle
+     */
+    float draw(cv::RNG& rng) const;
+};
+
+/**
+ * @brief Opération d'une chaîne compilée
+ */
+struct DegradationStep {
+    DegradationOpKind kind;
+    std::vector<ParamRange> params; ///< Dans l'ordre de op_definitions (degradation_pipeline.cpp)
+    uint32_t stream;                ///< Identifiant du flux aléatoire (DegradationOp, plus l'occurrence * 256)
+};
+
+/**
+ * @brief Étape d'exécution : un warpAffine, un parcours fusionné des pixels ou une opération isolée
+ */
+struct PipelineStage {
+    enum Type { WARP, PIXELS, SINGLE } type;
+    std::vector<size_t> steps; ///< Indices des opérations de l'étape dans la chaîne
+};
+
+/**
+ * @brief Chaîne de dégradation compilée, partagée par le modificateur et les benchmarks
+ *
+ * Une chaîne compilée n'est pas modifiée par run, qui peut être appelé depuis plusieurs threads.
+ */
+class DegradationPipeline {
+  public:
+    /**
+     * @brief Compile la description JSON d'une chaîne
+     *
+     * @throw std::invalid_argument Si une opération ou un paramètre est inconnu, manquant, mal formé ou hors
+     * de ses bornes
+     */
+    static DegradationPipeline compile(const json& spec);
+
+    /**
+     * @brief Compile la chaîne décrite par un fichier JSON
+     *
+     * @throw std::runtime_error Si le fichier ne peut pas être lu ou n'est pas du JSON valide
+     * @throw std::invalid_argument Si la description est invalide (voir compile)
+     */
+    static DegradationPipeline load(const std::string& path);
+
+    /**
+     * @brief Applique la chaîne à une image
+     *
+     * @param img Image à modifier (8 bits, 1 ou 3 canaux), agrandie de margin() pixels de chaque côté
+     * @param modification_matrix Matrice 2x3 (CV_32F) des opérations géométriques, dans les coordonnées
+     * de l'image agrandie
+     * @param seed Graine maîtresse des flux aléatoires (si 0, utilise le timestamp actuel)
+     * @param sheet Indice de la copie, pour que chaque copie d'un lot ait ses propres flux
+     * @throw std::invalid_argument Si l'image n'est pas en 8 bits à 1 ou 3 canaux
+     */
+    void run(cv::Mat& img, cv::Mat& modification_matrix, int seed = 0, uint64_t sheet = 0) const;
+
+    /**
+     * @brief Marge blanche ajoutée de chaque côté de l'image
+     */
+    int margin() const {
+        return margin_;
+    }
+
+    /**
+     * @brief Étapes compilées, par exemple "warp(translate, rotate) -> salt_pepper -> jpeg_compression"
+     */
+    std::string describe() const;
+
+  private:
+    int margin_ = 0;
+    std::vector<DegradationStep> steps_;
+    std::vector<PipelineStage> stages_;
+};
+
+/**
+ * @brief Chaîne appliquée par random_exec, décrite à partir de modifier_constants.h
+ */
+const DegradationPipeline& default_degradation_pipeline();
+
+#endif // DEGRADATION_PIPELINE_H
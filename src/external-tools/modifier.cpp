@@ -2,25 +2,74 @@
 #include <random>
 #include <iostream>
 #include "utils/math_utils.h"
+#include "utils/random_stream.h"
 #include "modifier_constants.h"
 #include "modifier.h"
+#include "degradation_pipeline.h"
 
-void add_salt_pepper_noise(cv::Mat& img, cv::RNG rng, float max_pepper, float max_salt) {
-    int amount1 = img.rows * img.cols * max_pepper / 100; // /100 pour passer un pourcentage entier en paramètre
-    int amount2 = img.rows * img.cols * max_salt / 100;
-    for (int counter = 0; counter < amount1; ++counter) {
-        if (img.channels() == 1) {
-            img.at<uchar>(rng.uniform(0, img.rows), rng.uniform(0, img.cols)) = 0;
-        } else if (img.channels() == 3) {
-            img.at<cv::Vec3b>(rng.uniform(0, img.rows), rng.uniform(0, img.cols)) = cv::Vec3b(0, 0, 0);
-        }
+// au-delà de cette proportion de pixels modifiés (en %), un tirage par pixel coûte moins cher que les indices
+#define SALT_PEPPER_MASK_PERCENT 5.0f
+
+/**
+ * @brief Affecte value aux pixels dont les indices (ligne * cols + colonne) ont été tirés
+ *
+ * Boucle scalaire volontairement : les écritures à des positions aléatoires n'ont pas d'équivalent
+ * vectoriel utile, et leur nombre (quelques pour cent des pixels au plus) est petit devant un parcours
+ * de l'image. Une image continue est indexée directement, sans division par ligne.
+ */
+template <typename T> static void scatter_pixels(cv::Mat& img, const cv::Mat& indices, const T& value) {
+    const int* index = indices.ptr<int>();
+    if (img.isContinuous()) {
+        T* pixels = img.ptr<T>();
+        for (int i = 0; i < indices.cols; ++i)
+            pixels[index[i]] = value;
+        return;
     }
-    for (int counter = 0; counter < amount2; ++counter) {
-        if (img.channels() == 1) {
-            img.at<uchar>(rng.uniform(0, img.rows), rng.uniform(0, img.cols)) = 255;
-        } else if (img.channels() == 3) {
-            img.at<cv::Vec3b>(rng.uniform(0, img.rows), rng.uniform(0, img.cols)) = cv::Vec3b(255, 255, 255);
-        }
+    for (int i = 0; i < indices.cols; ++i) {
+        img.ptr<T>(index[i] / img.cols)[index[i] % img.cols] = value;
+    }
+}
+
+/**
+ * @brief Générateur propre à une opération de dégradation d'une copie
+ */
+static cv::RNG op_rng(uint64_t seed, uint64_t sheet, DegradationOp op, uint32_t index = 0) {
+    return stream_rng(seed, sheet, (uint32_t) op, index);
+}
+
+void add_salt_pepper_noise(cv::Mat& img, cv::RNG& rng, float max_pepper, float max_salt) {
+    if (img.channels() != 1 && img.channels() != 3)
+        return;
+
+    if (max_pepper + max_salt >= SALT_PEPPER_MASK_PERCENT) {
+        // bruit dense : un tirage par pixel, puis deux masques appliqués par setTo
+        cv::Mat draw(img.size(), CV_32F);
+        rng.fill(draw, cv::RNG::UNIFORM, 0.0f, 100.0f);
+        img.setTo(cv::Scalar::all(0), draw < max_pepper);
+        img.setTo(cv::Scalar::all(255), draw >= 100.0f - max_salt);
+        return;
+    }
+
+    // bruit clairsemé : les positions sont tirées en un seul appel, le poivre puis le sel
+    const int nb_pixels = img.rows * img.cols;
+    const int amount1 = nb_pixels * max_pepper / 100; // /100 pour passer un pourcentage entier en paramètre
+    const int amount2 = nb_pixels * max_salt / 100;
+    cv::Mat indices;
+    if (amount1 > 0) {
+        indices.create(1, amount1, CV_32S);
+        rng.fill(indices, cv::RNG::UNIFORM, 0, nb_pixels);
+        if (img.channels() == 1)
+            scatter_pixels<uchar>(img, indices, 0);
+        else
+            scatter_pixels(img, indices, cv::Vec3b(0, 0, 0));
+    }
+    if (amount2 > 0) {
+        indices.create(1, amount2, CV_32S);
+        rng.fill(indices, cv::RNG::UNIFORM, 0, nb_pixels);
+        if (img.channels() == 1)
+            scatter_pixels<uchar>(img, indices, 255);
+        else
+            scatter_pixels(img, indices, cv::Vec3b(255, 255, 255));
     }
 }
 
@@ -34,7 +83,7 @@ void add_salt_pepper_noise(cv::Mat& img, cv::RNG rng, float max_pepper, float ma
  *
  */
 
-void add_gaussian_noise(cv::Mat& img, cv::RNG rng, int dispersion, int offset) {
+void add_gaussian_noise(cv::Mat& img, cv::RNG& rng, int dispersion, int offset) {
     cv::Mat noise = cv::Mat::zeros(img.size(), CV_32FC(img.channels()));
     rng.fill(noise, cv::RNG::NORMAL, percentage_to_dispersion(img.depth(), dispersion),
              percentage_to_offset(img.depth(), offset));
@@ -44,6 +93,17 @@ void add_gaussian_noise(cv::Mat& img, cv::RNG rng, int dispersion, int offset) {
     img_float.convertTo(img, img.type());
 }
 
+std::pair<float, float> contrast_brightness_coefficients(int contrast, int bright) {
+    if (contrast > 0 && contrast <= 100)
+        contrast += 50;
+    contrast = std::max(-100, std::min(100, contrast));
+    bright = std::max(-100, std::min(100, bright));
+
+    float alpha = 1.0f + (float(contrast) / 100.0f); // [0.0, 2.0]
+    float beta = float(bright) * 1.3f;               // [-130, 130]
+    return { alpha, beta };
+}
+
 /**
  * @brief Modification contraste et luminosité d'une image
  *
@@ -55,20 +115,17 @@ void add_gaussian_noise(cv::Mat& img, cv::RNG rng, int dispersion, int offset) {
  */
 
 void contrast_brightness_modifier(cv::Mat& img, int contrast, int bright) {
-    if (contrast > 0 && contrast <= 100)
-        contrast += 50;
-    contrast = std::max(-100, std::min(100, contrast));
-    bright = std::max(-100, std::min(100, bright));
-
-    float alpha = 1.0f + (float(contrast) / 100.0f); // [0.0, 2.0]
-    float beta = float(bright) * 1.3f;               // [-130, 130]
-
+    auto [alpha, beta] = contrast_brightness_coefficients(contrast, bright);
     img.convertTo(img, -1, alpha, beta);
 }
 
-void add_ink_stain(cv::Mat& image, cv::RNG rng, int nombreTaches, int rayonMin, int rayonMax) {
+void add_ink_stain(cv::Mat& image, cv::RNG& rng, int nombreTaches, int rayonMin, int rayonMax) {
     for (int i = 0; i < nombreTaches; i++) {
-        cv::Point centre(rng.uniform(rayonMax, image.cols - rayonMax), rng.uniform(rayonMax, image.rows - rayonMax));
+        // tirages séquencés x, y puis rayon, dans l'ordre de la chaîne fusionnée (l'ordre d'évaluation des
+        // arguments d'un constructeur n'est pas spécifié)
+        const int x = rng.uniform(rayonMax, image.cols - rayonMax);
+        const int y = rng.uniform(rayonMax, image.rows - rayonMax);
+        cv::Point centre(x, y);
         int rayon = rng.uniform(rayonMin, rayonMax);
         cv::Scalar color = cv::Scalar(1, 1, 1);
         cv::circle(image, centre, rayon, color, -1);
@@ -90,25 +147,29 @@ void translate_img(cv::Mat& img, int dx, int dy) {
     cv::warpAffine(img_out, img, affine, img.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
 }
 
-void distorsion_coef_exec(cv::Mat& img, cv::Mat& modification_matrix, float coef) {
-    int percent = 30;
+void distorsion_coef_exec(cv::Mat& img, cv::Mat& modification_matrix, float coef, int seed, uint64_t sheet) {
+    // le signe, commun à la rotation, à la translation et au contraste, est le premier tirage du flux
+    // géométrique ; les opérations de la chaîne ont ensuite des valeurs fixes et n'y tirent rien
+    const int master_seed = (int) resolve_master_seed(seed);
     float neg_value = 1 * coef;
-    if (time(0) % 2 == 0) {
+    cv::RNG geometry_rng = op_rng((uint32_t) master_seed, sheet, DegradationOp::GEOMETRY);
+    if (geometry_rng.uniform(0, 2) == 0) {
         neg_value = -neg_value;
     }
-    cv::RNG rng = cv::RNG(time(0));
-    cv::copyMakeBorder(img, img, percent, percent, percent, percent, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
-    cv::Mat img_out = img.clone();
-    modification_matrix = cv::Mat::eye(3, 3, CV_32F);
-    modification_matrix *= rotate_center(neg_value * 70, img_out.cols / 2, img_out.rows / 2);
-    modification_matrix *= translate(neg_value * 50, neg_value * 50);
-    modification_matrix = modification_matrix(cv::Rect(0, 0, 3, 2));
-    cv::warpAffine(img_out, img, modification_matrix, img.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT,
-                   cv::Scalar(255, 255, 255));
-    add_salt_pepper_noise(img, rng, coef * 50, coef * 50);
-    add_gaussian_noise(img, rng, coef * 50, coef * 50);
-    contrast_brightness_modifier(img, neg_value * 100, neg_value * 100);
-    add_ink_stain(img, rng, coef * MAX_NB_SPOT, rng.uniform(4, 8), rng.uniform(9, 35));
+    const DegradationPipeline pipeline = DegradationPipeline::compile({
+        { "margin", MARGIN_COPY_COEF },
+        { "ops", json::array({
+                     { { "op", "translate" }, { "dx", neg_value * 50 }, { "dy", neg_value * 50 } },
+                     { { "op", "rotate" }, { "angle", neg_value * 70 } },
+                     { { "op", "salt_pepper" }, { "salt", coef * 50 }, { "pepper", coef * 50 } },
+                     { { "op", "gaussian_noise" }, { "dispersion", coef * 50 }, { "offset", coef * 50 } },
+                     { { "op", "contrast_brightness" }, { "contrast", neg_value * 100 },
+                       { "bright", neg_value * 100 } },
+                     { { "op", "ink_stain" }, { "count", (int) (coef * MAX_NB_SPOT) }, { "radius_min", { 4, 8 } },
+                       { "radius_max", { 9, 35 } } },
+                 }) },
+    });
+    pipeline.run(img, modification_matrix, master_seed, sheet);
 }
 /**
  * @brief Applique une compression JPEG à une image avec un niveau de qualité spécifié
@@ -130,58 +191,39 @@ void apply_jpeg_compression(cv::Mat& img, int quality) {
 }
 
 /**
- * @brief Simule des effets d'impression sur une image
+ * @brief Ajoute à chaque ligne de l'image l'un de deux réglages, alternés en damier
  *
- * @param img Image à modifier
- * @param rng Générateur de nombres aléatoires
- * @param intensity Intensité des effets (entre 0 et 100)
+ * Le pixel (x, y) reçoit odd_adjustment si x + y est impair, even_adjustment sinon, sur chacun
+ * de ses CN canaux (addition saturée). Les deux lignes de réglages possibles sont construites
+ * une seule fois, puis ajoutées ligne par ligne par cv::add, en parallèle par bandes de lignes.
  */
-void simulate_printer_effects(cv::Mat& img, cv::RNG& rng, float intensity) {
-    intensity = std::max(0.0f, std::min(100.0f, intensity));
-    float intensity_factor = intensity / 100.0f;
-
-    // Convertir l'image en niveaux de gris temporairement si elle est en couleur
-    cv::Mat gray_img;
-    bool isColor = img.channels() == 3;
-    if (isColor) {
-        cv::cvtColor(img, gray_img, cv::COLOR_BGR2GRAY);
-    } else {
-        gray_img = img.clone();
+template <int CN> static void add_checkerboard(cv::Mat& img, uchar even_adjustment, uchar odd_adjustment) {
+    const int width = img.cols * CN;
+    cv::Mat adjustments(2, width, CV_8U);
+    for (int parity = 0; parity < 2; parity++) {
+        uchar* adjustment = adjustments.ptr<uchar>(parity);
+        for (int x = 0; x < img.cols; x++) {
+            const uchar value = ((x ^ parity) & 1) ? odd_adjustment : even_adjustment;
+            for (int c = 0; c < CN; c++)
+                adjustment[x * CN + c] = value;
+        }
     }
 
-    // Appliquer systématiquement l'effet de tramage/dithering
-    {
-        // Effet de tramage/dithering (pattern artificiels)
-        cv::Mat pattern(8, 8, CV_8UC1);
-        for (int y = 0; y < pattern.rows; y++) {
-            for (int x = 0; x < pattern.cols; x++) {
-                // Créer un motif de tramage Floyd-Steinberg simplifié
-                pattern.at<uchar>(y, x) = ((x ^ y) & 1) ? 10 : -10;
-            }
+    cv::parallel_for_(cv::Range(0, img.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            cv::Mat row(1, width, CV_8U, img.ptr<uchar>(y));
+            cv::add(row, adjustments.row(y & 1), row);
         }
+    });
+}
 
-        // Appliquer le motif à l'image avec l'intensité donnée
-        for (int y = 0; y < img.rows; y++) {
-            for (int x = 0; x < img.cols; x++) {
-                int pattern_val = pattern.at<uchar>(y % pattern.rows, x % pattern.cols);
-                int adjustment = pattern_val * intensity_factor *
-                                 0.5f; // Réduire légèrement l'intensité pour le dithering systématique
-
-                if (isColor) {
-                    cv::Vec3b pixel = img.at<cv::Vec3b>(y, x);
-                    pixel[0] = cv::saturate_cast<uchar>(pixel[0] + adjustment);
-                    pixel[1] = cv::saturate_cast<uchar>(pixel[1] + adjustment);
-                    pixel[2] = cv::saturate_cast<uchar>(pixel[2] + adjustment);
-                    img.at<cv::Vec3b>(y, x) = pixel;
-                } else {
-                    uchar pixel = img.at<uchar>(y, x);
-                    img.at<uchar>(y, x) = cv::saturate_cast<uchar>(pixel + adjustment);
-                }
-            }
-        }
-    }
+std::pair<uchar, uchar> dithering_adjustments(float intensity_factor) {
+    const int odd_adjustment = 10 * intensity_factor * 0.5f;
+    const int even_adjustment = (uchar) -10 * intensity_factor * 0.5f;
+    return { (uchar) even_adjustment, (uchar) odd_adjustment };
+}
 
-    // En plus du tramage, appliquer un effet aléatoire supplémentaire
+void add_printer_defect(cv::Mat& img, cv::RNG& rng, float intensity_factor) {
     int effect_type = rng.uniform(1, 3); // Maintenant seulement 3 types d'effets différents (sans le dithering)
 
     switch (effect_type) {
@@ -244,23 +286,43 @@ void simulate_printer_effects(cv::Mat& img, cv::RNG& rng, float intensity) {
     }
 }
 
-void random_exec(cv::Mat& img, cv::Mat& modification_matrix, int seed) {
-    cv::RNG rng;
-    if (seed)
-        rng = cv::RNG(seed);
-    else {
-        seed = static_cast<int>(time(0));
-        rng = cv::RNG(seed);
-    }
+/**
+ * @brief Simule des effets d'impression sur une image
+ *
+ * @param img Image à modifier
+ * @param rng Générateur de nombres aléatoires
+ * @param intensity Intensité des effets (entre 0 et 100)
+ */
+void simulate_printer_effects(cv::Mat& img, cv::RNG& rng, float intensity) {
+    intensity = std::max(0.0f, std::min(100.0f, intensity));
+    float intensity_factor = intensity / 100.0f;
 
-    // expend image
-    int pixel_offset = MARGIN_COPY_MODIFIED;
-    cv::copyMakeBorder(img, img, pixel_offset, pixel_offset, pixel_offset, pixel_offset, cv::BORDER_CONSTANT,
-                       cv::Scalar(255, 255, 255));
-    cv::Mat img_out = img.clone();
+    // Appliquer systématiquement l'effet de tramage/dithering
+    auto [even_adjustment, odd_adjustment] = dithering_adjustments(intensity_factor);
+    if (img.channels() == 3)
+        add_checkerboard<3>(img, even_adjustment, odd_adjustment);
+    else
+        add_checkerboard<1>(img, even_adjustment, odd_adjustment);
+
+    // En plus du tramage, appliquer un effet aléatoire supplémentaire
+    add_printer_defect(img, rng, intensity_factor);
+}
+
+/**
+ * @brief Tire la transformation géométrique de random_exec (retournement éventuel, rotation, translation)
+ *
+ * @param rng Générateur de nombres aléatoires
+ * @param padded_size Taille de l'image agrandie de MARGIN_COPY_MODIFIED de chaque côté
+ * @return cv::Mat Matrice 3x3 (CV_32F) exprimée dans les coordonnées de l'image agrandie
+ */
+static cv::Mat random_geometry(cv::RNG& rng, const cv::Size& padded_size) {
+    // la translation est tirée en premier, dx puis dy, dans l'ordre où elle est appliquée à l'image (comme
+    // les opérations de default_degradation_pipeline)
+    const int dx = rng.uniform(MIN_TRANS, MAX_TRANS);
+    const int dy = rng.uniform(MIN_TRANS, MAX_TRANS);
 
     // Déterminer si l'image doit être complètement retournée (rotation à 180 degrés)
-    bool flip_image = rng.uniform(0, 10) < 2; // ~20% de chance de retourner l'image
+    bool flip_image = rng.uniform(0, 100) < FLIP_PERCENT;
 
     // Calculer l'angle de rotation
     float rotation_angle;
@@ -272,22 +334,61 @@ void random_exec(cv::Mat& img, cv::Mat& modification_matrix, int seed) {
         rotation_angle = rng.uniform(MIN_ROTATE, MAX_ROTATE);
     }
 
+    cv::Mat geometry = cv::Mat::eye(3, 3, CV_32F);
+    geometry *= rotate_center(rotation_angle, padded_size.width / 2, padded_size.height / 2);
+    geometry *= translate(dx, dy);
+    return geometry;
+}
+
+void random_exec_sequential(cv::Mat& img, cv::Mat& modification_matrix, int seed, uint64_t sheet) {
+    const uint64_t stream = resolve_master_seed(seed);
+
+    // expend image
+    int pixel_offset = MARGIN_COPY_MODIFIED;
+    cv::copyMakeBorder(img, img, pixel_offset, pixel_offset, pixel_offset, pixel_offset, cv::BORDER_CONSTANT,
+                       cv::Scalar(255, 255, 255));
+    cv::Mat img_out = img.clone();
+
     // Appliquer la rotation
-    modification_matrix = cv::Mat::eye(3, 3, CV_32F);
-    modification_matrix *= rotate_center(rotation_angle, img_out.cols / 2, img_out.rows / 2);
-    modification_matrix *= translate(rng.uniform(MIN_TRANS, MAX_TRANS), rng.uniform(MIN_TRANS, MAX_TRANS));
-    modification_matrix = modification_matrix(cv::Rect(0, 0, 3, 2));
+    cv::RNG geometry_rng = op_rng(stream, sheet, DegradationOp::GEOMETRY);
+    modification_matrix = random_geometry(geometry_rng, img_out.size())(cv::Rect(0, 0, 3, 2));
     cv::warpAffine(img_out, img, modification_matrix, img.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT,
                    cv::Scalar(255, 255, 255));
-    add_salt_pepper_noise(img, rng, rng.uniform(MIN_SALT, MAX_SALT), rng.uniform(MIN_PEPPER, MAX_PEPPER));
-    add_gaussian_noise(img, rng, rng.uniform(MIN_DISP, MAX_DISP), rng.uniform(MIN_OFFSET, MAX_OFFSET));
-    contrast_brightness_modifier(img, rng.uniform(MIN_CONTRAST, MAX_CONTRAST), rng.uniform(MIN_BRIGHT, MAX_BRIGHT));
-    add_ink_stain(img, rng, rng.uniform(MIN_NB_SPOT, MAX_NB_SPOT), rng.uniform(MIN_RMIN, MAX_RMIN),
-                  rng.uniform(MIN_RMAX, MAX_RMAX));
+
+    cv::RNG salt_pepper_rng = op_rng(stream, sheet, DegradationOp::SALT_PEPPER);
+    const float max_salt = salt_pepper_rng.uniform(MIN_SALT, MAX_SALT);
+    const float max_pepper = salt_pepper_rng.uniform(MIN_PEPPER, MAX_PEPPER);
+    add_salt_pepper_noise(img, salt_pepper_rng, max_pepper, max_salt);
+
+    cv::RNG noise_rng = op_rng(stream, sheet, DegradationOp::GAUSSIAN_NOISE);
+    const int dispersion = noise_rng.uniform(MIN_DISP, MAX_DISP);
+    const int offset = noise_rng.uniform(MIN_OFFSET, MAX_OFFSET);
+    add_gaussian_noise(img, noise_rng, dispersion, offset);
+
+    cv::RNG contrast_rng = op_rng(stream, sheet, DegradationOp::CONTRAST_BRIGHTNESS);
+    const int contrast = contrast_rng.uniform(MIN_CONTRAST, MAX_CONTRAST);
+    const int bright = contrast_rng.uniform(MIN_BRIGHT, MAX_BRIGHT);
+    contrast_brightness_modifier(img, contrast, bright);
+
+    cv::RNG stain_rng = op_rng(stream, sheet, DegradationOp::INK_STAIN);
+    const int nb_stains = stain_rng.uniform(MIN_NB_SPOT, MAX_NB_SPOT);
+    const int radius_min = stain_rng.uniform(MIN_RMIN, MAX_RMIN);
+    const int radius_max = stain_rng.uniform(MIN_RMAX, MAX_RMAX);
+    add_ink_stain(img, stain_rng, nb_stains, radius_min, radius_max);
 
     // Simuler des effets d'impression avec une intensité aléatoire
-    simulate_printer_effects(img, rng, rng.uniform(60, 70));
+    cv::RNG printer_rng = op_rng(stream, sheet, DegradationOp::PRINTER_EFFECTS);
+    simulate_printer_effects(img, printer_rng, printer_rng.uniform(60, 70));
 
     // Ajouter une compression JPEG
-    apply_jpeg_compression(img, rng.uniform(45, 55));
-}
\ No newline at end of file
+    cv::RNG jpeg_rng = op_rng(stream, sheet, DegradationOp::JPEG_COMPRESSION);
+    apply_jpeg_compression(img, jpeg_rng.uniform(45, 55));
+}
+
+void random_exec(cv::Mat& img, cv::Mat& modification_matrix, int seed, uint64_t sheet) {
+    if (img.depth() != CV_8U || (img.channels() != 1 && img.channels() != 3)) {
+        random_exec_sequential(img, modification_matrix, seed, sheet);
+        return;
+    }
+    default_degradation_pipeline().run(img, modification_matrix, seed, sheet);
+}
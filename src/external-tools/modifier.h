@@ -11,29 +11,52 @@
  */
 
 #include "modifier_constants.h"
+#include <cstdint>
+#include <utility>
 #include <opencv2/opencv.hpp>
 
 #define MARGIN_COPY_MODIFIED 100
+#define MARGIN_COPY_COEF 30
+
+/**
+ * @brief Opérations de dégradation, chacune tirant ses nombres aléatoires dans son propre flux
+ *
+ * La valeur sert de compteur au générateur Philox (voir stream_rng) : une opération ajoutée doit
+ * prendre une nouvelle valeur à la fin pour ne pas changer les tirages des autres.
+ */
+enum class DegradationOp : uint32_t {
+    GEOMETRY,            ///< Retournement, rotation et translation
+    SALT_PEPPER,         ///< Bruit sel et poivre
+    GAUSSIAN_NOISE,      ///< Bruit gaussien (sous-flux 1, 2... : bandes de lignes du parcours fusionné)
+    CONTRAST_BRIGHTNESS, ///< Contraste et luminosité
+    INK_STAIN,           ///< Taches d'encre
+    PRINTER_EFFECTS,     ///< Tramage et défauts d'impression
+    JPEG_COMPRESSION,    ///< Qualité de la compression JPEG
+};
 
 /**
  * @brief Ajoute du bruit de type "sel et poivre" à une image
- * 
- * @param img Image à modifier
- * @param rng Générateur de nombres aléatoires
+ *
+ * Les positions des pixels modifiés sont tirées en un seul appel au générateur puis écrites
+ * directement ; au-delà de quelques pourcents de pixels modifiés, un tirage par pixel est
+ * converti en masques appliqués par setTo.
+ *
+ * @param img Image à modifier (1 ou 3 canaux, 8 bits)
+ * @param rng Générateur de nombres aléatoires, avancé par l'appel
  * @param max_pepper Pourcentage maximal de pixels noirs à ajouter
  * @param max_salt Pourcentage maximal de pixels blancs à ajouter
  */
-void add_salt_pepper_noise(cv::Mat& img, cv::RNG rng, float max_pepper, float max_salt);
+void add_salt_pepper_noise(cv::Mat& img, cv::RNG& rng, float max_pepper, float max_salt);
 
 /**
  * @brief Ajout de bruit gaussien à une image
  *
  * @param img Image à modifier
- * @param rng Générateur de nombres aléatoires
+ * @param rng Générateur de nombres aléatoires, avancé par l'appel
  * @param dispersion Niveau de dispersion du bruit
  * @param offset Décalage pour le bruit
  */
-void add_gaussian_noise(cv::Mat& img, cv::RNG rng, int dispersion, int offset);
+void add_gaussian_noise(cv::Mat& img, cv::RNG& rng, int dispersion, int offset);
 
 /**
  * @brief Modification du contraste et de la luminosité d'une image
@@ -44,16 +67,21 @@ void add_gaussian_noise(cv::Mat& img, cv::RNG rng, int dispersion, int offset);
  */
 void contrast_brightness_modifier(cv::Mat& img, int contrast, int bright);
 
+/**
+ * @brief Coefficients (alpha, beta) appliqués par contrast_brightness_modifier : pixel * alpha + beta
+ */
+std::pair<float, float> contrast_brightness_coefficients(int contrast, int bright);
+
 /**
  * @brief Ajoute des taches d'encre aléatoires sur l'image
  *
  * @param image Image à modifier
- * @param rng Générateur de nombres aléatoires
+ * @param rng Générateur de nombres aléatoires, avancé par l'appel
  * @param nombreTaches Nombre de taches à ajouter
  * @param rayonMin Rayon minimal des taches
  * @param rayonMax Rayon maximal des taches
  */
-void add_ink_stain(cv::Mat& image, cv::RNG rng, int nombreTaches, int rayonMin, int rayonMax);
+void add_ink_stain(cv::Mat& image, cv::RNG& rng, int nombreTaches, int rayonMin, int rayonMax);
 
 /**
  * @brief Applique une rotation à l'image autour de son centre
@@ -76,17 +104,43 @@ void translate_img(cv::Mat& img, int dx, int dy);
  * @brief Applique une distorsion à l'image avec un coefficient d'intensité
  *
  * Cette fonction combine rotation, translation, bruit et autres effets
- * avec une intensité proportionnelle au coefficient fourni.
+ * avec une intensité proportionnelle au coefficient fourni. Les effets sont appliqués par une chaîne
+ * de dégradation (voir degradation_pipeline.h) dont les valeurs dépendent du coefficient et d'un
+ * signe tiré au hasard.
  *
  * @param img Image à modifier
  * @param modification_matrix Matrice de modification retournée par référence
  * @param coef Coefficient d'intensité des modifications
+ * @param seed Graine maîtresse des flux aléatoires (si 0, utilise le timestamp actuel)
+ * @param sheet Indice de la copie, pour que chaque copie d'un lot ait ses propres flux
+ * @throw std::invalid_argument Si l'image n'est pas en 8 bits à 1 ou 3 canaux
  */
-void distorsion_coef_exec(cv::Mat& img, cv::Mat& modification_matrix, float coef);
+void distorsion_coef_exec(cv::Mat& img, cv::Mat& modification_matrix, float coef, int seed = 0, uint64_t sheet = 0);
 void apply_jpeg_compression(cv::Mat& img, int quality);
 
 void simulate_printer_effects(cv::Mat& img, cv::RNG& rng, float intensity);
 
+/**
+ * @brief Réglages du tramage de simulate_printer_effects, pour les pixels pairs et impairs du damier
+ *
+ * Le motif 8x8 d'origine, ((x ^ y) & 1) ? 10 : -10 rangé dans des uchar, vaut 10 ou 246 (-10 modulo 256)
+ * et se réduit à un damier de deux réglages positifs. Ils sont calculés comme avant (float tronqué en
+ * int) pour produire exactement la même image.
+ *
+ * @param intensity_factor Intensité des effets ramenée entre 0 et 1
+ * @return std::pair<uchar, uchar> Réglages des pixels où x + y est pair, puis impair
+ */
+std::pair<uchar, uchar> dithering_adjustments(float intensity_factor);
+
+/**
+ * @brief Défaut d'impression aléatoire ajouté par simulate_printer_effects après le tramage
+ *
+ * @param img Image à modifier
+ * @param rng Générateur de nombres aléatoires, avancé par l'appel
+ * @param intensity_factor Intensité des effets ramenée entre 0 et 1
+ */
+void add_printer_defect(cv::Mat& img, cv::RNG& rng, float intensity_factor);
+
 /**
  * @brief Exécute une série de transformations aléatoires sur une image
  *
@@ -94,10 +148,35 @@ void simulate_printer_effects(cv::Mat& img, cv::RNG& rng, float intensity);
  * des conditions réelles de numérisation: bruit, rotation, taches,
  * compression, effets d'impression, etc.
  *
- * @param img Image à modifier
+ * Les effets sont ceux de default_degradation_pipeline (voir degradation_pipeline.h) : la marge, la
+ * rotation et la translation sont appliquées par un seul warpAffine ; le bruit gaussien, le contraste,
+ * la luminosité, le tramage et les taches d'encre sont ensuite appliqués en un seul parcours parallèle
+ * de l'image, la compression JPEG restant la dernière étape.
+ *
+ * Chaque opération (DegradationOp) tire ses nombres dans le flux (seed, sheet, opération) : l'image
+ * obtenue ne dépend que de seed et sheet, ni de l'ordre dans lequel les copies sont dégradées ni du
+ * nombre de threads. Pour une même graine, seuls les tirages du bruit gaussien diffèrent de
+ * random_exec_sequential : les deux versions tirent les autres paramètres dans le même ordre, y compris
+ * le centre (x puis y) et le rayon de chaque tache. Les images qui ne sont pas en 8 bits à 1 ou 3 canaux sont traitées par
+ * random_exec_sequential.
+ *
+ * @param img Image à modifier, agrandie de MARGIN_COPY_MODIFIED pixels de chaque côté
+ * @param modification_matrix Matrice de modification retournée par référence
+ * @param seed Graine maîtresse des flux aléatoires (si 0, utilise le timestamp actuel)
+ * @param sheet Indice de la copie, pour que chaque copie d'un lot ait ses propres flux
+ */
+void random_exec(cv::Mat& img, cv::Mat& modification_matrix, int seed = 0, uint64_t sheet = 0);
+
+/**
+ * @brief Version de random_exec appliquant chaque transformation l'une après l'autre
+ *
+ * Chaque effet parcourt l'image entière ; conservée comme référence pour degradation-bench.
+ *
+ * @param img Image à modifier, agrandie de MARGIN_COPY_MODIFIED pixels de chaque côté
  * @param modification_matrix Matrice de modification retournée par référence
- * @param seed Seed pour initialiser le générateur aléatoire (si 0, utilise le timestamp actuel)
+ * @param seed Graine maîtresse des flux aléatoires (si 0, utilise le timestamp actuel)
+ * @param sheet Indice de la copie, pour que chaque copie d'un lot ait ses propres flux
  */
-void random_exec(cv::Mat& img, cv::Mat& modification_matrix, int seed = 0);
+void random_exec_sequential(cv::Mat& img, cv::Mat& modification_matrix, int seed = 0, uint64_t sheet = 0);
 
 #endif
\ No newline at end of file
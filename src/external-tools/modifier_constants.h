@@ -17,6 +17,12 @@
 constexpr float MIN_ROTATE = -5.0f;
 constexpr float MAX_ROTATE = 5.0f;
 
+/**
+ * Probabilité (en %) de retourner complètement l'image (rotation de 180 degrés)
+ * avant la rotation aléatoire.
+ */
+constexpr int FLIP_PERCENT = 20;
+
 /**
  * Paramètres de translation
  * Définissent les déplacements minimaux et maximaux (en pixels)
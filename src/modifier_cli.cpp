@@ -24,6 +24,15 @@
  *    ./modifier input.jpg -sp=2,3 -cb=50,10 -r=5
  *    Applique uniquement les transformations spécifiées avec les paramètres donnés
  *
+ * 5. Mode chaîne décrite en JSON:
+ *    ./modifier input.jpg -pipeline=chaine.json -seed=123
+ *    Applique la chaîne de dégradation décrite dans le fichier (voir degradation_pipeline.h)
+ *
+ * 6. Mode batch:
+ *    ./modifier -batch=copies/ -out=modified -jobs=0 -seeds=1,10
+ *    Applique l'un des modes précédents à toutes les images d'un répertoire ou d'un fichier liste,
+ *    en parallèle, et écrit un manifeste (images produites, graines, paramètres, matrices)
+ *
  * ## Options disponibles:
  *   -sp=s,p     : Bruit sel & poivre (salt %, pepper %)
  *   -g=d,o      : Bruit gaussien (dispersion, offset)
@@ -31,8 +40,15 @@
  *   -s=n,min,max: Taches d'encre (nombre, rayon min, rayon max)
  *   -r=angle    : Rotation (angle en degrés)
  *   -t=dx,dy    : Translation (déplacement x, déplacement y)
- *   -seed=n     : Initialisation du générateur aléatoire (nombre entier)
+ *   -seed=n     : Initialisation du générateur aléatoire (nombre entier ; sinon tirée et affichée)
  *   -coef=n     : Coefficient de distorsion (valeur entre 0 et 1)
+ *   -pipeline=f : Chaîne de dégradation décrite dans le fichier JSON f
+ *
+ * ## Options du mode batch:
+ *   -batch=src  : Répertoire d'images ou fichier liste (un chemin par ligne), en premier argument
+ *   -out=dir    : Répertoire de sortie et du manifeste manifest.json (défaut: modified)
+ *   -jobs=n     : Nombre d'images traitées en parallèle (défaut: 1, 0: nombre de cœurs)
+ *   -seeds=a,b  : Une image produite par graine de a à b
  */
 
 #include <iostream>
@@ -41,8 +57,15 @@
 #include <string.h>
 #include <random>
 #include <tuple>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <map>
+#include <optional>
 #include "utils/math_utils.h"
+#include "utils/thread_pool.h"
 #include "external-tools/modifier.h"
+#include "external-tools/degradation_pipeline.h"
 
 
 /**
@@ -128,6 +151,172 @@ bool parse_numeric_arg(int argc, char const* argv[], const std::string& prefix,
     return false;
 }
 
+/**
+ * @brief Transformations demandées explicitement (-sp=, -g=, -cb=, -s=, -r=, -t=)
+ */
+struct DegradationSpec {
+    std::optional<std::tuple<int, int>> salt_pepper;         ///< -sp= : sel, poivre
+    std::optional<std::tuple<int, int>> gaussian;            ///< -g= : offset, dispersion
+    std::optional<std::tuple<int, int>> contrast_brightness; ///< -cb= : contraste, luminosité
+    std::optional<std::tuple<int, int, int>> ink_stains;     ///< -s= : nombre, rayon min, rayon max
+    std::optional<int> rotation;                             ///< -r= : angle en degrés
+    std::optional<std::tuple<int, int>> translation;         ///< -t= : dx, dy
+
+    bool empty() const {
+        return !salt_pepper && !gaussian && !contrast_brightness && !ink_stains && !rotation && !translation;
+    }
+};
+
+/**
+ * @brief Lit les transformations explicites de la ligne de commande
+ *
+ * Le programme s'arrête avec un message d'erreur si l'une d'elles est mal formée.
+ *
+ * @param argc Nombre d'arguments
+ * @param argv Tableau d'arguments
+ * @return DegradationSpec Transformations trouvées (éventuellement aucune)
+ */
+DegradationSpec parse_spec(int argc, char const* argv[]) {
+    static const std::vector<std::string> poss_opt = { "-s=", "-g=", "-cb=", "-sp=", "-r=", "-t=", "-nb=" };
+    std::map<std::string, std::string> parsed_opts;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg(argv[i]);
+        for (const auto& opt : poss_opt) {
+            // Vérifie que l'argument commence par opt
+            if (arg.rfind(opt, 0) == 0) {
+                // Extrait la valeur après le '='
+                std::string value = arg.substr(opt.size());
+                // Stocke en mappant l'option à sa valeur
+                parsed_opts[opt] = value;
+                break; // passe à l'argument suivant
+            }
+        }
+    }
+
+    DegradationSpec spec;
+    auto parse_pair = [&](const std::string& opt, std::optional<std::tuple<int, int>>& value, const char* expected) {
+        auto it = parsed_opts.find(opt);
+        if (it == parsed_opts.end())
+            return;
+        value = parse_2(it->second);
+        if (!value) {
+            std::cerr << "Erreur dans le format de " << opt << " (attendu: " << expected << ")\n";
+            exit(1);
+        }
+    };
+    parse_pair("-sp=", spec.salt_pepper, "salt, pepper");
+    parse_pair("-g=", spec.gaussian, "offset, dispersion");
+    parse_pair("-cb=", spec.contrast_brightness, "contrast, bright");
+    parse_pair("-t=", spec.translation, "dx, dy");
+    if (auto it = parsed_opts.find("-s="); it != parsed_opts.end()) {
+        spec.ink_stains = parse_3(it->second);
+        if (!spec.ink_stains) {
+            std::cerr << "Erreur dans le format de -s= (attendu: nb spot, min radius, max radius)\n";
+            exit(1);
+        }
+    }
+    if (auto it = parsed_opts.find("-r="); it != parsed_opts.end()) {
+        spec.rotation = std::stof(it->second); // conversion sans surcoût
+    }
+    return spec;
+}
+
+/**
+ * @brief Cherche un argument texte de la ligne de commande
+ *
+ * @param argc Nombre d'arguments
+ * @param argv Tableau d'arguments
+ * @param prefix Préfixe de l'argument à analyser (ex: "-out=")
+ * @param value Variable où stocker la valeur extraite
+ * @return true si l'argument a été trouvé
+ */
+bool parse_string_arg(int argc, char const* argv[], const std::string& prefix, std::string& value) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.rfind(prefix, 0) == 0) {
+            value = arg.substr(prefix.size());
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Compile la chaîne de dégradation d'un fichier JSON (-pipeline=), ou quitte en cas d'erreur
+ */
+DegradationPipeline load_pipeline(const std::string& path) {
+    try {
+        DegradationPipeline pipeline = DegradationPipeline::load(path);
+        std::cout << "Chaîne de dégradation : " << pipeline.describe() << std::endl;
+        return pipeline;
+    } catch (const std::exception& e) {
+        std::cerr << "Erreur dans -pipeline= : " << e.what() << std::endl;
+        exit(1);
+    }
+}
+
+/**
+ * @brief Applique les transformations explicites, dans l'ordre -sp, -g, -cb, -s, -r, -t
+ *
+ * Les transformations forment une chaîne sans marge, exécutée par le moteur de random_exec (voir
+ * degradation_pipeline.h) : -g, -cb et -s sont appliqués en un seul parcours de l'image, -r et -t par
+ * un seul warpAffine.
+ *
+ * @param img Image à modifier
+ * @param spec Transformations à appliquer
+ * @param seed Graine des flux aléatoires (bruits et taches)
+ * @param sheet Indice de la copie
+ * @param modification_matrix Matrice 2x3 de la rotation suivie de la translation (identité sans -r ni -t)
+ * @return json Paramètres appliqués, indexés par nom d'option
+ */
+json apply_spec(cv::Mat& img, const DegradationSpec& spec, int seed, uint64_t sheet, cv::Mat& modification_matrix) {
+    json params = json::object();
+    json ops = json::array();
+    if (spec.salt_pepper) {
+        auto [salt, pepper] = *spec.salt_pepper;
+        ops.push_back({ { "op", "salt_pepper" }, { "salt", salt }, { "pepper", pepper } });
+        params["sp"] = { salt, pepper };
+    }
+    if (spec.gaussian) {
+        auto [dispersion, offset] = *spec.gaussian;
+        ops.push_back({ { "op", "gaussian_noise" }, { "dispersion", dispersion }, { "offset", offset } });
+        params["g"] = { dispersion, offset };
+    }
+    if (spec.contrast_brightness) {
+        auto [contrast, bright] = *spec.contrast_brightness;
+        ops.push_back({ { "op", "contrast_brightness" }, { "contrast", contrast }, { "bright", bright } });
+        params["cb"] = { contrast, bright };
+    }
+    if (spec.ink_stains) {
+        auto [nb_spot, min_radius, max_radius] = *spec.ink_stains;
+        ops.push_back({ { "op", "ink_stain" },
+                        { "count", nb_spot },
+                        { "radius_min", min_radius },
+                        { "radius_max", max_radius } });
+        params["s"] = { nb_spot, min_radius, max_radius };
+    }
+    if (spec.rotation) {
+        ops.push_back({ { "op", "rotate" }, { "angle", *spec.rotation } });
+        params["r"] = *spec.rotation;
+    }
+    if (spec.translation) {
+        auto [dx, dy] = *spec.translation;
+        ops.push_back({ { "op", "translate" }, { "dx", dx }, { "dy", dy } });
+        params["t"] = { dx, dy };
+    }
+    DegradationPipeline::compile({ { "ops", ops } }).run(img, modification_matrix, seed, sheet);
+    return params;
+}
+
+/**
+ * @brief Graine tirée de l'heure courante quand -seed= n'est pas donné, affichée pour pouvoir rejouer l'image
+ */
+int draw_seed() {
+    const int seed = (int) time(0);
+    std::cout << "Graine : " << seed << " (-seed=" << seed << " pour reproduire l'image)" << std::endl;
+    return seed;
+}
+
 /**
  * @brief Traite les arguments de la ligne de commande et applique les transformations demandées
  *
@@ -138,13 +327,13 @@ bool parse_numeric_arg(int argc, char const* argv[], const std::string& prefix,
  * - Mode distorsion avec coefficient (-coef=)
  * - Mode transformations spécifiques (-sp=, -g=, -cb=, -s=, -r=, -t=)
  *
+ * Sans -seed=, la graine est tirée de l'heure courante et affichée.
+ *
  * @param img L'image à modifier
  * @param argc Nombre d'arguments
  * @param argv Tableau d'arguments
  */
 void gestion_arg(cv::Mat& img, int argc, char const* argv[]) {
-    // juste sous votre prototype de gestion_arg()
-    static const std::vector<std::string> poss_opt = { "-s=", "-g=", "-cb=", "-sp=", "-r=", "-t=", "-nb=" };
     if (argc < 2) {
         std::cerr << "call -> usage() -> exit()" << std::endl;
         exit(1);
@@ -152,7 +341,17 @@ void gestion_arg(cv::Mat& img, int argc, char const* argv[]) {
     cv::Mat mat;
     // CAS TTES TRANSFORMATIONS FULL ALEATOIRE
     if (argc == 2) {
-        random_exec(img, mat);
+        random_exec(img, mat, draw_seed());
+        return;
+    }
+
+    // CAS CHAÎNE DÉCRITE EN JSON (la graine de -seed= est optionnelle)
+    std::string pipeline_path;
+    if (parse_string_arg(argc, argv, "-pipeline=", pipeline_path)) {
+        int pipeline_seed = 0;
+        if (!parse_numeric_arg(argc, argv, "-seed=", pipeline_seed) || pipeline_seed == 0)
+            pipeline_seed = draw_seed();
+        load_pipeline(pipeline_path).run(img, mat, pipeline_seed);
         return;
     }
 
@@ -171,88 +370,204 @@ void gestion_arg(cv::Mat& img, int argc, char const* argv[]) {
     float coef_value = 0.0f;
     if (parse_numeric_arg(argc, argv, "-coef=", coef_value)) {
         std::cout << "Valeur de -coef : " << coef_value << std::endl;
-        distorsion_coef_exec(img, mat, coef_value);
+        distorsion_coef_exec(img, mat, coef_value, draw_seed());
         has_coef = true;
         return;
     }
     // CAS UNE OU PLUSIEURS TRANSFORMATIONS AVEC PARAM
-    cv::RNG rng(time(0));
-    std::map<std::string, std::string> parsed_opts;
-    for (int i = 2; i < argc; ++i) {
-        std::string arg(argv[i]);
-        for (const auto& opt : poss_opt) {
-            // Vérifie que l'argument commence par opt
-            if (arg.rfind(opt, 0) == 0) {
-                // Extrait la valeur après le '='
-                std::string value = arg.substr(opt.size());
-                // Stocke en mappant l'option à sa valeur
-                parsed_opts[opt] = value;
-                break; // passe à l'argument suivant
-            }
+    DegradationSpec spec = parse_spec(argc, argv);
+    apply_spec(img, spec, draw_seed(), 0, mat);
+}
+
+/**
+ * @brief Images à traiter en mode batch
+ *
+ * @param source Répertoire (fichiers image triés par nom) ou fichier liste (un chemin par ligne)
+ */
+std::vector<std::string> list_batch_inputs(const std::string& source) {
+    static const std::vector<std::string> image_extensions = { ".png", ".jpg", ".jpeg", ".tif", ".tiff", ".bmp" };
+    std::vector<std::string> inputs;
+    if (std::filesystem::is_directory(source)) {
+        for (const auto& entry : std::filesystem::directory_iterator(source)) {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (entry.is_regular_file() && std::find(image_extensions.begin(), image_extensions.end(), extension) !=
+                                               image_extensions.end())
+                inputs.push_back(entry.path().string());
         }
+        std::sort(inputs.begin(), inputs.end());
+        return inputs;
     }
-    if (auto it = parsed_opts.find("-sp="); it != parsed_opts.end()) {
-        if (auto res = parse_2
-        (it->second)) {
-            // Structured binding pour décomposer le tuple
-            auto [salt, pepper] = *res;
-            add_salt_pepper_noise(img, rng, pepper, salt);
-        } else {
-            std::cerr << "Erreur dans le format de -sp= (attendu: salt, pepper)\n";
-            exit(1);
-        }
+
+    std::ifstream list_file(source);
+    if (!list_file.is_open()) {
+        std::cerr << "Erreur : impossible d'ouvrir '" << source << "'" << std::endl;
+        exit(1);
     }
-    if (auto it = parsed_opts.find("-g="); it != parsed_opts.end()) {
-        if (auto res = parse_2
-        (it->second)) {
-            // Structured binding pour décomposer le tuple
-            auto [offset, dispersion] = *res;
-            add_gaussian_noise(img, rng, offset, dispersion);
-        } else {
-            std::cerr << "Erreur dans le format de -g= (attendu: offset, dispersion)\n";
-            exit(1);
-        }
+    std::string line;
+    while (std::getline(list_file, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty())
+            inputs.push_back(line);
     }
-    if (auto it = parsed_opts.find("-cb="); it != parsed_opts.end()) {
-        if (auto res = parse_2
-        (it->second)) {
-            // Structured binding pour décomposer le tuple
-            auto [contrast, bright] = *res;
-            contrast_brightness_modifier(img, contrast, bright);
-        } else {
-            std::cerr << "Erreur dans le format de -cb= (attendu: contrast, bright)\n";
-            exit(1);
-        }
+    return inputs;
+}
+
+/**
+ * @brief Convertit une matrice 2x3 en tableau JSON de deux lignes
+ */
+json matrix_to_json(const cv::Mat& matrix) {
+    cv::Mat values;
+    matrix.convertTo(values, CV_64F);
+    json rows = json::array();
+    for (int y = 0; y < values.rows; ++y) {
+        json row = json::array();
+        for (int x = 0; x < values.cols; ++x)
+            row.push_back(values.at<double>(y, x));
+        rows.push_back(row);
     }
-    if (auto it = parsed_opts.find("-s="); it != parsed_opts.end()) {
-        if (auto res = parse_3(it->second)) {
-            // Structured binding pour décomposer le tuple
-            auto [nb_spot, min_radius, max_radius] = *res;
-            add_ink_stain(img, rng, nb_spot, min_radius, max_radius);
-        } else {
-            std::cerr << "Erreur dans le format de -s= (attendu: nb spot, min radius, max radius)\n";
-            exit(1);
+    return rows;
+}
+
+/**
+ * @brief Mode batch : dégrade toutes les images d'un répertoire ou d'un fichier liste sur un pool de threads
+ *
+ * Chaque image est lue une seule fois puis dégradée pour chaque graine demandée. La copie i (position
+ * dans la liste des entrées) est dégradée dans les flux (graine, i) : le résultat ne dépend pas du nombre
+ * de threads. Elle est écrite dans OUT/<nom>-<i>-<graine>.png. Le manifeste (OUT/manifest.json) décrit
+ * chaque image produite, dans l'ordre des entrées puis des graines : fichiers d'entrée et de sortie,
+ * graine, indice, mode, marge ajoutée, paramètres explicites appliqués et matrice de modification.
+ *
+ * Options (en plus des transformations, -pipeline=, -coef= ou du mode aléatoire) :
+ *   -batch=SOURCE : Répertoire d'images ou fichier liste (un chemin par ligne), premier argument
+ *   -out=DIR      : Répertoire de sortie (défaut: modified)
+ *   -jobs=N       : Nombre d'images traitées en parallèle (défaut: 1, 0: nombre de cœurs)
+ *   -seed=n       : Graine des flux aléatoires (défaut: timestamp, écrit dans le manifeste)
+ *   -seeds=a,b    : Produit une image par graine de a à b inclus
+ *
+ * @return int Code de retour (0 si toutes les images ont été traitées, 1 sinon)
+ */
+int run_batch(int argc, char const* argv[]) {
+    std::string source;
+    parse_string_arg(argc, argv, "-batch=", source);
+    std::string output_dir = "modified";
+    parse_string_arg(argc, argv, "-out=", output_dir);
+    int jobs = 1;
+    parse_numeric_arg(argc, argv, "-jobs=", jobs);
+
+    int first_seed = (int) time(0), last_seed;
+    std::string seeds_value;
+    if (parse_string_arg(argc, argv, "-seeds=", seeds_value)) {
+        auto seeds = parse_2(seeds_value);
+        if (!seeds || std::get<0>(*seeds) > std::get<1>(*seeds)) {
+            std::cerr << "Erreur dans le format de -seeds= (attendu: première graine, dernière graine)\n";
+            return 1;
         }
+        std::tie(first_seed, last_seed) = *seeds;
+    } else {
+        if (!parse_numeric_arg(argc, argv, "-seed=", first_seed))
+            std::cout << "Graine : " << first_seed << " (-seed=" << first_seed << " pour reproduire le lot)"
+                      << std::endl;
+        last_seed = first_seed;
     }
-    auto it = parsed_opts.find("-r=");
-    if (it != parsed_opts.end()) {
-        int angle = std::stof(it->second); // conversion sans surcoût
-        rotate_img(img, angle);
+    // une graine nulle ferait tirer l'heure courante dans chaque tâche
+    if (first_seed == 0 && last_seed == 0) {
+        first_seed = last_seed = 1;
     }
-    if (auto it = parsed_opts.find("-t="); it != parsed_opts.end()) {
-        if (auto res = parse_2
-        (it->second)) {
-            // Structured binding pour décomposer le tuple
-            auto [dx, dy] = *res;
-            std::cout << dx << "  " << dy << std::endl;
-            translate_img(img, dx, dy);
-        } else {
-            std::cerr << "Erreur dans le format de -t= (attendu: dx, dy)\n";
-            exit(1);
+
+    float coef_value = 0.0f;
+    const bool has_coef = parse_numeric_arg(argc, argv, "-coef=", coef_value);
+    const DegradationSpec spec = parse_spec(argc, argv);
+    std::string pipeline_path;
+    std::optional<DegradationPipeline> pipeline;
+    if (parse_string_arg(argc, argv, "-pipeline=", pipeline_path))
+        pipeline = load_pipeline(pipeline_path);
+    const std::string mode = pipeline ? "pipeline" : (has_coef ? "coef" : (spec.empty() ? "random" : "explicit"));
+
+    const std::vector<std::string> inputs = list_batch_inputs(source);
+    std::filesystem::create_directories(output_dir);
+
+    std::vector<std::vector<json>> entries(inputs.size());
+    auto process_input = [&](size_t sheet) {
+        const std::string& input = inputs[sheet];
+        cv::Mat original = cv::imread(input);
+        if (original.empty()) {
+            entries[sheet].push_back({ { "input", input }, { "error", "could not read image" } });
+            return;
+        }
+
+        for (int seed = first_seed; seed <= last_seed; ++seed) {
+            // la graine 0 ferait tirer l'heure courante : elle est sautée dans une plage
+            if (seed == 0)
+                continue;
+            cv::Mat img = original.clone();
+            cv::Mat mat;
+            json params = json::object();
+            int margin = 0;
+            if (mode == "pipeline") {
+                pipeline->run(img, mat, seed, sheet);
+                params["pipeline"] = pipeline_path;
+                margin = pipeline->margin();
+            } else if (mode == "random") {
+                random_exec(img, mat, seed, sheet);
+                margin = MARGIN_COPY_MODIFIED;
+            } else if (mode == "coef") {
+                distorsion_coef_exec(img, mat, coef_value, seed, sheet);
+                params["coef"] = coef_value;
+                margin = MARGIN_COPY_COEF;
+            } else {
+                params = apply_spec(img, spec, seed, sheet, mat);
+            }
+
+            // l'indice de la copie distingue deux entrées de même nom venant de répertoires différents
+            const std::filesystem::path output =
+                std::filesystem::path(output_dir) / (std::filesystem::path(input).stem().string() + "-" +
+                                                     std::to_string(sheet) + "-" + std::to_string(seed) + ".png");
+            json entry = { { "input", input }, { "output", output.string() }, { "seed", seed }, { "sheet", sheet },
+                           { "mode", mode },   { "margin", margin },          { "params", params } };
+            if (cv::imwrite(output.string(), img)) {
+                entry["modification_matrix"] = matrix_to_json(mat);
+            } else {
+                entry["error"] = "could not write image";
+            }
+            entries[sheet].push_back(entry);
+        }
+    };
+
+    if (jobs == 1) {
+        for (size_t sheet = 0; sheet < inputs.size(); ++sheet) {
+            process_input(sheet);
+        }
+    } else {
+        ThreadPool pool(jobs);
+        for (size_t sheet = 0; sheet < inputs.size(); ++sheet) {
+            pool.submit([&, sheet]() { process_input(sheet); });
+        }
+        pool.wait();
+    }
+
+    // Manifeste dans l'ordre des entrées : identique quel que soit le nombre de threads
+    json manifest = json::array();
+    int nb_success = 0, nb_outputs = 0;
+    for (const auto& input_entries : entries) {
+        for (const auto& entry : input_entries) {
+            nb_outputs += 1;
+            if (!entry.contains("error"))
+                nb_success += 1;
+            else
+                std::cerr << "Erreur : " << entry["input"].get<std::string>() << " : "
+                          << entry["error"].get<std::string>() << std::endl;
+            manifest.push_back(entry);
         }
     }
+    const std::filesystem::path manifest_path = std::filesystem::path(output_dir) / "manifest.json";
+    std::ofstream manifest_file(manifest_path);
+    manifest_file << manifest.dump(2) << std::endl;
 
-    // si seed not in params
+    std::cout << nb_success << "/" << nb_outputs << " images modifiées (" << inputs.size()
+              << " entrées), manifeste : " << manifest_path.string() << std::endl;
+    return nb_success == nb_outputs ? 0 : 1;
 }
 
 /**
@@ -264,6 +579,8 @@ void gestion_arg(cv::Mat& img, int argc, char const* argv[]) {
  * Utilisation: ./modifier <chemin_image> [options]
  * Exemple: ./modifier input.jpg -sp=2,3 -r=5
  *
+ * Avec -batch=SOURCE en premier argument, traite toutes les images de SOURCE (voir run_batch).
+ *
  * @param argc Nombre d'arguments
  * @param argv Tableau d'arguments
  * @return int Code de retour (0 en cas de succès)
@@ -273,6 +590,9 @@ int main(int argc, char const* argv[]) {
         std::cerr << "Usage: " << argv[0] << " <image_max_pepperth>" << std::endl;
         return 1;
     }
+    if (std::string(argv[1]).rfind("-batch=", 0) == 0) {
+        return run_batch(argc, argv);
+    }
     std::string image_max_pepperth = argv[1];
     cv::Mat img = cv::imread(image_max_pepperth);
     cv::Mat calibrated_img = img.clone();
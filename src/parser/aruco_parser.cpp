@@ -46,10 +46,89 @@ int identify_corner_aruco(std::vector<std::pair<int, std::vector<cv::Point2f>>>&
     return found_mask;
 }
 
+/**
+ * @brief Identifiants des marqueurs ArUco utilisés comme coins (TL, TR, BL) dans DICT_4X4_1000
+ */
+static constexpr int CORNER_ARUCO_IDS[] = { 190, 997, 999 };
+
+/**
+ * @brief Convertit les marqueurs détectés en coordonnées de la page et applique la table des identifiants
+ *
+ * @param markerIds Identifiants renvoyés par le détecteur
+ * @param markerCorners Coins des marqueurs, dans le repère de l'image analysée
+ * @param offset Position de l'image analysée dans la page
+ * @param id_table Table de correspondance des identifiants (nullptr: identifiants inchangés)
+ */
+static std::vector<std::pair<int, std::vector<cv::Point2f>>>
+to_page_markers(const std::vector<int>& markerIds, std::vector<std::vector<cv::Point2f>>& markerCorners,
+                const cv::Point2i& offset, const int* id_table) {
+    std::vector<std::pair<int, std::vector<cv::Point2f>>> barcodes;
+    barcodes.reserve(markerIds.size());
+    for (int i = 0; i < markerIds.size(); i++) {
+        auto& markerCorner = markerCorners[i];
+        for (auto& point : markerCorner) {
+            point.x += offset.x;
+            point.y += offset.y;
+        }
+        barcodes.emplace_back(id_table ? id_table[markerIds[i]] : markerIds[i], markerCorner);
+    }
+    return barcodes;
+}
+
+#if (CV_VERSION_MAJOR >= 4 && CV_VERSION_MINOR > 6)
+/**
+ * @brief Dictionnaire réduit aux seuls marqueurs de coin
+ *
+ * L'index d'un marqueur dans ce dictionnaire est sa position dans CORNER_ARUCO_IDS. La
+ * correction d'erreur est celle de DICT_4X4_1000 pour conserver le même comportement.
+ */
+static cv::aruco::Dictionary corner_dictionary() {
+    cv::aruco::Dictionary full = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_4X4_1000);
+    cv::Mat bytes_list;
+    for (int id : CORNER_ARUCO_IDS) {
+        bytes_list.push_back(full.bytesList.row(id));
+    }
+    return cv::aruco::Dictionary(bytes_list, full.markerSize, full.maxCorrectionBits);
+}
+
+/**
+ * @brief Détecteur construit une seule fois par thread
+ */
+static const cv::aruco::ArucoDetector& corner_detector() {
+    thread_local const cv::aruco::ArucoDetector detector(corner_dictionary(), cv::aruco::DetectorParameters());
+    return detector;
+}
+#else
+static cv::Ptr<cv::aruco::Dictionary> corner_dictionary() {
+    cv::Ptr<cv::aruco::Dictionary> full = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_4X4_1000);
+    cv::Mat bytes_list;
+    for (int id : CORNER_ARUCO_IDS) {
+        bytes_list.push_back(full->bytesList.row(id));
+    }
+    return cv::makePtr<cv::aruco::Dictionary>(bytes_list, full->markerSize, full->maxCorrectionBits);
+}
+#endif
+
 std::vector<std::pair<int, std::vector<cv::Point2f>>> identify_aruco(const cv::Mat& img, const cv::Point2i& offset) {
     std::vector<int> markerIds;
     std::vector<std::vector<cv::Point2f>> markerCorners, rejectedCandidates;
 
+#if (CV_VERSION_MAJOR >= 4 && CV_VERSION_MINOR > 6)
+    corner_detector().detectMarkers(img, markerCorners, markerIds, rejectedCandidates);
+#else
+    thread_local const cv::Ptr<cv::aruco::DetectorParameters> parameters = cv::aruco::DetectorParameters::create();
+    thread_local const cv::Ptr<cv::aruco::Dictionary> dictionary = corner_dictionary();
+    cv::aruco::detectMarkers(img, dictionary, markerCorners, markerIds, parameters, rejectedCandidates);
+#endif
+
+    return to_page_markers(markerIds, markerCorners, offset, CORNER_ARUCO_IDS);
+}
+
+std::vector<std::pair<int, std::vector<cv::Point2f>>> identify_aruco_full_dictionary(const cv::Mat& img,
+                                                                                     const cv::Point2i& offset) {
+    std::vector<int> markerIds;
+    std::vector<std::vector<cv::Point2f>> markerCorners, rejectedCandidates;
+
 #if (CV_VERSION_MAJOR >= 4 && CV_VERSION_MINOR > 6)
     cv::aruco::DetectorParameters detectorParams = cv::aruco::DetectorParameters();
     cv::aruco::Dictionary dictionary = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_4X4_1000);
@@ -61,31 +140,17 @@ std::vector<std::pair<int, std::vector<cv::Point2f>>> identify_aruco(const cv::M
     cv::aruco::detectMarkers(img, dictionary, markerCorners, markerIds, parameters, rejectedCandidates);
 #endif
 
-    std::vector<std::pair<int, std::vector<cv::Point2f>>> barcodes;
-    for (int i = 0; i < markerIds.size(); i++) {
-        auto markerCorner = markerCorners[i];
-        for (auto& point : markerCorner) {
-            point.x += offset.x;
-            point.y += offset.y;
-        }
-        std::vector<cv::Point> raster_box;
-        for (const auto& point : markerCorner) {
-            raster_box.push_back(cv::Point(point.x, point.y));
-        }
-        cv::polylines(img, raster_box, true, cv::Scalar(0, 255, 0), 2);
-        barcodes.emplace_back(markerIds[i], markerCorner);
-    }
-
-    return barcodes;
+    return to_page_markers(markerIds, markerCorners, offset, nullptr);
 }
 
-std::optional<cv::Mat> aruco_parser(const cv::Mat& img,
+std::optional<cv::Mat> aruco_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                     cv::Mat debug_img,
 #endif
                                     Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode) {
 
-    auto barcodes = identify_barcodes(img, (ZXing::BarcodeFormat) flag_barcode);
+    const auto& barcodes =
+        identify_barcodes_near(ctx, img, dst_corner_points, BOTTOM_RIGHT_BF, 1, (ZXing::BarcodeFormat) flag_barcode);
 
     if (barcodes.empty()) {
         printf("no barcode found\n");
@@ -103,12 +168,18 @@ std::optional<cv::Mat> aruco_parser(const cv::Mat& img,
         return {};
     }
 
+    // les identifiants des marqueurs TL, TR et BL sont uniques : les trouver tous suffit
+    auto accept = [](const std::vector<std::pair<int, std::vector<cv::Point2f>>>& markers) {
+        auto candidates = markers;
+        std::vector<cv::Point2f> corner_points;
+        return identify_corner_aruco(candidates, corner_points) == QUADRANTS_EXCEPT_BOTTOM_RIGHT;
+    };
     // auto marker_aruco = identify_aruco(img);
-    auto marker_aruco = smaller_parse(img,
+    auto marker_aruco = smaller_parse(ctx, img,
 #ifdef DEBUG
                                       debug_img,
 #endif
-                                      identify_aruco);
+                                      identify_aruco, 0.2, accept);
 
     auto corner_barcode = corner_barcode_opt.value();
 
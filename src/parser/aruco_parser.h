@@ -10,6 +10,37 @@
  * Il utilise spécifiquement les marqueurs ArUco du dictionnaire DICT_4X4_1000.
  */
 
+#include <vector>
+#include <utility>
+
+#include <common.h>
+
+/**
+ * @brief Détecte les marqueurs ArUco de coin (190, 997, 999) dans une image
+ *
+ * Le détecteur est construit une seule fois par thread, avec un dictionnaire réduit aux trois
+ * marqueurs de coin : la comparaison des candidats ne parcourt plus les 1000 codes de
+ * DICT_4X4_1000. Les autres marqueurs du dictionnaire ne sont pas détectés.
+ *
+ * @param img Image (ou partie d'image) à analyser
+ * @param offset Position de img dans la page, ajoutée aux coordonnées des marqueurs
+ * @return Liste des marqueurs détectés (identifiant DICT_4X4_1000, coins dans la page)
+ */
+std::vector<std::pair<int, std::vector<cv::Point2f>>> identify_aruco(const cv::Mat& img, const cv::Point2i& offset);
+
+/**
+ * @brief Détecte les marqueurs ArUco avec le dictionnaire DICT_4X4_1000 complet
+ *
+ * Implémentation de référence qui reconstruit le détecteur à chaque appel, conservée pour
+ * mesurer le gain de identify_aruco (benchmark aruco-bench).
+ *
+ * @param img Image (ou partie d'image) à analyser
+ * @param offset Position de img dans la page, ajoutée aux coordonnées des marqueurs
+ * @return Liste des marqueurs détectés (identifiant DICT_4X4_1000, coins dans la page)
+ */
+std::vector<std::pair<int, std::vector<cv::Point2f>>> identify_aruco_full_dictionary(const cv::Mat& img,
+                                                                                     const cv::Point2i& offset);
+
 /**
  * @brief Analyse une image pour détecter des marqueurs ArUco et un code-barres
  * 
@@ -19,6 +50,7 @@
  * 3. Utiliser les centres des marqueurs détectés comme points de référence
  * 4. Calculer une matrice de transformation basée sur les points détectés
  * 
+ * @param ctx Contexte du thread appelant (tampons et décodeur réutilisés)
  * @param img Image source à analyser
  * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
  * @param meta Structure de métadonnées à remplir depuis le code-barres
@@ -27,7 +59,7 @@
  * 
  * @return Une matrice de transformation optionnelle, ou vide en cas d'échec
  */
-std::optional<cv::Mat> aruco_parser(const cv::Mat& img,
+std::optional<cv::Mat> aruco_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                     cv::Mat debug_img,
 #endif
@@ -4,12 +4,14 @@
  *
  */
 
+#include <algorithm>
 #include <vector>
 #include <string>
 
 #include <common.h>
 #include "json_helper.h"
 #include "center_marker_parser.h"
+#include "shape_parser.h"
 #include "parser_helper.h"
 #include "string_helper.h"
 #include <draw_helper.h>
@@ -25,21 +27,21 @@ static bool discriminate(cv::Rect rect) {
     return rect.width > MIN_SIZE && rect.height > MIN_SIZE && rect.width < MAX_SIZE && rect.height < MAX_SIZE;
 }
 
-static std::vector<std::pair<cv::Point2f, cv::Rect>> detect_shape(const cv::Mat& img, const cv::Point2i& offset) {
+static std::vector<std::pair<cv::Point2f, cv::Rect>> detect_shape(ScratchBuffers& scratch, const cv::Mat& img,
+                                                                  const cv::Point2i& offset) {
     std::vector<std::pair<cv::Point2f, cv::Rect>> detected_shapes;
 
-    cv::Mat canny_img;
-    cv::Canny(img, canny_img, 100, 100, 3);
+    cv::Canny(img, scratch.edges, 100, 100, 3);
 
-    std::vector<std::vector<cv::Point>> contours;
-    std::vector<cv::Vec4i> hierarchy; // unused; but could be used in drawContours
-    cv::findContours(canny_img, contours, hierarchy, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE, offset);
+    // hierarchy: unused; but could be used in drawContours
+    cv::findContours(scratch.edges, scratch.contours, scratch.hierarchy, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE,
+                     offset);
 
-    for (const auto& contour : contours) {
+    for (const auto& contour : scratch.contours) {
         if (contour.size() < 5)
             continue;
 
-        cv::Rect rect = cv::boundingRect(cv::Mat(contour));
+        cv::Rect rect = cv::boundingRect(contour);
 
         if (!discriminate(rect))
             continue;
@@ -76,21 +78,40 @@ static float distance(cv::Point2f a, cv::Point2f b) {
 
 #define DISTANCE_THRESHOLD 350
 
-std::vector<cv::Point2f> find_closest_point_corner(const std::vector<cv::Point2f>& detected_shapes,
-                                                   const cv::Size& img_size, int& flag) {
-    std::vector<cv::Point2f> corner_points(4, { 0, 0 });
-    std::vector<cv::Point2f> candidate_top_left, candidate_top_right, candidate_bottom_left, candidate_bottom_right;
+/**
+ * @brief Répartit les centres détectés entre les quatre coins de l'image
+ *
+ * Un même marqueur produit plusieurs contours imbriqués (RETR_LIST sur les contours de Canny) dont
+ * les centres coïncident ; si dedup est vrai, seule la première occurrence de chaque centre est gardée.
+ */
+static void split_candidates(const std::vector<cv::Point2f>& detected_shapes, const cv::Size& img_size, bool dedup,
+                             std::vector<cv::Point2f> (&candidates)[4]) {
+    const cv::Point2f image_corners[4] = { cv::Point2f(0, 0), cv::Point2f(img_size.width, 0),
+                                           cv::Point2f(0, img_size.height),
+                                           cv::Point2f(img_size.width, img_size.height) };
+
     for (const auto& shape : detected_shapes) {
-        if (distance(shape, cv::Point2f(0, 0)) < DISTANCE_THRESHOLD) {
-            candidate_top_left.push_back(shape);
-        } else if (distance(shape, cv::Point2f(img_size.width, 0)) < DISTANCE_THRESHOLD) {
-            candidate_top_right.push_back(shape);
-        } else if (distance(shape, cv::Point2f(0, img_size.height)) < DISTANCE_THRESHOLD) {
-            candidate_bottom_left.push_back(shape);
-        } else if (distance(shape, cv::Point2f(img_size.width, img_size.height)) < DISTANCE_THRESHOLD) {
-            candidate_bottom_right.push_back(shape);
+        for (int corner = 0; corner < 4; ++corner) {
+            if (distance(shape, image_corners[corner]) < DISTANCE_THRESHOLD) {
+                auto& corner_candidates = candidates[corner];
+                if (!dedup || std::find(corner_candidates.begin(), corner_candidates.end(), shape) ==
+                                  corner_candidates.end())
+                    corner_candidates.push_back(shape);
+                break;
+            }
         }
     }
+}
+
+std::vector<cv::Point2f> find_closest_point_corner_exhaustive(const std::vector<cv::Point2f>& detected_shapes,
+                                                              const cv::Size& img_size, int& flag) {
+    std::vector<cv::Point2f> corner_points(4, { 0, 0 });
+    std::vector<cv::Point2f> candidates[4];
+    split_candidates(detected_shapes, img_size, false, candidates);
+    const auto& candidate_top_left = candidates[TOP_LEFT];
+    const auto& candidate_top_right = candidates[TOP_RIGHT];
+    const auto& candidate_bottom_left = candidates[BOTTOM_LEFT];
+    const auto& candidate_bottom_right = candidates[BOTTOM_RIGHT];
 
     float scord = 10.f;
     for (const auto& tl : candidate_top_left) {
@@ -119,13 +140,164 @@ std::vector<cv::Point2f> find_closest_point_corner(const std::vector<cv::Point2f
     return corner_points;
 }
 
-std::optional<cv::Mat> center_marker_parser(const cv::Mat& img,
+/**
+ * @brief Grille de répartition spatiale des candidats d'un coin
+ *
+ * Les indices sont rangés par cellule ; une requête retourne, dans l'ordre croissant, les indices des
+ * candidats situés dans un disque, ce qui préserve l'ordre de parcours de la recherche exhaustive.
+ */
+class CandidateGrid {
+  public:
+    CandidateGrid(const std::vector<cv::Point2f>& points, float cell_size) : points_(points), cell_size_(cell_size) {
+        if (points.empty())
+            return;
+        cv::Point2f max_point = points[0];
+        origin_ = points[0];
+        for (const auto& point : points) {
+            origin_.x = std::min(origin_.x, point.x);
+            origin_.y = std::min(origin_.y, point.y);
+            max_point.x = std::max(max_point.x, point.x);
+            max_point.y = std::max(max_point.y, point.y);
+        }
+        cols_ = (int) ((max_point.x - origin_.x) / cell_size_) + 1;
+        rows_ = (int) ((max_point.y - origin_.y) / cell_size_) + 1;
+        cells_.resize(cols_ * rows_);
+        for (int i = 0; i < (int) points.size(); ++i) {
+            cells_[cell_y(points[i].y) * cols_ + cell_x(points[i].x)].push_back(i);
+        }
+    }
+
+    void query(const cv::Point2f& center, float radius, std::vector<int>& indices) const {
+        indices.clear();
+        if (cells_.empty())
+            return;
+        const int x0 = cell_x(center.x - radius), x1 = cell_x(center.x + radius);
+        const int y0 = cell_y(center.y - radius), y1 = cell_y(center.y + radius);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                for (int i : cells_[y * cols_ + x]) {
+                    if (distance(points_[i], center) <= radius)
+                        indices.push_back(i);
+                }
+            }
+        }
+        std::sort(indices.begin(), indices.end());
+    }
+
+  private:
+    int cell_x(float x) const {
+        return std::clamp((int) std::floor((x - origin_.x) / cell_size_), 0, cols_ - 1);
+    }
+    int cell_y(float y) const {
+        return std::clamp((int) std::floor((y - origin_.y) / cell_size_), 0, rows_ - 1);
+    }
+
+    const std::vector<cv::Point2f>& points_;
+    float cell_size_;
+    cv::Point2f origin_;
+    int cols_ = 0, rows_ = 0;
+    std::vector<std::vector<int>> cells_;
+};
+
+/**
+ * @brief Position d'un point dans le repère formé par un segment et sa normale
+ *
+ * point = end + u * (end - start) + v * perp(end - start), où perp tourne de 90° vers le bas de l'image.
+ */
+static cv::Point2f relative_position(const cv::Point2f& start, const cv::Point2f& end, const cv::Point2f& point) {
+    const cv::Point2f axis = end - start;
+    const cv::Point2f perp(-axis.y, axis.x);
+    const float norm2 = axis.dot(axis);
+    const cv::Point2f delta = point - end;
+    return cv::Point2f(delta.dot(axis) / norm2, delta.dot(perp) / norm2);
+}
+
+static cv::Point2f from_relative_position(const cv::Point2f& start, const cv::Point2f& end,
+                                          const cv::Point2f& position) {
+    const cv::Point2f axis = end - start;
+    const cv::Point2f perp(-axis.y, axis.x);
+    return end + axis * position.x + perp * position.y;
+}
+
+// tolérance sur la position prédite du troisième coin, relative à la distance entre TL et TR
+#define LAYOUT_TOLERANCE 0.05f
+// écart relatif maximal entre la distance TL-TR trouvée et celle de la mise en page attendue
+#define SCALE_TOLERANCE 0.25f
+#define GRID_CELL_SIZE 32.f
+
+std::vector<cv::Point2f> find_closest_point_corner(const std::vector<cv::Point2f>& detected_shapes,
+                                                   const cv::Size& img_size,
+                                                   const std::vector<cv::Point2f>& expected_corner_points, int& flag) {
+    const float expected_width = distance(expected_corner_points[TOP_LEFT], expected_corner_points[TOP_RIGHT]);
+    if (expected_width < 1.f)
+        return find_closest_point_corner_exhaustive(detected_shapes, img_size, flag);
+
+    // position de BR (resp. BL) dans le repère (TL, TR) de la mise en page attendue : invariante par similitude
+    const cv::Point2f br_position = relative_position(
+        expected_corner_points[TOP_LEFT], expected_corner_points[TOP_RIGHT], expected_corner_points[BOTTOM_RIGHT]);
+    const cv::Point2f bl_position = relative_position(
+        expected_corner_points[TOP_LEFT], expected_corner_points[TOP_RIGHT], expected_corner_points[BOTTOM_LEFT]);
+
+    std::vector<cv::Point2f> candidates[4];
+    split_candidates(detected_shapes, img_size, true, candidates);
+    const CandidateGrid bottom_right_grid(candidates[BOTTOM_RIGHT], GRID_CELL_SIZE);
+    const CandidateGrid bottom_left_grid(candidates[BOTTOM_LEFT], GRID_CELL_SIZE);
+
+    std::vector<cv::Point2f> corner_points(4, { 0, 0 });
+    std::vector<int> nearby;
+    bool found = false;
+
+    // même critère et même ordre de parcours que la recherche exhaustive, restreints aux triplets plausibles
+    float scord = 10.f;
+    for (const auto& tl : candidates[TOP_LEFT]) {
+        for (const auto& tr : candidates[TOP_RIGHT]) {
+            const float width = distance(tl, tr);
+            if (std::abs(width - expected_width) > SCALE_TOLERANCE * expected_width)
+                continue;
+            const float radius = LAYOUT_TOLERANCE * width;
+
+            bottom_right_grid.query(from_relative_position(tl, tr, br_position), radius, nearby);
+            for (int i : nearby) {
+                const auto& br = candidates[BOTTOM_RIGHT][i];
+                if (angle(tr, tl, br) < scord) {
+                    corner_points[TOP_LEFT] = tl;
+                    corner_points[TOP_RIGHT] = tr;
+                    corner_points[BOTTOM_RIGHT] = br;
+                    flag = TOP_LEFT_BF | TOP_RIGHT_BF | BOTTOM_RIGHT_BF;
+                    scord = angle(tl, tr, br);
+                    found = true;
+                }
+            }
+
+            bottom_left_grid.query(from_relative_position(tl, tr, bl_position), radius, nearby);
+            for (int i : nearby) {
+                const auto& bl = candidates[BOTTOM_LEFT][i];
+                if (angle(tl, tr, bl) < scord) {
+                    corner_points[TOP_LEFT] = tl;
+                    corner_points[TOP_RIGHT] = tr;
+                    corner_points[BOTTOM_LEFT] = bl;
+                    flag = TOP_LEFT_BF | TOP_RIGHT_BF | BOTTOM_LEFT_BF;
+                    scord = angle(tl, tr, bl);
+                    found = true;
+                }
+            }
+        }
+    }
+
+    // aucun triplet ne respecte la mise en page (page très déformée) : on retombe sur la recherche complète
+    if (!found)
+        return find_closest_point_corner_exhaustive(detected_shapes, img_size, flag);
+
+    return corner_points;
+}
+
+std::optional<cv::Mat> center_marker_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                             cv::Mat debug_img,
 #endif
                                             Metadata& meta, std::vector<cv::Point2f>& dst_corner_points,
                                             int flag_barcode) {
-    auto barcodes = identify_barcodes(img, (ZXing::BarcodeFormat) flag_barcode);
+    const auto& barcodes = identify_barcodes(ctx, img, (ZXing::BarcodeFormat) flag_barcode);
 
     if (barcodes.empty()) {
         printf("no barcode found\n");
@@ -148,13 +320,14 @@ std::optional<cv::Mat> center_marker_parser(const cv::Mat& img,
     meta = parse_metadata(corner_barcode.content);
 
     // auto detected_shapes = detect_shape(img, { 0, 0 });
-    auto detected_shapes = smaller_parse(img,
+    auto detect = ctx.settings.shape_detector == ShapeDetector::COMPONENTS ? detect_shape_components : detect_shape;
+    auto detected_shapes = smaller_parse(ctx, img,
 #ifdef DEBUG
                                          debug_img,
 #endif
-                                         detect_shape);
+                                         detect);
     if (detected_shapes.empty()) {
-        printf("no circle found\n");
+        printf("no shape found\n");
         return {};
     }
 
@@ -172,7 +345,9 @@ std::optional<cv::Mat> center_marker_parser(const cv::Mat& img,
 
     int flag = 0;
 
-    auto corner_points = find_closest_point_corner(shaped_points, img.size(), flag);
+    auto corner_points = ctx.settings.corner_layout_pruning
+                             ? find_closest_point_corner(shaped_points, img.size(), dst_corner_points, flag)
+                             : find_closest_point_corner_exhaustive(shaped_points, img.size(), flag);
 
 #ifdef DEBUG
     for (int i = 0; i < 4; ++i) {
@@ -10,6 +10,49 @@
  * pour établir une transformation.
  */
 
+/**
+ * @brief Choisit, parmi les centres détectés, les trois coins formant l'angle le plus proche de 90°
+ *
+ * Recherche exhaustive : chaque triplet TL × TR × BR et TL × TR × BL de candidats est évalué.
+ * C'est la recherche utilisée par défaut par center_marker_parser (voir ParserSettings::corner_layout_pruning).
+ *
+ * @param detected_shapes Centres des formes détectées dans l'image
+ * @param img_size Taille de l'image
+ * @param flag Masque (CornerBF) des coins trouvés, modifié uniquement si un triplet est trouvé
+ * @return std::vector<cv::Point2f> Positions des coins, indexées par Corner
+ */
+std::vector<cv::Point2f> find_closest_point_corner_exhaustive(const std::vector<cv::Point2f>& detected_shapes,
+                                                              const cv::Size& img_size, int& flag);
+
+/**
+ * @brief Version élaguée de find_closest_point_corner_exhaustive
+ *
+ * Les centres identiques (contours imbriqués d'un même marqueur) sont fusionnés, puis pour chaque
+ * paire TL × TR seuls les candidats BR et BL proches de la position prédite par la mise en page
+ * attendue (à une similitude près) sont évalués, via une grille spatiale. Le critère et l'ordre de
+ * parcours sont ceux de la recherche exhaustive ; si aucun triplet plausible n'existe, la recherche
+ * exhaustive est utilisée.
+ *
+ * Le résultat peut différer de celui de la recherche exhaustive, qui ne suit pas un optimum global :
+ * le seuil d'acceptation d'un triplet TL-TR-BR est l'écart à l'angle droit au sommet TL, mais la
+ * valeur retenue ensuite comme seuil est l'écart au sommet TR. Ce seuil n'est donc pas monotone, et
+ * le triplet retenu dépend de tous les triplets évalués avant lui, y compris des centres en double et
+ * des triplets parasites. Écarter un seul d'entre eux (fusion des doublons, tolérances de la mise en
+ * page) peut changer le résultat ; aucun élagage ne garantit le même triplet sans évaluer tous les
+ * autres. Le triplet élagué respecte en revanche la mise en page attendue (voir les colonnes
+ * Same_Corners et *_Correct de corner-solver-bench). center_marker_parser ne l'utilise que si
+ * ctx.settings.corner_layout_pruning est actif.
+ *
+ * @param detected_shapes Centres des formes détectées dans l'image
+ * @param img_size Taille de l'image
+ * @param expected_corner_points Positions attendues des coins (indexées par Corner)
+ * @param flag Masque (CornerBF) des coins trouvés, modifié uniquement si un triplet est trouvé
+ * @return std::vector<cv::Point2f> Positions des coins, indexées par Corner
+ */
+std::vector<cv::Point2f> find_closest_point_corner(const std::vector<cv::Point2f>& detected_shapes,
+                                                   const cv::Size& img_size,
+                                                   const std::vector<cv::Point2f>& expected_corner_points, int& flag);
+
 /**
  * @brief Analyse une image pour détecter des marqueurs et un code-barres central
  * 
@@ -20,6 +63,7 @@
  * 4. Déterminer quels points sont les plus proches des coins de l'image
  * 5. Calculer une matrice de transformation basée sur ces points
  * 
+ * @param ctx Contexte du thread appelant (tampons et décodeur réutilisés)
  * @param img Image source à analyser
  * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
  * @param meta Structure de métadonnées à remplir depuis le code-barres d'en-tête
@@ -28,7 +72,7 @@
  * 
  * @return Une matrice de transformation optionnelle, ou vide en cas d'échec
  */
-std::optional<cv::Mat> center_marker_parser(const cv::Mat& img,
+std::optional<cv::Mat> center_marker_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                             cv::Mat debug_img,
 #endif
@@ -6,6 +6,7 @@
 #include "parser_helper.h"
 #include "string_helper.h"
 #include "math_utils.h"
+#include "corner_solver.h"
 #include "draw_helper.h"
 
 #include "circle_parser.h"
@@ -23,12 +24,138 @@ std::vector<cv::Vec3f> detect_circles(const cv::Mat& img, const cv::Point2i& off
     return detected_circles;
 }
 
-std::optional<cv::Mat> circle_parser(const cv::Mat& img,
+// mêmes bornes de rayon que HoughCircles
+#define MIN_RADIUS 5
+#define MAX_RADIUS 80
+// un disque occupe π/4 ≈ 0.785 de son carré englobant, un carré plein 1
+#define MIN_FILL_RATIO 0.65f
+#define MAX_FILL_RATIO 0.9f
+#define MIN_ASPECT_RATIO 0.8f
+// 4π·aire/périmètre² vaut 1 pour un disque et π/4 ≈ 0.785 pour un carré plein, quelle que soit son orientation :
+// le seuil doit rester au-dessus de π/4 (un carré légèrement tourné passe les filtres de remplissage), avec une
+// marge pour le contour discret qui surestime un peu le périmètre d'un disque
+#define MIN_CIRCULARITY 0.85f
+
+std::vector<cv::Vec3f> detect_circles_blobs(ScratchBuffers& scratch, const cv::Mat& img, const cv::Point2i& offset) {
+    std::vector<cv::Vec3f> detected_circles;
+
+    cv::threshold(img, scratch.binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+
+    const cv::Mat& labels = scratch.labels;
+    const cv::Mat& stats = scratch.stats;
+    int nb_labels = cv::connectedComponentsWithStats(scratch.binary, scratch.labels, scratch.stats, scratch.centroids,
+                                                     8, CV_32S);
+
+    // étiquette 0 : fond
+    for (int label = 1; label < nb_labels; ++label) {
+        const int* stat = stats.ptr<int>(label);
+        const cv::Rect rect(stat[cv::CC_STAT_LEFT], stat[cv::CC_STAT_TOP], stat[cv::CC_STAT_WIDTH],
+                            stat[cv::CC_STAT_HEIGHT]);
+        const int area = stat[cv::CC_STAT_AREA];
+
+        // filtres en temps constant d'abord : seules les composantes restantes sont examinées pixel à pixel
+        if (std::min(rect.width, rect.height) < 2 * MIN_RADIUS || std::max(rect.width, rect.height) > 2 * MAX_RADIUS)
+            continue;
+        if (std::min(rect.width, rect.height) < MIN_ASPECT_RATIO * std::max(rect.width, rect.height))
+            continue;
+        const float fill_ratio = (float) area / rect.area();
+        if (fill_ratio < MIN_FILL_RATIO || fill_ratio > MAX_FILL_RATIO)
+            continue;
+
+        // masque écrit dans la boîte de la composante, au sein d'un tampon à la taille des étiquettes
+        scratch.mask.create(labels.size(), CV_8U);
+        cv::Mat mask = scratch.mask(rect);
+        cv::compare(labels(rect), label, mask, cv::CMP_EQ);
+
+        auto& contours = scratch.contours;
+        cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+        if (contours.empty())
+            continue;
+        const double perimeter = cv::arcLength(contours[0], true);
+        if (perimeter <= 0 || 4 * M_PI * area / (perimeter * perimeter) < MIN_CIRCULARITY)
+            continue;
+
+        // centroïde sous-pixellique à partir des moments de la composante
+        const cv::Moments moments = cv::moments(mask, true);
+        const float x = (float) (moments.m10 / moments.m00) + rect.x + offset.x;
+        const float y = (float) (moments.m01 / moments.m00) + rect.y + offset.y;
+        detected_circles.emplace_back(x, y, (float) std::sqrt(area / M_PI));
+    }
+
+    return detected_circles;
+}
+
+/**
+ * @brief Candidats de detect_circles_blobs sur l'image réduite (taille et proportions mises à l'échelle)
+ *
+ * La réduction arrondit les bords des composantes : le remplissage et la circularité ne sont vérifiés
+ * qu'à pleine résolution.
+ */
+static std::vector<cv::Rect> blob_candidates(ScratchBuffers& scratch, const cv::Mat& small_img, int scale) {
+    cv::threshold(small_img, scratch.binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+    int nb_labels = cv::connectedComponentsWithStats(scratch.binary, scratch.labels, scratch.stats, scratch.centroids,
+                                                     8, CV_32S);
+
+    std::vector<cv::Rect> candidates;
+    for (int label = 1; label < nb_labels; ++label) {
+        const int* stat = scratch.stats.ptr<int>(label);
+        const cv::Rect rect(stat[cv::CC_STAT_LEFT], stat[cv::CC_STAT_TOP], stat[cv::CC_STAT_WIDTH],
+                            stat[cv::CC_STAT_HEIGHT]);
+
+        // mêmes bornes que detect_circles_blobs, avec une tolérance d'un pixel à l'échelle réduite
+        const int min_side = std::min(rect.width, rect.height), max_side = std::max(rect.width, rect.height);
+        if (min_side * scale + scale < 2 * MIN_RADIUS || max_side * scale - scale > 2 * MAX_RADIUS)
+            continue;
+        if (min_side + 1 < MIN_ASPECT_RATIO * max_side)
+            continue;
+        candidates.emplace_back(rect);
+    }
+    return candidates;
+}
+
+static std::vector<cv::Rect> circle_candidates(const cv::Mat& small_img, int scale) {
+    std::vector<cv::Vec3f> circles;
+
+    // rayons ramenés à l'échelle réduite ; le seuil d'accumulation suit la longueur du contour
+    cv::HoughCircles(small_img, circles, cv::HOUGH_GRADIENT, 1, small_img.rows / 8, 300, std::max(10, 35 / scale),
+                     std::max(2, 5 / scale), 80 / scale + 1);
+
+    std::vector<cv::Rect> candidates;
+    for (const auto& circle : circles) {
+        const int radius = cvCeil(circle[2]);
+        candidates.emplace_back(cvRound(circle[0]) - radius, cvRound(circle[1]) - radius, 2 * radius, 2 * radius);
+    }
+    return candidates;
+}
+
+// HoughCircles n'a pas de tampons réutilisables : seule la variante par composantes utilise ceux du quadrant
+static std::vector<cv::Vec3f> detect_circles_pyramid(ScratchBuffers&, const cv::Mat& img, const cv::Point2i& offset,
+                                                     int scale) {
+    return coarse_to_fine_parse(img, offset, circle_candidates, detect_circles, scale, 4 * scale);
+}
+
+static std::vector<cv::Vec3f> detect_circles_blobs_pyramid(ScratchBuffers& scratch, const cv::Mat& img,
+                                                           const cv::Point2i& offset, int scale) {
+    return coarse_to_fine_parse(
+        img, offset,
+        [&](const cv::Mat& small_img, int small_scale) { return blob_candidates(scratch, small_img, small_scale); },
+        [&](const cv::Mat& window, const cv::Point2i& window_offset) {
+            return detect_circles_blobs(scratch, window, window_offset);
+        },
+        scale, 4 * scale);
+}
+
+static cv::Point2f circle_center(const cv::Vec3f& circle) {
+    return cv::Point2f(circle[0], circle[1]);
+}
+
+std::optional<cv::Mat> circle_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                      cv::Mat debug_img,
 #endif
                                      Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode) {
-    auto barcodes = identify_barcodes(img, (ZXing::BarcodeFormat) flag_barcode);
+    const auto& barcodes =
+        identify_barcodes_near(ctx, img, dst_corner_points, BOTTOM_RIGHT_BF, 1, (ZXing::BarcodeFormat) flag_barcode);
 
     if (barcodes.empty()) {
         printf("no barcode found\n");
@@ -61,11 +188,20 @@ std::optional<cv::Mat> circle_parser(const cv::Mat& img,
     meta = parse_metadata(corner_barcode.content);
 
     // auto detected_circles = detect_circles(img, { 0, 0 });
-    std::vector<cv::Vec3f> detected_circles = smaller_parse(img,
+    auto detect = ctx.settings.circle_detector == CircleDetector::BLOBS ? detect_circles_blobs_pyramid
+                                                                        : detect_circles_pyramid;
+    auto detect_quadrant = [detect, scale = ctx.settings.pyramid_scale](int, ScratchBuffers& scratch,
+                                                                        const cv::Mat& quadrant,
+                                                                        const cv::Point2i& offset) {
+        return detect(scratch, quadrant, offset, scale);
+    };
+    std::vector<cv::Vec3f> detected_circles;
+    auto mat = locate_corners_per_quadrant(ctx, img,
 #ifdef DEBUG
-                                                            debug_img,
+                                           debug_img,
 #endif
-                                                            detect_circles);
+                                           detect_quadrant, circle_center, center_of_box(corner_barcode.bounding_box),
+                                           dst_corner_points, detected_circles);
     if (detected_circles.empty()) {
         printf("no circle found\n");
         return {};
@@ -80,23 +216,5 @@ std::optional<cv::Mat> circle_parser(const cv::Mat& img,
     }
 #endif
 
-    std::vector<cv::Point2f> corner_points;
-    std::vector<cv::Point2f> circle_pos;
-
-    for (const auto& c : detected_circles) {
-        circle_pos.push_back(cv::Point2f(c[0], c[1]));
-    }
-
-    auto mask = found_other_point(circle_pos, corner_points, center_of_box(corner_barcode.bounding_box));
-
-#ifdef DEBUG
-    for (int i = 0; i < 4; ++i) {
-        if ((1 << i) & mask)
-            cv::circle(debug_img, corner_points[i], 3, cv::Scalar(0, 255, 255), -1);
-    }
-#endif
-
-    auto mat = get_affine_transform(mask, dst_corner_points, corner_points);
-
     return mat;
 }
@@ -10,6 +10,25 @@
  * de référence à partir de ces cercles.
  */
 
+#include "parser_context.h"
+
+/**
+ * @brief Détecte les disques pleins par composantes connexes et moments
+ *
+ * Alternative à HoughCircles (voir ParserSettings::circle_detector) : l'image est seuillée (Otsu), puis les
+ * composantes sombres sont filtrées sur leur taille, leur rapport largeur/hauteur, leur taux de
+ * remplissage et enfin leur circularité 4π·aire/périmètre², dont le seuil (0.85) écarte les carrés
+ * pleins (π/4) quelle que soit leur orientation. Les marqueurs évidés ("circle-o") ne sont pas
+ * détectés par cette méthode. Avec la pyramide, les candidats de l'image réduite sont aussi cherchés
+ * par composantes connexes.
+ *
+ * @param scratch Tampons du quadrant (image binaire, composantes connexes et contours)
+ * @param img Image (ou quadrant) en niveaux de gris
+ * @param offset Décalage de img dans l'image complète
+ * @return std::vector<cv::Vec3f> Cercles (centre sous-pixellique x, y et rayon équivalent)
+ */
+std::vector<cv::Vec3f> detect_circles_blobs(ScratchBuffers& scratch, const cv::Mat& img, const cv::Point2i& offset);
+
 /**
  * @brief Analyse une image pour détecter des cercles et un code-barres
  * 
@@ -19,6 +38,7 @@
  * 3. Utiliser les centres des cercles détectés comme points de référence
  * 4. Calculer une matrice de transformation basée sur les points détectés
  * 
+ * @param ctx Contexte du thread appelant (tampons et décodeur réutilisés)
  * @param img Image source à analyser
  * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
  * @param meta Structure de métadonnées à remplir depuis le code-barres
@@ -27,7 +47,7 @@
  * 
  * @return Une matrice de transformation optionnelle, ou vide en cas d'échec
  */
-std::optional<cv::Mat> circle_parser(const cv::Mat& img,
+std::optional<cv::Mat> circle_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                      cv::Mat debug_img,
 #endif
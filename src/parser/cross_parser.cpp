@@ -0,0 +1,185 @@
+#include <vector>
+#include <string>
+
+#include <common.h>
+
+#include "json_helper.h"
+#include "parser_helper.h"
+#include "math_utils.h"
+#include "corner_solver.h"
+#include "draw_helper.h"
+
+#include "cross_parser.h"
+
+// mêmes bornes de taille que le parseur SHAPE
+#define MIN_SIZE 25
+#define MAX_SIZE 200
+#define MIN_ASPECT_RATIO 0.75f
+// une croix dont les bras ont une épaisseur de 28 % de sa taille occupe 48 % de son rectangle englobant
+#define MIN_FILL_RATIO 0.3f
+#define MAX_FILL_RATIO 0.7f
+// le carré central doit être plus petit que la croix et proche de son centre
+#define MAX_CORE_RATIO 0.6f
+#define MAX_CORE_OFFSET 0.15f
+
+/**
+ * @brief Ajoute les moments d'ordre 0 et 1 d'une bande de l'image de noirceur
+ */
+static void accumulate_moments(const cv::Mat& darkness, const cv::Rect& band, cv::Point2d& sum, double& weight) {
+    const cv::Rect clipped = band & cv::Rect(0, 0, darkness.cols, darkness.rows);
+    if (clipped.area() == 0)
+        return;
+
+    const cv::Moments m = cv::moments(darkness(clipped));
+    sum.x += m.m10 + m.m00 * clipped.x;
+    sum.y += m.m01 + m.m00 * clipped.y;
+    weight += m.m00;
+}
+
+std::vector<cv::Point2f> detect_crosses(ScratchBuffers& scratch, const cv::Mat& img, const cv::Point2i& offset) {
+    std::vector<cv::Point2f> crosses;
+
+    const double threshold = cv::threshold(img, scratch.binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+
+    const cv::Mat& labels = scratch.labels;
+    const cv::Mat& stats = scratch.stats;
+    int nb_labels = cv::connectedComponentsWithStats(scratch.binary, scratch.labels, scratch.stats, scratch.centroids,
+                                                     8, CV_32S);
+
+    // étiquette 0 : fond
+    for (int label = 1; label < nb_labels; ++label) {
+        const int* stat = stats.ptr<int>(label);
+        const cv::Rect rect(stat[cv::CC_STAT_LEFT], stat[cv::CC_STAT_TOP], stat[cv::CC_STAT_WIDTH],
+                            stat[cv::CC_STAT_HEIGHT]);
+        const int size = std::max(rect.width, rect.height);
+
+        // filtres en temps constant d'abord : seules les composantes restantes sont ouvertes
+        if (std::min(rect.width, rect.height) < MIN_SIZE || size > MAX_SIZE)
+            continue;
+        if (std::min(rect.width, rect.height) < MIN_ASPECT_RATIO * size)
+            continue;
+        const float fill_ratio = (float) stat[cv::CC_STAT_AREA] / rect.area();
+        if (fill_ratio < MIN_FILL_RATIO || fill_ratio > MAX_FILL_RATIO)
+            continue;
+
+        // masques écrits dans la boîte de la composante, au sein de tampons à la taille des étiquettes
+        scratch.mask.create(labels.size(), CV_8U);
+        scratch.horizontal.create(labels.size(), CV_8U);
+        scratch.vertical.create(labels.size(), CV_8U);
+        scratch.core.create(labels.size(), CV_8U);
+        cv::Mat mask = scratch.mask(rect);
+        cv::Mat horizontal = scratch.horizontal(rect);
+        cv::Mat vertical = scratch.vertical(rect);
+        cv::Mat core_mask = scratch.core(rect);
+        cv::compare(labels(rect), label, mask, cv::CMP_EQ);
+
+        // un segment de la moitié de la croix traverse la barre dans sa longueur, pas dans son épaisseur ;
+        // BORDER_ISOLATED : les pixels du tampon hors de la boîte appartiennent à d'autres composantes
+        const int length = size / 2;
+        cv::morphologyEx(mask, horizontal, cv::MORPH_OPEN, cv::getStructuringElement(cv::MORPH_RECT, { length, 1 }),
+                         { -1, -1 }, 1, cv::BORDER_CONSTANT | cv::BORDER_ISOLATED);
+        cv::morphologyEx(mask, vertical, cv::MORPH_OPEN, cv::getStructuringElement(cv::MORPH_RECT, { 1, length }),
+                         { -1, -1 }, 1, cv::BORDER_CONSTANT | cv::BORDER_ISOLATED);
+
+        cv::bitwise_and(horizontal, vertical, core_mask);
+        auto& core_points = scratch.points;
+        cv::findNonZero(core_mask, core_points);
+        if (core_points.empty())
+            continue;
+        const cv::Rect core = cv::boundingRect(core_points);
+
+        if (std::max(core.width, core.height) > MAX_CORE_RATIO * size)
+            continue;
+        const cv::Point2f core_center(core.x + core.width / 2.0f, core.y + core.height / 2.0f);
+        if (std::abs(core_center.x - rect.width / 2.0f) > MAX_CORE_OFFSET * size ||
+            std::abs(core_center.y - rect.height / 2.0f) > MAX_CORE_OFFSET * size)
+            continue;
+
+        // les quatre bras doivent dépasser du carré central
+        const cv::Rect left_arm(0, core.y, core.x, core.height);
+        const cv::Rect right_arm(core.x + core.width, core.y, rect.width - core.x - core.width, core.height);
+        const cv::Rect top_arm(core.x, 0, core.width, core.y);
+        const cv::Rect bottom_arm(core.x, core.y + core.height, core.width, rect.height - core.y - core.height);
+        const int min_arm_area = core.area() / 4;
+        if (left_arm.area() == 0 || right_arm.area() == 0 || top_arm.area() == 0 || bottom_arm.area() == 0)
+            continue;
+        if (cv::countNonZero(horizontal(left_arm)) < min_arm_area ||
+            cv::countNonZero(horizontal(right_arm)) < min_arm_area ||
+            cv::countNonZero(vertical(top_arm)) < min_arm_area || cv::countNonZero(vertical(bottom_arm)) < min_arm_area)
+            continue;
+
+        // noirceur des pixels plus sombres que le seuil : les pixels de bord ne comptent qu'en partie
+        scratch.darkness.create(labels.size(), CV_8U);
+        cv::Mat darkness = scratch.darkness(rect);
+        cv::subtract(cv::Scalar::all(255), img(rect), darkness);
+        cv::threshold(darkness, darkness, 255 - threshold, 0, cv::THRESH_TOZERO);
+
+        // bandes d'un pixel plus larges que les bras, pour inclure leurs bords anticrénelés
+        cv::Point2d horizontal_sum(0, 0), vertical_sum(0, 0);
+        double horizontal_weight = 0, vertical_weight = 0;
+        accumulate_moments(darkness, { left_arm.x, left_arm.y - 1, left_arm.width, left_arm.height + 2 },
+                           horizontal_sum, horizontal_weight);
+        accumulate_moments(darkness, { right_arm.x, right_arm.y - 1, right_arm.width, right_arm.height + 2 },
+                           horizontal_sum, horizontal_weight);
+        accumulate_moments(darkness, { top_arm.x - 1, top_arm.y, top_arm.width + 2, top_arm.height }, vertical_sum,
+                           vertical_weight);
+        accumulate_moments(darkness, { bottom_arm.x - 1, bottom_arm.y, bottom_arm.width + 2, bottom_arm.height },
+                           vertical_sum, vertical_weight);
+        if (horizontal_weight <= 0 || vertical_weight <= 0)
+            continue;
+
+        crosses.emplace_back((float) (vertical_sum.x / vertical_weight) + rect.x + offset.x,
+                             (float) (horizontal_sum.y / horizontal_weight) + rect.y + offset.y);
+    }
+
+    return crosses;
+}
+
+std::optional<cv::Mat> cross_parser(ParserContext& ctx, const cv::Mat& img,
+#ifdef DEBUG
+                                    cv::Mat debug_img,
+#endif
+                                    Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode) {
+    const auto& barcodes =
+        identify_barcodes_near(ctx, img, dst_corner_points, BOTTOM_RIGHT_BF, 1, (ZXing::BarcodeFormat) flag_barcode);
+
+    if (barcodes.empty()) {
+        printf("no barcode found\n");
+        return {};
+    }
+
+#ifdef DEBUG
+    draw_qrcode(barcodes, debug_img);
+#endif
+
+    auto corner_barcode_opt = select_bottom_right_corner(barcodes);
+
+    if (!corner_barcode_opt) {
+        printf("no corner barcode found\n");
+        return {};
+    }
+
+    auto corner_barcode = corner_barcode_opt.value();
+
+    meta = parse_metadata(corner_barcode.content);
+
+    std::vector<cv::Point2f> cross_points;
+    auto mat = locate_corners(ctx, img,
+#ifdef DEBUG
+                              debug_img,
+#endif
+                              detect_crosses, marker_position, center_of_box(corner_barcode.bounding_box),
+                              dst_corner_points, cross_points);
+    if (cross_points.empty()) {
+        printf("no cross found\n");
+        return {};
+    }
+
+#ifdef DEBUG
+    for (const auto& point : cross_points) {
+        cv::circle(debug_img, point, 3, cv::Scalar(0, 255, 0), -1);
+    }
+#endif
+
+    return mat;
+}
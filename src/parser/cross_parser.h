@@ -0,0 +1,58 @@
+#ifndef CROSS_PARSER_H
+#define CROSS_PARSER_H
+
+/**
+ * @file cross_parser.h
+ * @brief Module d'analyse des copies dont les coins portent des croix.
+ *
+ * Les croix sont détectées par ouverture morphologique avec des éléments structurants linéaires :
+ * l'ouverture horizontale ne conserve que la barre horizontale, l'ouverture verticale que la barre
+ * verticale, et leur intersection est le carré central de la croix. Le point d'intersection est
+ * ensuite calculé au sous-pixel à partir des bras.
+ */
+
+#include "parser_context.h"
+
+/**
+ * @brief Détecte les croix pleines d'une image
+ *
+ * Les composantes sombres sont d'abord filtrées sur leur taille, leur rapport largeur/hauteur et
+ * leur taux de remplissage (une croix occupe environ la moitié de son rectangle englobant), puis
+ * seules les composantes restantes sont ouvertes par des segments de la moitié de leur taille.
+ * Une composante est retenue si les deux barres se croisent près de son centre et dépassent de
+ * part et d'autre de leur intersection.
+ *
+ * Le centre retourné est l'intersection des axes des bras : l'ordonnée est le barycentre des bras
+ * gauche et droit, l'abscisse celui des bras haut et bas, pondérés par la noirceur des pixels.
+ *
+ * @param scratch Tampons du quadrant (image binaire et composantes connexes)
+ * @param img Image (ou quadrant) en niveaux de gris
+ * @param offset Décalage de img dans l'image complète
+ * @return std::vector<cv::Point2f> Centres des croix, dans le repère de l'image complète
+ */
+std::vector<cv::Point2f> detect_crosses(ScratchBuffers& scratch, const cv::Mat& img, const cv::Point2i& offset);
+
+/**
+ * @brief Analyse une image pour détecter des croix et un code-barres
+ *
+ * Cette fonction analyse l'image fournie pour:
+ * 1. Décoder le code-barres du coin inférieur droit et en extraire les métadonnées
+ * 2. Détecter les croix dans les quadrants des autres coins
+ * 3. Calculer une matrice de transformation basée sur les points détectés
+ *
+ * @param ctx Contexte du thread appelant (tampons et décodeur réutilisés)
+ * @param img Image source à analyser
+ * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
+ * @param meta Structure de métadonnées à remplir
+ * @param dst_corner_points Points de destination pour la transformation
+ * @param flag_barcode Type de code-barres à détecter
+ *
+ * @return Une matrice de transformation optionnelle, ou vide en cas d'échec
+ */
+std::optional<cv::Mat> cross_parser(ParserContext& ctx, const cv::Mat& img,
+#ifdef DEBUG
+                                    cv::Mat debug_img,
+#endif
+                                    Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode);
+
+#endif // CROSS_PARSER_H
@@ -0,0 +1,143 @@
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <string>
+
+#include <common.h>
+
+#include "json_helper.h"
+#include "parser_helper.h"
+#include "math_utils.h"
+#include "template_matcher.h"
+#include "draw_helper.h"
+
+#include "custom_parser.h"
+
+#define CUSTOM_MARKER_ASSET "assets/marker-custom.svg"
+// sous-répertoire du répertoire temporaire, si le contexte ne précise pas où rendre les modèles
+#define DEFAULT_TEMPLATE_DIR "custom-marker-templates"
+// corrélation minimale pour accepter la position d'un marqueur
+#define MIN_MATCH_SCORE 0.5f
+
+// échelles recherchées autour de la taille nominale : une seule transformée de Fourier par quadrant
+static const std::vector<float> template_scales = { 0.9f, 1.0f, 1.1f };
+
+/**
+ * @brief Modèles du marqueur indexés par Corner, tournés comme dans typst/components/corner_markers.typ
+ */
+using CornerMatchers = std::array<std::unique_ptr<TemplateMatcher>, 3>;
+
+static std::mutex corner_matchers_mutex;
+// indexés par (taille du marqueur en dixièmes de mm, résolution)
+static std::map<std::pair<int, int>, std::shared_ptr<const CornerMatchers>> corner_matchers_cache;
+
+/**
+ * @brief Rend le marqueur à la taille et à la résolution données, une seule fois par processus
+ *
+ * @param template_dir Répertoire où écrire le rendu (vide : répertoire temporaire du système)
+ * @return std::shared_ptr<const CornerMatchers> Modèles des quatre coins, ou nullptr si le rendu a échoué
+ */
+static std::shared_ptr<const CornerMatchers> corner_matchers(float marker_size, int dpi,
+                                                             const std::string& template_dir) {
+    const std::pair<int, int> key((int) std::lround(marker_size * 10), dpi);
+
+    std::lock_guard<std::mutex> lock(corner_matchers_mutex);
+    auto it = corner_matchers_cache.find(key);
+    if (it != corner_matchers_cache.end())
+        return it->second;
+
+    const std::filesystem::path dir = template_dir.empty()
+                                          ? std::filesystem::temp_directory_path() / DEFAULT_TEMPLATE_DIR
+                                          : std::filesystem::path(template_dir);
+    std::filesystem::create_directories(dir);
+    const std::string filename =
+        (dir / ("custom-" + std::to_string(key.first) + "-" + std::to_string(dpi) + ".png")).string();
+    if (!render_marker_template(CUSTOM_MARKER_ASSET, marker_size, dpi, filename))
+        return nullptr;
+
+    cv::Mat templ = cv::imread(filename, cv::IMREAD_GRAYSCALE);
+    if (templ.empty())
+        return nullptr;
+
+    // rotations horaires des coins TL (0°), TR (90°) et BL (270°) ; le coin BR porte le code-barres
+    auto matchers = std::make_shared<CornerMatchers>();
+    cv::Mat rotated;
+    (*matchers)[TOP_LEFT] = std::make_unique<TemplateMatcher>(templ, template_scales);
+    cv::rotate(templ, rotated, cv::ROTATE_90_CLOCKWISE);
+    (*matchers)[TOP_RIGHT] = std::make_unique<TemplateMatcher>(rotated, template_scales);
+    cv::rotate(templ, rotated, cv::ROTATE_90_COUNTERCLOCKWISE);
+    (*matchers)[BOTTOM_LEFT] = std::make_unique<TemplateMatcher>(rotated, template_scales);
+
+    corner_matchers_cache.emplace(key, matchers);
+    return matchers;
+}
+
+static cv::Point2f match_center(const TemplateMatch& match) {
+    return match.center;
+}
+
+std::optional<cv::Mat> custom_parser(ParserContext& ctx, const cv::Mat& img,
+#ifdef DEBUG
+                                     cv::Mat debug_img,
+#endif
+                                     Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode) {
+    const auto& barcodes =
+        identify_barcodes_near(ctx, img, dst_corner_points, BOTTOM_RIGHT_BF, 1, (ZXing::BarcodeFormat) flag_barcode);
+
+    if (barcodes.empty()) {
+        printf("no barcode found\n");
+        return {};
+    }
+
+#ifdef DEBUG
+    draw_qrcode(barcodes, debug_img);
+#endif
+
+    auto corner_barcode_opt = select_bottom_right_corner(barcodes);
+
+    if (!corner_barcode_opt) {
+        printf("no corner barcode found\n");
+        return {};
+    }
+
+    auto corner_barcode = corner_barcode_opt.value();
+
+    meta = parse_metadata(corner_barcode.content);
+
+    if (ctx.page_size.x <= 0 || ctx.corner_marker_size <= 0) {
+        printf("unknown page geometry for the custom marker template\n");
+        return {};
+    }
+
+    const int dpi = (int) std::lround(img.cols * 25.4f / ctx.page_size.x);
+    auto matchers = corner_matchers(ctx.corner_marker_size, dpi, ctx.template_dir);
+    if (!matchers) {
+        printf("could not render the custom marker template\n");
+        return {};
+    }
+
+    // chaque quadrant cherche le modèle tourné comme son coin ; le coin BR porte le code-barres
+    auto match_corner = [&matchers](int corner, ScratchBuffers& scratch, const cv::Mat& quadrant,
+                                    const cv::Point2i& offset) {
+        std::vector<TemplateMatch> found;
+        if (corner == BOTTOM_RIGHT)
+            return found;
+
+        auto match = (*matchers)[corner]->match(scratch.matching, quadrant, offset);
+        if (match.has_value() && match->score >= MIN_MATCH_SCORE)
+            found.push_back(*match);
+        return found;
+    };
+
+    std::vector<TemplateMatch> markers;
+    return locate_corners_per_quadrant(ctx, img,
+#ifdef DEBUG
+                                       debug_img,
+#endif
+                                       match_corner, match_center, center_of_box(corner_barcode.bounding_box),
+                                       dst_corner_points, markers);
+}
@@ -0,0 +1,43 @@
+#ifndef CUSTOM_PARSER_H
+#define CUSTOM_PARSER_H
+
+/**
+ * @file custom_parser.h
+ * @brief Module d'analyse des copies dont les coins portent le marqueur personnalisé (CUSTOM).
+ *
+ * Le marqueur (typst/assets/marker-custom.svg) est rendu une seule fois par Typst à la résolution
+ * de la copie, puis recherché dans le quadrant de chaque coin par corrélation croisée normalisée
+ * (voir template_matcher.h). Les quadrants sont parcourus par locate_corners_per_quadrant, comme pour
+ * les autres parseurs à marqueurs de coin (quadrants parallèles, arrêt anticipé, solve_corners).
+ * Aucun détecteur spécifique n'est nécessaire : remplacer le SVG suffit pour évaluer un autre motif.
+ */
+
+/**
+ * @brief Analyse une image pour localiser le marqueur personnalisé et un code-barres
+ *
+ * Cette fonction analyse l'image fournie pour:
+ * 1. Décoder le code-barres du coin inférieur droit et en extraire les métadonnées
+ * 2. Rechercher le marqueur, tourné comme sur la copie, dans les quadrants des autres coins
+ * 3. Choisir les coins parmi les positions dont le score suffit (solve_corners) et calculer la
+ *    matrice de transformation
+ *
+ * La résolution est estimée à partir de la largeur de l'image et de ctx.page_size, et la taille du
+ * marqueur est ctx.corner_marker_size (voir set_page_geometry) ; l'analyse échoue si elles sont
+ * inconnues. Le modèle est rendu dans ctx.template_dir.
+ *
+ * @param ctx Contexte du thread appelant (tampons et décodeur réutilisés)
+ * @param img Image source à analyser
+ * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
+ * @param meta Structure de métadonnées à remplir
+ * @param dst_corner_points Points de destination pour la transformation
+ * @param flag_barcode Type de code-barres à détecter
+ *
+ * @return Une matrice de transformation optionnelle, ou vide en cas d'échec
+ */
+std::optional<cv::Mat> custom_parser(ParserContext& ctx, const cv::Mat& img,
+#ifdef DEBUG
+                                     cv::Mat debug_img,
+#endif
+                                     Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode);
+
+#endif // CUSTOM_PARSER_H
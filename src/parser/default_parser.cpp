@@ -6,7 +6,7 @@
 #include "default_parser.h"
 #include "parser_helper.h"
 
-std::optional<cv::Mat> default_parser(const cv::Mat& img,
+std::optional<cv::Mat> default_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                       cv::Mat debug_img,
 #endif
@@ -17,6 +17,7 @@
  * mais ne réalise aucun traitement. Elle renvoie toujours
  * un résultat vide (std::optional sans valeur).
  * 
+ * @param ctx Contexte du thread appelant (tampons et décodeur réutilisés)
  * @param img Image source à analyser (non utilisée)
  * @param debug_img Image de débogage (non utilisée)
  * @param meta Structure de métadonnées (non modifiée)
@@ -25,7 +26,7 @@
  * 
  * @return Toujours un std::optional vide
  */
-std::optional<cv::Mat> default_parser(const cv::Mat& img,
+std::optional<cv::Mat> default_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                       cv::Mat debug_img,
 #endif
@@ -0,0 +1,62 @@
+#include <vector>
+#include <string>
+
+#include <common.h>
+
+#include "json_helper.h"
+#include "parser_helper.h"
+#include "math_utils.h"
+#include "corner_solver.h"
+#include "finder_pattern.h"
+#include "draw_helper.h"
+
+#include "qr_eye_parser.h"
+
+std::optional<cv::Mat> qr_eye_parser(ParserContext& ctx, const cv::Mat& img,
+#ifdef DEBUG
+                                     cv::Mat debug_img,
+#endif
+                                     Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode) {
+    const auto& barcodes =
+        identify_barcodes_near(ctx, img, dst_corner_points, BOTTOM_RIGHT_BF, 1, (ZXing::BarcodeFormat) flag_barcode);
+
+    if (barcodes.empty()) {
+        printf("no barcode found\n");
+        return {};
+    }
+
+#ifdef DEBUG
+    draw_qrcode(barcodes, debug_img);
+#endif
+
+    auto corner_barcode_opt = select_bottom_right_corner(barcodes);
+
+    if (!corner_barcode_opt) {
+        printf("no corner barcode found\n");
+        return {};
+    }
+
+    auto corner_barcode = corner_barcode_opt.value();
+
+    meta = parse_metadata(corner_barcode.content);
+
+    std::vector<cv::Point2f> eye_points;
+    auto mat = locate_corners(ctx, img,
+#ifdef DEBUG
+                              debug_img,
+#endif
+                              detect_finder_patterns, marker_position, center_of_box(corner_barcode.bounding_box),
+                              dst_corner_points, eye_points);
+    if (eye_points.empty()) {
+        printf("no qr eye found\n");
+        return {};
+    }
+
+#ifdef DEBUG
+    for (const auto& point : eye_points) {
+        cv::circle(debug_img, point, 3, cv::Scalar(0, 255, 0), -1);
+    }
+#endif
+
+    return mat;
+}
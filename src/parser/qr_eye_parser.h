@@ -0,0 +1,36 @@
+#ifndef QR_EYE_PARSER_H
+#define QR_EYE_PARSER_H
+
+/**
+ * @file qr_eye_parser.h
+ * @brief Module d'analyse des copies dont les coins portent des yeux de code QR.
+ *
+ * Les marqueurs QR_EYE sont des motifs de repérage isolés : ils sont localisés par balayage de
+ * lignes (voir finder_pattern.h), sans décodage. Seul le code-barres du coin inférieur droit est
+ * décodé pour lire les métadonnées.
+ */
+
+/**
+ * @brief Analyse une image pour détecter des yeux de code QR et un code-barres
+ *
+ * Cette fonction analyse l'image fournie pour:
+ * 1. Décoder le code-barres du coin inférieur droit et en extraire les métadonnées
+ * 2. Localiser les motifs de repérage dans les quadrants des autres coins
+ * 3. Calculer une matrice de transformation basée sur les points détectés
+ *
+ * @param ctx Contexte du thread appelant (tampons et décodeur réutilisés)
+ * @param img Image source à analyser
+ * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
+ * @param meta Structure de métadonnées à remplir
+ * @param dst_corner_points Points de destination pour la transformation
+ * @param flag_barcode Type de code-barres à détecter
+ *
+ * @return Une matrice de transformation optionnelle, ou vide en cas d'échec
+ */
+std::optional<cv::Mat> qr_eye_parser(ParserContext& ctx, const cv::Mat& img,
+#ifdef DEBUG
+                                     cv::Mat debug_img,
+#endif
+                                     Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode);
+
+#endif // QR_EYE_PARSER_H
@@ -1,29 +1,27 @@
 #include <vector>
 #include <string>
 
-#ifdef ENABLE_ZBAR
-#include <zbar.h>
-#else
 #include <ZXing/ReadBarcode.h>
-#endif
 
 #include <common.h>
 #include "json_helper.h"
 #include "string_helper.h"
 #include "parser_helper.h"
 #include "math_utils.h"
+#include "corner_solver.h"
 #include "draw_helper.h"
 
 #include "zxing_parser.h"
 
-std::optional<cv::Mat> qrcode_empty_parser(const cv::Mat& img,
+std::optional<cv::Mat> qrcode_empty_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                            cv::Mat debug_img,
 #endif
                                            Metadata& meta, std::vector<cv::Point2f>& dst_corner_points,
                                            int flag_barcode) {
 
-    auto barcodes = identify_barcodes(img, (ZXing::BarcodeFormat) flag_barcode);
+    const auto& barcodes =
+        identify_barcodes_near(ctx, img, dst_corner_points, ALL_CORNERS_BF, 4, (ZXing::BarcodeFormat) flag_barcode);
 
 #ifdef DEBUG
     draw_qrcode(barcodes, debug_img);
@@ -47,14 +45,15 @@ std::optional<cv::Mat> qrcode_empty_parser(const cv::Mat& img,
 
     auto corner_barcode = corner_barcode_opt.value();
 
-    std::vector<cv::Point2f> corner_points;
     std::vector<cv::Point2f> barcode_pos;
 
     for (const auto& barcode : barcodes) {
         barcode_pos.push_back(center_of_box(barcode.bounding_box));
     }
 
-    int found_corner_mask = found_other_point(barcode_pos, corner_points, center_of_box(corner_barcode.bounding_box));
+    auto solution = solve_corners(barcode_pos, center_of_box(corner_barcode.bounding_box), dst_corner_points);
+    const auto& corner_points = solution.corner_points;
+    int found_corner_mask = solution.found_mask;
 
     if (found_corner_mask != (TOP_LEFT_BF | TOP_RIGHT_BF | BOTTOM_LEFT_BF | BOTTOM_RIGHT_BF))
         throw std::invalid_argument("not all corner barcodes were found");
@@ -19,6 +19,7 @@
  * 3. S'il y a moins de 4 codes-barres, retourne une matrice identité
  *    et des métadonnées par défaut plutôt qu'une erreur
  * 
+ * @param ctx Contexte du thread appelant (tampons et décodeur réutilisés)
  * @param img Image source à analyser
  * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
  * @param meta Structure de métadonnées à remplir (valeurs par défaut si non trouvées)
@@ -27,7 +28,7 @@
  * 
  * @return Une matrice de transformation optionnelle, matrice identité en cas d'échec partiel
  */
-std::optional<cv::Mat> qrcode_empty_parser(const cv::Mat& img,
+std::optional<cv::Mat> qrcode_empty_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                            cv::Mat debug_img,
 #endif
@@ -6,6 +6,7 @@
 #include "json_helper.h"
 #include "parser_helper.h"
 #include "math_utils.h"
+#include "corner_solver.h"
 #include "draw_helper.h"
 
 #include "shape_parser.h"
@@ -21,21 +22,21 @@ static bool discriminate(cv::Rect rect) {
     return rect.width > MIN_SIZE && rect.height > MIN_SIZE && rect.width < MAX_SIZE && rect.height < MAX_SIZE;
 }
 
-static std::vector<std::pair<cv::Point2f, cv::Rect>> detect_shape(const cv::Mat& img, const cv::Point2i& offset) {
+static std::vector<std::pair<cv::Point2f, cv::Rect>> detect_shape(ScratchBuffers& scratch, const cv::Mat& img,
+                                                                  const cv::Point2i& offset) {
     std::vector<std::pair<cv::Point2f, cv::Rect>> detected_shapes;
 
-    cv::Mat canny_img;
-    cv::Canny(img, canny_img, 100, 100, 3);
+    cv::Canny(img, scratch.edges, 100, 100, 3);
 
-    std::vector<std::vector<cv::Point>> contours;
-    std::vector<cv::Vec4i> hierarchy; // unused; but could be used in drawContours
-    cv::findContours(canny_img, contours, hierarchy, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE, offset);
+    // hierarchy: unused; but could be used in drawContours
+    cv::findContours(scratch.edges, scratch.contours, scratch.hierarchy, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE,
+                     offset);
 
-    for (const auto& contour : contours) {
+    for (const auto& contour : scratch.contours) {
         if (contour.size() < 5)
             continue;
 
-        cv::Rect rect = cv::boundingRect(cv::Mat(contour));
+        cv::Rect rect = cv::boundingRect(contour);
 
         if (!discriminate(rect))
             continue;
@@ -47,12 +48,119 @@ static std::vector<std::pair<cv::Point2f, cv::Rect>> detect_shape(const cv::Mat&
     return detected_shapes;
 }
 
-std::optional<cv::Mat> shape_parser(const cv::Mat& img,
+// une forme pleine occupe au moins cette proportion de son rectangle englobant (disque : ~0.79)
+#define MIN_FILL_RATIO 0.6f
+// rapport minimal entre le petit et le grand côté du rectangle englobant
+#define MIN_ASPECT_RATIO 0.75f
+
+std::vector<std::pair<cv::Point2f, cv::Rect>> detect_shape_components(ScratchBuffers& scratch, const cv::Mat& img,
+                                                                      const cv::Point2i& offset) {
+    std::vector<std::pair<cv::Point2f, cv::Rect>> detected_shapes;
+
+    cv::threshold(img, scratch.binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+
+    const cv::Mat& stats = scratch.stats;
+    const cv::Mat& centroids = scratch.centroids;
+    int nb_labels = cv::connectedComponentsWithStats(scratch.binary, scratch.labels, scratch.stats, scratch.centroids,
+                                                     8, CV_32S);
+
+    // étiquette 0 : fond
+    for (int label = 1; label < nb_labels; ++label) {
+        const int* stat = stats.ptr<int>(label);
+        cv::Rect rect(stat[cv::CC_STAT_LEFT], stat[cv::CC_STAT_TOP], stat[cv::CC_STAT_WIDTH],
+                      stat[cv::CC_STAT_HEIGHT]);
+
+        if (!discriminate(rect))
+            continue;
+        if (stat[cv::CC_STAT_AREA] < MIN_FILL_RATIO * rect.area())
+            continue;
+        if (std::min(rect.width, rect.height) < MIN_ASPECT_RATIO * std::max(rect.width, rect.height))
+            continue;
+
+        // le centroïde est sous-pixellique, contrairement au centre du rectangle englobant
+        const double* centroid = centroids.ptr<double>(label);
+        rect.x += offset.x;
+        rect.y += offset.y;
+        detected_shapes.push_back({ { (float) centroid[0] + offset.x, (float) centroid[1] + offset.y }, rect });
+    }
+
+    return detected_shapes;
+}
+
+// mêmes bornes que discriminate, ramenées à l'échelle réduite (avec une tolérance d'un pixel)
+static bool discriminate_scaled(cv::Rect rect, int scale) {
+    return rect.width * scale + scale >= MIN_SIZE && rect.height * scale + scale >= MIN_SIZE &&
+           rect.width * scale - scale <= MAX_SIZE && rect.height * scale - scale <= MAX_SIZE;
+}
+
+static std::vector<cv::Rect> contour_candidates(ScratchBuffers& scratch, const cv::Mat& small_img, int scale) {
+    std::vector<cv::Rect> candidates;
+
+    cv::Canny(small_img, scratch.edges, 100, 100, 3);
+    cv::findContours(scratch.edges, scratch.contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+
+    for (const auto& contour : scratch.contours) {
+        cv::Rect rect = cv::boundingRect(contour);
+        if (discriminate_scaled(rect, scale))
+            candidates.emplace_back(rect);
+    }
+
+    return candidates;
+}
+
+/**
+ * @brief Candidats de detect_shape_components sur l'image réduite (mêmes filtres, bornes mises à l'échelle)
+ */
+static std::vector<cv::Rect> component_candidates(ScratchBuffers& scratch, const cv::Mat& small_img, int scale) {
+    std::vector<cv::Rect> candidates;
+
+    cv::threshold(small_img, scratch.binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+    int nb_labels = cv::connectedComponentsWithStats(scratch.binary, scratch.labels, scratch.stats, scratch.centroids,
+                                                     8, CV_32S);
+
+    for (int label = 1; label < nb_labels; ++label) {
+        const int* stat = scratch.stats.ptr<int>(label);
+        cv::Rect rect(stat[cv::CC_STAT_LEFT], stat[cv::CC_STAT_TOP], stat[cv::CC_STAT_WIDTH],
+                      stat[cv::CC_STAT_HEIGHT]);
+
+        // la réduction arrondit les bords : le remplissage et les proportions ne sont pas filtrés ici
+        if (discriminate_scaled(rect, scale))
+            candidates.emplace_back(rect);
+    }
+
+    return candidates;
+}
+
+/**
+ * @brief Détection en deux niveaux d'un quadrant : les deux niveaux partagent les tampons du quadrant
+ *
+ * Chaque méthode de détection cherche ses candidats avec la même méthode sur l'image réduite.
+ *
+ * @param scale Facteur de réduction du contexte (ParserSettings::pyramid_scale)
+ */
+template <std::vector<std::pair<cv::Point2f, cv::Rect>> (*detect)(ScratchBuffers&, const cv::Mat&,
+                                                                  const cv::Point2i&),
+          std::vector<cv::Rect> (*find_candidates)(ScratchBuffers&, const cv::Mat&, int)>
+static std::vector<std::pair<cv::Point2f, cv::Rect>> detect_pyramid(ScratchBuffers& scratch, const cv::Mat& img,
+                                                                    const cv::Point2i& offset, int scale) {
+    return coarse_to_fine_parse(
+        img, offset,
+        [&](const cv::Mat& small_img, int small_scale) { return find_candidates(scratch, small_img, small_scale); },
+        [&](const cv::Mat& window, const cv::Point2i& window_offset) { return detect(scratch, window, window_offset); },
+        scale, 2 * scale);
+}
+
+static cv::Point2f shape_center(const std::pair<cv::Point2f, cv::Rect>& shape) {
+    return shape.first;
+}
+
+std::optional<cv::Mat> shape_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                     cv::Mat debug_img,
 #endif
                                     Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode) {
-    auto barcodes = identify_barcodes(img, (ZXing::BarcodeFormat) flag_barcode);
+    const auto& barcodes =
+        identify_barcodes_near(ctx, img, dst_corner_points, BOTTOM_RIGHT_BF, 1, (ZXing::BarcodeFormat) flag_barcode);
 
     if (barcodes.empty()) {
         printf("no barcode found\n");
@@ -75,13 +183,23 @@ std::optional<cv::Mat> shape_parser(const cv::Mat& img,
     meta = parse_metadata(corner_barcode.content);
 
     // auto detected_shapes = detect_shape(img, { 0, 0 });
-    auto detected_shapes = smaller_parse(img,
+    auto detect = ctx.settings.shape_detector == ShapeDetector::COMPONENTS
+                      ? detect_pyramid<detect_shape_components, component_candidates>
+                      : detect_pyramid<detect_shape, contour_candidates>;
+    auto detect_quadrant = [detect, scale = ctx.settings.pyramid_scale](int, ScratchBuffers& scratch,
+                                                                        const cv::Mat& quadrant,
+                                                                        const cv::Point2i& offset) {
+        return detect(scratch, quadrant, offset, scale);
+    };
+    std::vector<std::pair<cv::Point2f, cv::Rect>> detected_shapes;
+    auto mat = locate_corners_per_quadrant(ctx, img,
 #ifdef DEBUG
-                                         debug_img,
+                                           debug_img,
 #endif
-                                         detect_shape);
+                                           detect_quadrant, shape_center, center_of_box(corner_barcode.bounding_box),
+                                           dst_corner_points, detected_shapes);
     if (detected_shapes.empty()) {
-        printf("no circle found\n");
+        printf("no shape found\n");
         return {};
     }
 
@@ -92,21 +210,5 @@ std::optional<cv::Mat> shape_parser(const cv::Mat& img,
     }
 #endif
 
-    std::vector<cv::Point2f> shape_points;
-    for (const auto& c : detected_shapes) {
-        shape_points.push_back(c.first);
-    }
-
-    std::vector<cv::Point2f> corner_points;
-    auto mask = found_other_point(shape_points, corner_points, center_of_box(corner_barcode.bounding_box));
-
-#ifdef DEBUG
-    for (int i = 0; i < 4; ++i) {
-        if ((1 << i) & mask)
-            cv::circle(debug_img, corner_points[i], 10, cv::Scalar(0, 255, 255), -1);
-    }
-#endif
-
-    auto mat = get_affine_transform(mask, dst_corner_points, corner_points);
     return mat;
 }
\ No newline at end of file
@@ -9,6 +9,23 @@
  * et de localiser des points de référence à partir de ces formes.
  */
 
+#include "parser_context.h"
+
+/**
+ * @brief Détecte les formes pleines par seuillage d'Otsu et composantes connexes
+ *
+ * Alternative à la détection par contours (voir ParserSettings::shape_detector) : les composantes sombres sont
+ * filtrées sur leur taille, leur taux de remplissage et leur rapport largeur/hauteur, sans construire
+ * de contour. Le centre retourné est le centroïde de la composante.
+ *
+ * @param scratch Tampons de travail du quadrant (voir ParserContext)
+ * @param img Image (ou quadrant) en niveaux de gris
+ * @param offset Décalage de img dans l'image complète
+ * @return Centres et rectangles englobants des formes, dans le repère de l'image complète
+ */
+std::vector<std::pair<cv::Point2f, cv::Rect>> detect_shape_components(ScratchBuffers& scratch, const cv::Mat& img,
+                                                                      const cv::Point2i& offset);
+
 /**
  * @brief Analyse une image pour détecter des formes et un code-barres
  *
@@ -17,6 +34,7 @@
  * 2. Identifier les formes et extraire leurs centres
  * 3. Calculer une matrice de transformation basée sur les points détectés
  *
+ * @param ctx Contexte du thread appelant (tampons et décodeur réutilisés)
  * @param img Image source à analyser
  * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
  * @param meta Structure de métadonnées à remplir
@@ -25,7 +43,7 @@
  *
  * @return Une matrice de transformation optionnelle, ou vide en cas d'échec
  */
-std::optional<cv::Mat> shape_parser(const cv::Mat& img,
+std::optional<cv::Mat> shape_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                     cv::Mat debug_img,
 #endif
@@ -6,16 +6,18 @@
 #include "string_helper.h"
 #include "parser_helper.h"
 #include "draw_helper.h"
+#include "finder_pattern.h"
+#include "math_utils.h"
 
 #include "zxing_parser.h"
 
-int identify_corner_barcodes(std::vector<DetectedBarcode>& barcodes, std::vector<cv::Point2f>& corner_points,
-                             std::vector<DetectedBarcode*>& corner_barcodes) {
+int identify_corner_barcodes(const std::vector<DetectedBarcode>& barcodes, std::vector<cv::Point2f>& corner_points,
+                             std::vector<const DetectedBarcode*>& corner_barcodes) {
     corner_points.resize(4);
     corner_barcodes.resize(4);
     int found_mask = 0x00;
 
-    for (auto& barcode : barcodes) {
+    for (const auto& barcode : barcodes) {
         // should contain "hzXY" with XY in {tr, tr, br} or a content hash longer than 4
         if (barcode.content.size() < 4)
             continue;
@@ -38,9 +40,7 @@ int identify_corner_barcodes(std::vector<DetectedBarcode>& barcodes, std::vector
             continue;
         }
 
-        cv::Mat mean_mat;
-        cv::reduce(barcode.bounding_box, mean_mat, 1, cv::REDUCE_AVG);
-        corner_points[pos_found] = cv::Point2f(mean_mat.at<float>(0, 0), mean_mat.at<float>(0, 1));
+        corner_points[pos_found] = center_of_box(barcode.bounding_box);
         corner_barcodes[pos_found] = &barcode;
         int pos_found_bf = 1 << pos_found;
         // printf("found pos=%d -> bf=%d\n", pos_found, pos_found_bf);
@@ -50,10 +50,6 @@ int identify_corner_barcodes(std::vector<DetectedBarcode>& barcodes, std::vector
     return found_mask;
 }
 
-std::vector<DetectedBarcode> get_barcodes(const cv::Mat& img) {
-    return identify_barcodes(img);
-}
-
 int nb_corner_found(int found_mask) {
     int nb_found = 0;
     for (int i = 0; i < 4; ++i) {
@@ -63,21 +59,95 @@ int nb_corner_found(int found_mask) {
     return nb_found;
 }
 
-std::optional<cv::Mat> zxing_parser(const cv::Mat& img,
+/**
+ * @brief Décode le code-barres du coin inférieur droit, qui porte les métadonnées
+ *
+ * Le décodage est limité à une fenêtre autour de sa position attendue (ctx.settings.barcode_search_radius),
+ * ou à défaut au quadrant du coin inférieur droit. Le résultat est écrit dans ctx.barcodes.
+ */
+static const std::vector<DetectedBarcode>& decode_bottom_right(ParserContext& ctx, const cv::Mat& img,
+                                                               const std::vector<cv::Point2f>& dst_corner_points,
+                                                               int flag_barcode) {
+    if (ctx.settings.barcode_search_radius > 0)
+        return identify_barcodes_near(ctx, img, dst_corner_points, BOTTOM_RIGHT_BF, 1,
+                                      (ZXing::BarcodeFormat) flag_barcode);
+
+    const cv::Rect quadrant = corner_quadrant(img.size(), BOTTOM_RIGHT);
+    identify_barcodes(ctx, img(quadrant), (ZXing::BarcodeFormat) flag_barcode);
+    auto& barcodes = ctx.barcodes;
+    for (auto& barcode : barcodes) {
+        for (auto& point : barcode.bounding_box) {
+            point.x += quadrant.x;
+            point.y += quadrant.y;
+        }
+    }
+    return barcodes;
+}
+
+/**
+ * @brief Localise sans les décoder les codes QR des coins TL, TR et BL absents de found_mask
+ *
+ * Chaque code est cherché dans le quadrant de son coin, à partir de ses trois motifs de repérage ; le
+ * quadrant est binarisé dans les tampons du contexte de ce coin.
+ *
+ * @return int Masque (CornerBF) des coins localisés
+ */
+static int locate_corner_qrcodes(ParserContext& ctx, const cv::Mat& img, std::vector<cv::Point2f>& corner_points,
+                                 int found_mask) {
+    int located_mask = 0;
+    for (int corner : { TOP_LEFT, TOP_RIGHT, BOTTOM_LEFT }) {
+        if ((1 << corner) & found_mask)
+            continue;
+
+        const cv::Rect quadrant = corner_quadrant(img.size(), corner);
+        auto center = locate_qr_code(find_finder_patterns(img(quadrant), ctx.quadrants[corner].binary));
+        if (!center.has_value())
+            continue;
+
+        corner_points[corner] = center.value() + cv::Point2f(quadrant.x, quadrant.y);
+        located_mask |= 1 << corner;
+    }
+    return located_mask;
+}
+
+std::optional<cv::Mat> zxing_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                      cv::Mat debug_img,
 #endif
                                      Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode) {
-    auto barcodes = identify_barcodes(img, (ZXing::BarcodeFormat) flag_barcode);
-    // auto barcodes = smaller_parse(img, get_barcodes);
+    // résultat du dernier décodage, conservé dans le contexte pour réutiliser sa capacité
+    const std::vector<DetectedBarcode>& barcodes = ctx.barcodes;
+    std::vector<cv::Point2f> corner_points;
+    std::vector<const DetectedBarcode*> corner_barcodes;
+    int found_corner_mask = 0;
+
+    // seuls les codes QR ont des motifs de repérage : les autres formats sont toujours décodés
+    if (ctx.settings.qr_locate_only && (flag_barcode & (int) ZXing::BarcodeFormat::QRCode)) {
+        decode_bottom_right(ctx, img, dst_corner_points, flag_barcode);
+        found_corner_mask = identify_corner_barcodes(barcodes, corner_points, corner_barcodes);
+        if (found_corner_mask & BOTTOM_RIGHT_BF)
+            found_corner_mask |= locate_corner_qrcodes(ctx, img, corner_points, found_corner_mask);
+
+        if (!(found_corner_mask & BOTTOM_RIGHT_BF) || nb_corner_found(found_corner_mask) < 3) {
+            printf("corner qr codes not located, decoding all barcodes\n");
+            corner_points.clear();
+            corner_barcodes.clear();
+            found_corner_mask = 0;
+        }
+    }
+
+    if (found_corner_mask == 0) {
+        identify_barcodes_near(ctx, img, dst_corner_points, ALL_CORNERS_BF, 3, (ZXing::BarcodeFormat) flag_barcode);
+        found_corner_mask = identify_corner_barcodes(barcodes, corner_points, corner_barcodes);
+    }
 #ifdef DEBUG
     draw_qrcode(barcodes, debug_img);
+    for (int i = 0; i < 4; ++i) {
+        if (((1 << i) & found_corner_mask) && corner_barcodes[i] == nullptr)
+            cv::circle(debug_img, corner_points[i], 10, cv::Scalar(0, 255, 255), -1);
+    }
 #endif
 
-    std::vector<cv::Point2f> corner_points;
-    std::vector<DetectedBarcode*> corner_barcodes;
-    int found_corner_mask = identify_corner_barcodes(barcodes, corner_points, corner_barcodes);
-
     if (nb_corner_found(found_corner_mask) < 3) {
         printf("need at least 3 corner barcodes\n");
         return {};
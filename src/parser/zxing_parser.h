@@ -18,7 +18,12 @@
  * 2. Identifier les codes QR de coin (préfixés par "hz")
  * 3. Extraire les métadonnées des codes détectés
  * 4. Calculer une matrice de transformation basée sur les points détectés
+ *
+ * Si ctx.settings.qr_locate_only est actif, seul le code du coin inférieur droit est décodé : les codes QR
+ * des autres coins sont localisés par leurs motifs de repérage. Si cette localisation échoue,
+ * tous les codes sont décodés comme d'habitude.
  * 
+ * @param ctx Contexte du thread appelant (tampons et décodeur réutilisés)
  * @param img Image source à analyser
  * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
  * @param meta Structure de métadonnées à remplir
@@ -27,7 +32,7 @@
  * 
  * @return Une matrice de transformation optionnelle, ou vide en cas d'échec
  */
-std::optional<cv::Mat> zxing_parser(const cv::Mat& img,
+std::optional<cv::Mat> zxing_parser(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
                                      cv::Mat debug_img,
 #endif
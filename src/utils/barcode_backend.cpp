@@ -0,0 +1,187 @@
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#ifdef ENABLE_ZBAR
+#include <zbar.h>
+#endif
+
+#include "barcode_backend.h"
+
+namespace {
+class ZXingDecoder : public BarcodeDecoder {
+  public:
+    void decode(const cv::Mat& img, const cv::Point2i& offset, ZXing::BarcodeFormats formats,
+                std::vector<DetectedBarcode>& barcodes) override {
+        // ZXing lit directement la fenêtre grâce au pas entre les lignes : aucune copie n'est nécessaire
+        auto iv = ZXing::ImageView(reinterpret_cast<const uint8_t*>(img.ptr()), img.cols, img.rows,
+                                   ZXing::ImageFormat::Lum, (int) img.step);
+        options_.setFormats(formats);
+        auto z_barcodes = ZXing::ReadBarcodes(iv, options_);
+        for (const auto& b : z_barcodes) {
+            DetectedBarcode& barcode = barcodes.emplace_back();
+            barcode.content = b.text();
+
+            barcode.bounding_box.reserve(4);
+            for (int j = 0; j < 4; ++j) {
+                const auto& p = b.position()[j];
+                barcode.bounding_box.emplace_back(cv::Point2f(p.x + offset.x, p.y + offset.y));
+            }
+        }
+    }
+
+  private:
+    ZXing::ReaderOptions options_; ///< Seuls les formats changent d'un appel à l'autre
+};
+
+#ifdef ENABLE_ZBAR
+/// Formats ZXing que zbar sait lire, avec le type de symbole zbar correspondant
+const std::pair<ZXing::BarcodeFormat, zbar::zbar_symbol_type_t> zbar_symbols[] = {
+    { ZXing::BarcodeFormat::QRCode, zbar::ZBAR_QRCODE },   { ZXing::BarcodeFormat::EAN8, zbar::ZBAR_EAN8 },
+    { ZXing::BarcodeFormat::EAN13, zbar::ZBAR_EAN13 },     { ZXing::BarcodeFormat::UPCA, zbar::ZBAR_UPCA },
+    { ZXing::BarcodeFormat::UPCE, zbar::ZBAR_UPCE },       { ZXing::BarcodeFormat::Code39, zbar::ZBAR_CODE39 },
+    { ZXing::BarcodeFormat::Code93, zbar::ZBAR_CODE93 },   { ZXing::BarcodeFormat::Code128, zbar::ZBAR_CODE128 },
+    { ZXing::BarcodeFormat::ITF, zbar::ZBAR_I25 },         { ZXing::BarcodeFormat::Codabar, zbar::ZBAR_CODABAR },
+    { ZXing::BarcodeFormat::DataBar, zbar::ZBAR_DATABAR }, { ZXing::BarcodeFormat::PDF417, zbar::ZBAR_PDF417 },
+};
+
+class ZbarDecoder : public BarcodeDecoder {
+  public:
+    void decode(const cv::Mat& img, const cv::Point2i& offset, ZXing::BarcodeFormats formats,
+                std::vector<DetectedBarcode>& barcodes) override {
+        // symboles à activer, un bit par entrée de zbar_symbols
+        int symbols = 0;
+        for (size_t i = 0; i < std::size(zbar_symbols); ++i) {
+            if (formats.testFlag(zbar_symbols[i].first))
+                symbols |= 1 << i;
+        }
+        if (symbols == 0)
+            return;
+
+        if (scanner_symbols_ != symbols) {
+            scanner_.set_config(zbar::ZBAR_NONE, zbar::ZBAR_CFG_ENABLE, 0);
+            for (size_t i = 0; i < std::size(zbar_symbols); ++i) {
+                if (symbols & (1 << i))
+                    scanner_.set_config(zbar_symbols[i].second, zbar::ZBAR_CFG_ENABLE, 1);
+            }
+            scanner_symbols_ = symbols;
+        }
+
+        // zbar attend des lignes contiguës : les fenêtres sont recopiées dans le tampon du décodeur
+        const cv::Mat* contiguous = &img;
+        if (!img.isContinuous()) {
+            img.copyTo(window_);
+            contiguous = &window_;
+        }
+        // la longueur est celle du tampon effectivement transmis (Y800 : un octet par pixel)
+        zbar::Image image(contiguous->cols, contiguous->rows, "Y800", contiguous->data,
+                          (unsigned long) (contiguous->total() * contiguous->elemSize()));
+        scanner_.scan(image);
+
+        for (zbar::Image::SymbolIterator symbol = image.symbol_begin(); symbol != image.symbol_end(); ++symbol) {
+            DetectedBarcode& barcode = barcodes.emplace_back();
+            barcode.content = symbol->get_data();
+
+            for (int i = 0; i < symbol->get_location_size(); i++) {
+                barcode.bounding_box.emplace_back(
+                    cv::Point2f(symbol->get_location_x(i) + offset.x, symbol->get_location_y(i) + offset.y));
+            }
+        }
+    }
+
+  private:
+    zbar::ImageScanner scanner_;
+    int scanner_symbols_ = -1; ///< Symboles activés dans scanner_ (-1 : pas encore configuré)
+    cv::Mat window_;           ///< Copie contiguë d'une fenêtre à décoder
+};
+#endif
+
+class OpenCvQrDecoder : public BarcodeDecoder {
+  public:
+    void decode(const cv::Mat& img, const cv::Point2i& offset, ZXing::BarcodeFormats formats,
+                std::vector<DetectedBarcode>& barcodes) override {
+        if (!formats.testFlag(ZXing::BarcodeFormat::QRCode))
+            return;
+
+        contents_.clear();
+        if (!detector_.detectAndDecodeMulti(img, contents_, points_))
+            return;
+        if (points_.total() != 4 * contents_.size() || !points_.isContinuous())
+            return;
+
+        const cv::Point2f* corners = points_.ptr<cv::Point2f>();
+        for (size_t i = 0; i < contents_.size(); ++i) {
+            // un code localisé mais non décodé a un contenu vide
+            if (contents_[i].empty())
+                continue;
+
+            DetectedBarcode& barcode = barcodes.emplace_back();
+            barcode.content = contents_[i];
+            barcode.bounding_box.reserve(4);
+            for (int j = 0; j < 4; ++j) {
+                const cv::Point2f& p = corners[4 * i + j];
+                barcode.bounding_box.emplace_back(cv::Point2f(p.x + offset.x, p.y + offset.y));
+            }
+        }
+    }
+
+  private:
+    cv::QRCodeDetector detector_;
+    std::vector<std::string> contents_;
+    cv::Mat points_; ///< Quatre coins (CV_32FC2) par code trouvé
+};
+} // namespace
+
+bool barcode_backend_available(BarcodeBackend backend) {
+#ifndef ENABLE_ZBAR
+    if (backend == BarcodeBackend::ZBAR)
+        return false;
+#endif
+    return (int) backend >= 0 && (int) backend < NB_BARCODE_BACKENDS;
+}
+
+std::vector<BarcodeBackend> available_barcode_backends() {
+    std::vector<BarcodeBackend> backends;
+    for (int i = 0; i < NB_BARCODE_BACKENDS; ++i) {
+        if (barcode_backend_available((BarcodeBackend) i))
+            backends.emplace_back((BarcodeBackend) i);
+    }
+    return backends;
+}
+
+std::unique_ptr<BarcodeDecoder> make_barcode_decoder(BarcodeBackend backend) {
+    switch (backend) {
+        case BarcodeBackend::ZXING:
+            return std::make_unique<ZXingDecoder>();
+#ifdef ENABLE_ZBAR
+        case BarcodeBackend::ZBAR:
+            return std::make_unique<ZbarDecoder>();
+#endif
+        case BarcodeBackend::OPENCV_QR:
+            return std::make_unique<OpenCvQrDecoder>();
+        default:
+            throw std::invalid_argument("barcode backend '" + barcode_backend_to_string(backend) +
+                                        "' is not available in this build");
+    }
+}
+
+std::optional<BarcodeBackend> string_to_barcode_backend(const std::string& name) {
+    if (name == "zxing")
+        return BarcodeBackend::ZXING;
+    if (name == "zbar")
+        return BarcodeBackend::ZBAR;
+    if (name == "opencv-qr")
+        return BarcodeBackend::OPENCV_QR;
+    return std::nullopt;
+}
+
+std::string barcode_backend_to_string(BarcodeBackend backend) {
+    switch (backend) {
+        case BarcodeBackend::ZBAR:
+            return "zbar";
+        case BarcodeBackend::OPENCV_QR:
+            return "opencv-qr";
+        default:
+            return "zxing";
+    }
+}
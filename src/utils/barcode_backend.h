@@ -0,0 +1,100 @@
+#ifndef BARCODE_BACKEND_H
+#define BARCODE_BACKEND_H
+
+/**
+ * @file barcode_backend.h
+ * @brief Bibliothèques de décodage des codes-barres, choisies à l'exécution.
+ *
+ * Trois bibliothèques peuvent décoder les codes-barres des copies : ZXing (toujours disponible),
+ * zbar (si le projet est compilé avec ENABLE_ZBAR) et le détecteur de codes QR d'OpenCV
+ * (cv::QRCodeDetector, codes QR uniquement). Chacune est encapsulée dans un BarcodeDecoder qui
+ * conserve son état (options, scanner, tampons) d'un appel à l'autre ; le décodeur utilisé par les
+ * parseurs est choisi par ParserSettings::barcode_backend, sans recompilation.
+ *
+ * Les formats recherchés sont toujours exprimés en ZXing::BarcodeFormats ; les formats qu'une
+ * bibliothèque ne sait pas lire sont ignorés par son décodeur.
+ */
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <ZXing/ReadBarcode.h>
+#include <common.h>
+
+/**
+ * @brief Structure représentant un code-barres détecté dans l'image
+ */
+struct DetectedBarcode {
+    std::string content;                   ///< Contenu décodé du code-barres
+    std::vector<cv::Point2f> bounding_box; ///< Points délimitant le contour du code-barres
+};
+
+/**
+ * @brief Bibliothèque de décodage des codes-barres
+ */
+enum class BarcodeBackend {
+    ZXING,     ///< ZXing
+    ZBAR,      ///< zbar (uniquement avec ENABLE_ZBAR)
+    OPENCV_QR, ///< cv::QRCodeDetector (codes QR uniquement)
+};
+
+/**
+ * @brief Nombre de valeurs de BarcodeBackend
+ */
+constexpr int NB_BARCODE_BACKENDS = 3;
+
+/**
+ * @brief Décodeur de codes-barres d'une bibliothèque donnée
+ *
+ * Un décodeur conserve son état d'un appel à l'autre et ne doit être utilisé que par un seul thread
+ * à la fois (voir ParserContext::decoder).
+ */
+class BarcodeDecoder {
+  public:
+    virtual ~BarcodeDecoder() = default;
+
+    /**
+     * @brief Décode les codes-barres d'une image et les ajoute à barcodes, décalés de offset
+     *
+     * @param img Image en niveaux de gris (CV_8U), éventuellement une fenêtre d'une image plus grande
+     * @param offset Décalage de img dans l'image complète, ajouté aux positions retournées
+     * @param formats Formats à rechercher
+     * @param barcodes Codes-barres décodés (complété, jamais vidé)
+     */
+    virtual void decode(const cv::Mat& img, const cv::Point2i& offset, ZXing::BarcodeFormats formats,
+                        std::vector<DetectedBarcode>& barcodes) = 0;
+};
+
+/**
+ * @brief Indique si une bibliothèque est disponible dans cette compilation
+ */
+bool barcode_backend_available(BarcodeBackend backend);
+
+/**
+ * @brief Bibliothèques disponibles dans cette compilation, dans l'ordre de BarcodeBackend
+ */
+std::vector<BarcodeBackend> available_barcode_backends();
+
+/**
+ * @brief Crée un décodeur pour une bibliothèque
+ *
+ * @throw std::invalid_argument Si la bibliothèque n'est pas disponible dans cette compilation
+ */
+std::unique_ptr<BarcodeDecoder> make_barcode_decoder(BarcodeBackend backend);
+
+/**
+ * @brief Convertit un nom de bibliothèque ("zxing", "zbar" ou "opencv-qr") en BarcodeBackend
+ *
+ * @param name Nom de la bibliothèque
+ * @return std::optional<BarcodeBackend> Bibliothèque correspondante, ou nullopt si le nom est inconnu
+ */
+std::optional<BarcodeBackend> string_to_barcode_backend(const std::string& name);
+
+/**
+ * @brief Convertit un BarcodeBackend en nom de bibliothèque ("zxing", "zbar" ou "opencv-qr")
+ */
+std::string barcode_backend_to_string(BarcodeBackend backend);
+
+#endif // BARCODE_BACKEND_H
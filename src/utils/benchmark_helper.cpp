@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
@@ -112,18 +113,18 @@ BenchmarkSetup prepare_benchmark_directories(const std::string& output_dir, bool
 /**
  * @brief Dessine un contour autour d'une boîte
  *
- * @param box La boîte atomique à dessiner
+ * @param box La boîte à dessiner (en mm)
  * @param image L'image sur laquelle dessiner
  * @param src_size Dimensions de l'image source
  * @param dst_size Dimensions de l'image de destination
  * @param color Couleur du contour
  * @param thickness Épaisseur de la ligne
  */
-void draw_box_outline(const std::shared_ptr<AtomicBox>& box, cv::Mat& image, const cv::Point2f& src_size,
-                      const cv::Point2f& dst_size, const cv::Scalar& color, int thickness) {
+void draw_box_outline(const LayoutRect& box, cv::Mat& image, const cv::Point2f& src_size, const cv::Point2f& dst_size,
+                      const cv::Scalar& color, int thickness) {
     std::vector<cv::Point> raster_box = convert_to_raster(
-        { cv::Point2f{ box->x, box->y }, cv::Point2f{ box->x + box->width, box->y },
-          cv::Point2f{ box->x + box->width, box->y + box->height }, cv::Point2f{ box->x, box->y + box->height } },
+        { cv::Point2f{ box.x, box.y }, cv::Point2f{ box.x + box.width, box.y },
+          cv::Point2f{ box.x + box.width, box.y + box.height }, cv::Point2f{ box.x, box.y + box.height } },
         src_size, dst_size);
     cv::polylines(image, raster_box, true, color, thickness);
 }
@@ -131,7 +132,7 @@ void draw_box_outline(const std::shared_ptr<AtomicBox>& box, cv::Mat& image, con
 /**
  * @brief Dessine un cercle au centre d'une boîte
  *
- * @param box La boîte atomique
+ * @param box La boîte (en mm)
  * @param image L'image sur laquelle dessiner
  * @param src_size Dimensions de l'image source
  * @param dst_size Dimensions de l'image de destination
@@ -139,10 +140,9 @@ void draw_box_outline(const std::shared_ptr<AtomicBox>& box, cv::Mat& image, con
  * @param radius Rayon du cercle
  * @param thickness Épaisseur du cercle (-1 pour rempli)
  */
-void draw_box_center(const std::shared_ptr<AtomicBox>& box, cv::Mat& image, const cv::Point2f& src_size,
-                     const cv::Point2f& dst_size, const cv::Scalar& color, int radius, int thickness) {
-    cv::Point center =
-        convert_to_raster({ cv::Point2f{ box->x + box->width / 2, box->y + box->height / 2 } }, src_size, dst_size)[0];
+void draw_box_center(const LayoutRect& box, cv::Mat& image, const cv::Point2f& src_size, const cv::Point2f& dst_size,
+                     const cv::Scalar& color, int radius, int thickness) {
+    cv::Point center = convert_to_raster({ box.center() }, src_size, dst_size)[0];
     cv::circle(image, center, radius, color, thickness);
 }
 
@@ -236,4 +236,85 @@ std::vector<double> calculate_precision_error(const cv::Point2f& dst_img_size, c
 
 std::string get_metadata_path(const std::string& filename) {
     return "./copies/metadata/" + filename + ".json";
+}
+
+ParserSettings parser_settings_from_config(const std::unordered_map<std::string, Config>& config) {
+    auto flag = [&](const std::string& name, bool& value) {
+        if (config.find(name) != config.end())
+            value = std::get<int>(config.at(name).value) != 0;
+    };
+
+    ParserSettings settings;
+    flag("parallel-quadrants", settings.parallel_quadrants);
+    flag("early-quadrant-stop", settings.early_quadrant_stop);
+    flag("qr-locate-only", settings.qr_locate_only);
+    flag("corner-layout-pruning", settings.corner_layout_pruning);
+    if (config.find("barcode-search-radius") != config.end())
+        settings.barcode_search_radius = std::max(0, std::get<int>(config.at("barcode-search-radius").value));
+    if (config.find("pyramid-scale") != config.end())
+        settings.pyramid_scale = pyramid_scale_factor(std::get<int>(config.at("pyramid-scale").value));
+    return settings;
+}
+
+MicroBenchSetup prepare_micro_bench(const std::unordered_map<std::string, Config>& config, bool generate_copies) {
+    MicroBenchSetup setup;
+    std::string csv_filename;
+    try {
+        setup.iterations = std::get<int>(config.at("iterations").value);
+        setup.master_seed = std::get<int>(config.at("seed").value);
+        setup.csv_mode = std::get<std::string>(config.at("csv-mode").value) == "append" ? CsvMode::APPEND
+                                                                                          : CsvMode::OVERWRITE;
+        csv_filename = std::get<std::string>(config.at("csv-filename").value);
+
+        if (generate_copies) {
+            setup.nb_copies = std::get<int>(config.at("nb-copies").value);
+            auto marker_config = std::get<std::string>(config.at("marker-config").value);
+            if (CopyMarkerConfig::fromString(marker_config, setup.copy_marker_config) != 0) {
+                throw std::invalid_argument("Invalid marker configuration: " + marker_config);
+            }
+
+            setup.style_params.encoded_marker_size = std::get<int>(config.at("encoded-marker-size").value);
+            setup.style_params.unencoded_marker_size = std::get<int>(config.at("unencoded-marker-size").value);
+            setup.style_params.header_marker_size = std::get<int>(config.at("header-marker-size").value);
+            setup.style_params.grey_level = std::get<int>(config.at("grey-level").value);
+            setup.style_params.dpi = std::get<int>(config.at("dpi").value);
+        }
+    } catch (const std::out_of_range& e) {
+        throw std::invalid_argument("Missing required parameter in configuration");
+    } catch (const std::bad_variant_access& e) {
+        throw std::invalid_argument("Invalid parameter type in configuration");
+    }
+    if (setup.iterations < 1) {
+        throw std::invalid_argument("iterations must be at least 1");
+    }
+
+    BenchmarkSetup benchmark_setup = prepare_benchmark_directories("./output", false, false, setup.csv_mode);
+    setup.csv_path = benchmark_setup.csv_output_dir / csv_filename;
+    return setup;
+}
+
+std::mt19937 micro_bench_generator(int master_seed) {
+    std::mt19937 gen;
+    if (master_seed != 0) {
+        gen.seed(master_seed);
+    } else {
+        std::random_device rd;
+        gen.seed(rd());
+    }
+    return gen;
+}
+
+cv::Mat generate_micro_bench_copy(const MicroBenchSetup& setup, std::mt19937& gen, const std::string& copy_name) {
+    CopyStyleParams local_style_params = setup.style_params;
+    local_style_params.seed = gen();
+    if (!create_copy(local_style_params, setup.copy_marker_config, copy_name, false)) {
+        throw std::runtime_error("Copy creation failed, stopping benchmark");
+    }
+
+    std::string filename = copy_name + ".png";
+    cv::Mat img = cv::imread("./copies/" + filename, cv::IMREAD_GRAYSCALE);
+    if (img.empty()) {
+        std::cerr << "Error: Could not read generated image: " << filename << std::endl;
+    }
+    return img;
 }
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include <fstream>
 #include <optional>
 #include <functional>
+#include <random>
 #include <common.h>
 #include "../external-tools/create_copy.h"
 #include "utils/cli_helper.h"
@@ -92,12 +93,68 @@ struct BenchmarkSetup {
  */
 BenchmarkSetup prepare_benchmark_directories(const std::string& output_dir, bool include_success_column = false,
                                              bool create_subimg_dir = false, CsvMode csv_mode = CsvMode::OVERWRITE);
-void draw_box_outline(const std::shared_ptr<AtomicBox>& box, cv::Mat& image, const cv::Point2f& src_size,
-                      const cv::Point2f& dst_size, const cv::Scalar& color, int thickness = 2);
-void draw_box_center(const std::shared_ptr<AtomicBox>& box, cv::Mat& image, const cv::Point2f& src_size,
-                     const cv::Point2f& dst_size, const cv::Scalar& color, int radius = 3, int thickness = -1);
+void draw_box_outline(const LayoutRect& box, cv::Mat& image, const cv::Point2f& src_size, const cv::Point2f& dst_size,
+                      const cv::Scalar& color, int thickness = 2);
+void draw_box_center(const LayoutRect& box, cv::Mat& image, const cv::Point2f& src_size, const cv::Point2f& dst_size,
+                     const cv::Scalar& color, int radius = 3, int thickness = -1);
 std::vector<double> calculate_precision_error(const cv::Point2f& dst_img_size, const cv::Mat& transform_matrix,
                                               const cv::Mat& rectification_transform, float margin);
 std::string get_metadata_path(const std::string& filename);
 
+/**
+ * @brief Lit les réglages des parseurs communs aux benchmarks d'analyse
+ *
+ * Options lues si présentes : parallel-quadrants, early-quadrant-stop, barcode-search-radius,
+ * qr-locate-only, pyramid-scale et corner-layout-pruning. Les méthodes de détection et la bibliothèque
+ * de décodage, que chaque benchmark peut comparer sur plusieurs passes, restent à sa charge.
+ *
+ * @param config Configuration du benchmark
+ * @return ParserSettings Réglages à copier dans le contexte du parseur
+ */
+ParserSettings parser_settings_from_config(const std::unordered_map<std::string, Config>& config);
+
+/**
+ * @brief Réglages communs des micro-benchmarks (aruco-bench, corner-solver-bench, degradation-bench)
+ *
+ * Les champs des copies ne sont renseignés que pour les benchmarks qui en génèrent.
+ */
+struct MicroBenchSetup {
+    int iterations = 1;
+    int master_seed = 0;
+    CsvMode csv_mode = CsvMode::OVERWRITE;
+    std::filesystem::path csv_path;
+
+    int nb_copies = 0;
+    CopyStyleParams style_params;
+    CopyMarkerConfig copy_marker_config;
+};
+
+/**
+ * @brief Valide les options communes d'un micro-benchmark et prépare son répertoire de sortie
+ *
+ * Options lues : iterations, seed, csv-mode et csv-filename ; avec generate_copies, aussi nb-copies,
+ * marker-config, encoded-marker-size, unencoded-marker-size, header-marker-size, grey-level et dpi.
+ *
+ * @param config Configuration du benchmark
+ * @param generate_copies Indique si le benchmark mesure des copies générées
+ * @return MicroBenchSetup Réglages validés et chemin du fichier CSV
+ * @throws std::invalid_argument Si un paramètre requis est manquant ou invalide
+ */
+MicroBenchSetup prepare_micro_bench(const std::unordered_map<std::string, Config>& config, bool generate_copies);
+
+/**
+ * @brief Générateur des graines d'un micro-benchmark
+ *
+ * @param master_seed Graine maîtresse (si 0, tirée par std::random_device)
+ */
+std::mt19937 micro_bench_generator(int master_seed);
+
+/**
+ * @brief Génère une copie de micro-benchmark avec une graine de contenu tirée de gen et la relit en niveaux de gris
+ *
+ * @return cv::Mat Image de la copie, vide si elle n'a pas pu être relue
+ * @throws std::runtime_error Si la copie n'a pas pu être créée
+ */
+cv::Mat generate_micro_bench_copy(const MicroBenchSetup& setup, std::mt19937& gen, const std::string& copy_name);
+
 #endif
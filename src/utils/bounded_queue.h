@@ -0,0 +1,95 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+/**
+ * @file bounded_queue.h
+ * @brief File d'attente bornée et bloquante pour relier les étages d'un pipeline.
+ *
+ * Un producteur est bloqué lorsque la file est pleine, ce qui limite la mémoire consommée
+ * par les éléments en attente et fait naturellement ralentir les étages les plus rapides
+ * au rythme du plus lent.
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/**
+ * @brief File d'attente bornée, multi-producteurs et multi-consommateurs
+ *
+ * Une fois fermée avec close(), la file refuse les nouveaux éléments et les consommateurs
+ * récupèrent les éléments restants avant d'être notifiés de la fin.
+ *
+ * @tparam T Type des éléments de la file
+ */
+template <typename T> class BoundedQueue {
+  public:
+    /**
+     * @brief Construit une file bornée
+     *
+     * @param capacity Nombre maximal d'éléments dans la file (au moins 1)
+     */
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity == 0 ? 1 : capacity) {
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Ajoute un élément, en bloquant tant que la file est pleine
+     *
+     * @param value Élément à ajouter
+     * @return bool false si la file a été fermée (l'élément n'est pas ajouté)
+     */
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]() { return closed_ || items_.size() < capacity_; });
+        if (closed_)
+            return false;
+        items_.emplace_back(std::move(value));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Retire un élément, en bloquant tant que la file est vide et ouverte
+     *
+     * @param value Élément retiré (non modifié si la file est terminée)
+     * @return bool false si la file est fermée et vide
+     */
+    bool pop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+        if (items_.empty())
+            return false;
+        value = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Ferme la file et réveille tous les threads en attente
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    const size_t capacity_;
+    bool closed_ = false;
+};
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,89 @@
+#include <stdexcept>
+#include <filesystem>
+
+#include "box_stats.h"
+
+namespace {
+/**
+ * @brief Somme des valeurs d'une image intégrale sur un rectangle
+ */
+template <typename T> double rect_sum(const cv::Mat& integral, const cv::Rect& rect) {
+    const int x1 = rect.x, y1 = rect.y;
+    const int x2 = rect.x + rect.width, y2 = rect.y + rect.height;
+    return (double) integral.at<T>(y2, x2) - integral.at<T>(y1, x2) - integral.at<T>(y2, x1) + integral.at<T>(y1, x1);
+}
+} // namespace
+
+FillIntegral::FillIntegral(const cv::Mat& img, int dark_threshold) {
+    cv::Mat gray;
+    if (img.channels() == 1)
+        gray = img;
+    else
+        cv::extractChannel(img, gray, 0);
+
+    cv::integral(gray, gray_sum_, CV_64F);
+
+    // masque 0/1 des pixels sombres : valeur < dark_threshold
+    cv::Mat dark_mask;
+    cv::threshold(gray, dark_mask, dark_threshold - 1, 1, cv::THRESH_BINARY_INV);
+    cv::integral(dark_mask, dark_sum_, CV_32S);
+}
+
+BoxStats FillIntegral::box_stats(const cv::Rect& rect, int inner_margin) const {
+    const cv::Rect bounds(0, 0, gray_sum_.cols - 1, gray_sum_.rows - 1);
+    const cv::Rect box = rect & bounds;
+
+    BoxStats stats{ 0.0f, 0.0f, {} };
+    if (box.area() == 0)
+        return stats;
+
+    const double area = box.area();
+    stats.mean_darkness = (float) (1.0 - rect_sum<double>(gray_sum_, box) / (255.0 * area));
+    stats.dark_ratio = (float) (rect_sum<int>(dark_sum_, box) / area);
+
+    if (inner_margin >= 0) {
+        const cv::Rect inner(box.x + inner_margin, box.y + inner_margin, box.width - 2 * inner_margin,
+                             box.height - 2 * inner_margin);
+        if (inner.width > 0 && inner.height > 0)
+            stats.inner_dark_ratio = (float) (rect_sum<int>(dark_sum_, inner) / (double) inner.area());
+    }
+    return stats;
+}
+
+BoxStatsWriter::BoxStatsWriter(const std::string& filename) {
+    format_ = std::filesystem::path(filename).extension() == ".jsonl" ? BoxStatsFormat::JSONL : BoxStatsFormat::CSV;
+
+    out_.open(filename, std::ios::out | std::ios::trunc);
+    if (!out_.is_open()) {
+        throw std::runtime_error("Failed to open box stats file: " + filename);
+    }
+    if (format_ == BoxStatsFormat::CSV) {
+        out_ << "id,page,box,mean_darkness,dark_ratio,inner_dark_ratio" << std::endl;
+    }
+}
+
+void BoxStatsWriter::write(int id, int page, const std::vector<std::pair<std::string, BoxStats>>& stats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [box_id, box_stats] : stats) {
+        if (format_ == BoxStatsFormat::JSONL) {
+            json line = {
+                { "id", id },
+                { "page", page },
+                { "box", box_id },
+                { "mean_darkness", box_stats.mean_darkness },
+                { "dark_ratio", box_stats.dark_ratio },
+                { "inner_dark_ratio", nullptr },
+            };
+            if (box_stats.inner_dark_ratio.has_value())
+                line["inner_dark_ratio"] = box_stats.inner_dark_ratio.value();
+            out_ << line.dump() << "\n";
+        } else {
+            out_ << id << "," << page << "," << box_id << "," << box_stats.mean_darkness << ","
+                 << box_stats.dark_ratio << ",";
+            if (box_stats.inner_dark_ratio.has_value())
+                out_ << box_stats.inner_dark_ratio.value();
+            out_ << "\n";
+        }
+    }
+    out_.flush();
+}
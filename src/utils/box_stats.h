@@ -0,0 +1,97 @@
+#ifndef BOX_STATS_H
+#define BOX_STATS_H
+
+/**
+ * @file box_stats.h
+ * @brief Statistiques de remplissage des zones d'une copie redressée.
+ *
+ * Les statistiques sont calculées à partir d'images intégrales : une fois l'image intégrale
+ * d'une page construite, les statistiques de chaque zone sont obtenues en temps constant,
+ * quelle que soit sa taille. Cela permet de décider si une case est cochée sans écrire puis
+ * relire une sous-image par zone.
+ */
+
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <common.h>
+
+/**
+ * @brief Statistiques de remplissage d'une zone
+ */
+struct BoxStats {
+    float mean_darkness;                   ///< Noirceur moyenne, entre 0 (blanc) et 1 (noir)
+    float dark_ratio;                      ///< Proportion de pixels plus sombres que le seuil
+    std::optional<float> inner_dark_ratio; ///< Proportion de pixels sombres à l'intérieur de la bordure
+};
+
+/**
+ * @brief Images intégrales d'une page (ou d'une zone) redressée
+ */
+class FillIntegral {
+  public:
+    /**
+     * @brief Construit les images intégrales d'une image
+     *
+     * @param img Image en niveaux de gris ou BGR (seul le premier canal est utilisé)
+     * @param dark_threshold Un pixel est considéré sombre si sa valeur est strictement inférieure au seuil
+     */
+    FillIntegral(const cv::Mat& img, int dark_threshold);
+
+    /**
+     * @brief Calcule les statistiques d'une zone en temps constant
+     *
+     * @param rect Zone en pixels (tronquée aux bords de l'image)
+     * @param inner_margin Marge en pixels retirée de chaque côté pour le ratio intérieur,
+     *        ou valeur négative pour ne pas le calculer
+     * @return BoxStats Statistiques de la zone (nulles si la zone est vide)
+     */
+    BoxStats box_stats(const cv::Rect& rect, int inner_margin = -1) const;
+
+  private:
+    cv::Mat gray_sum_; ///< Somme des niveaux de gris (CV_64F)
+    cv::Mat dark_sum_; ///< Nombre de pixels sombres (CV_32S)
+};
+
+/**
+ * @brief Format du fichier de statistiques
+ */
+enum class BoxStatsFormat { CSV, JSONL };
+
+/**
+ * @brief Écrit les statistiques des zones dans un fichier CSV ou JSONL
+ *
+ * Chaque ligne est identifiée par l'identifiant de la copie (meta.id), la page et l'identifiant
+ * de la zone (Layout::ids). L'écriture est protégée par un mutex : un même objet peut être
+ * utilisé depuis plusieurs threads, les lignes d'une copie restant contiguës.
+ */
+class BoxStatsWriter {
+  public:
+    /**
+     * @brief Ouvre le fichier de sortie, au format JSONL si son extension est .jsonl, CSV sinon
+     *
+     * @param filename Chemin du fichier
+     * @throw std::runtime_error Si l'ouverture du fichier échoue
+     */
+    explicit BoxStatsWriter(const std::string& filename);
+
+    /**
+     * @brief Écrit les statistiques de toutes les zones d'une copie
+     *
+     * @param id Identifiant de la copie
+     * @param page Numéro de page
+     * @param stats Statistiques associées à l'identifiant de chaque zone
+     */
+    void write(int id, int page, const std::vector<std::pair<std::string, BoxStats>>& stats);
+
+  private:
+    std::mutex mutex_;
+    std::ofstream out_;
+    BoxStatsFormat format_;
+};
+
+#endif // BOX_STATS_H
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <unordered_map>
+
+#include <common.h>
+#include "math_utils.h"
+#include "corner_solver.h"
+
+// écart relatif maximal de l'échelle de la similitude par rapport à la mise en page attendue
+#define SCALE_TOLERANCE 0.25f
+// distance maximale entre un coin prédit et un candidat, relative à la diagonale attendue de la page
+#define MATCH_TOLERANCE 0.02f
+
+namespace {
+using Complex = std::complex<float>;
+
+Complex to_complex(const cv::Point2f& point) {
+    return Complex(point.x, point.y);
+}
+
+cv::Point2f to_point(const Complex& value) {
+    return cv::Point2f(value.real(), value.imag());
+}
+
+/**
+ * @brief Table de hachage spatiale : cellules carrées de la taille du rayon de recherche
+ */
+class PointHash {
+  public:
+    PointHash(const std::vector<cv::Point2f>& points, float cell_size) : points_(points), cell_size_(cell_size) {
+        cells_.reserve(points.size());
+        for (int i = 0; i < (int) points.size(); ++i) {
+            cells_[key(cell(points[i].x), cell(points[i].y))].push_back(i);
+        }
+    }
+
+    /**
+     * @brief Indice du candidat le plus proche de target à moins de cell_size, ou -1
+     */
+    int nearest(const cv::Point2f& target, float& distance) const {
+        int best = -1;
+        distance = cell_size_;
+        const int cx = cell(target.x), cy = cell(target.y);
+        for (int y = cy - 1; y <= cy + 1; ++y) {
+            for (int x = cx - 1; x <= cx + 1; ++x) {
+                auto it = cells_.find(key(x, y));
+                if (it == cells_.end())
+                    continue;
+                for (int i : it->second) {
+                    float d = (float) cv::norm(points_[i] - target);
+                    if (d < distance) {
+                        distance = d;
+                        best = i;
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+  private:
+    int cell(float v) const {
+        return (int) std::floor(v / cell_size_);
+    }
+    static int64_t key(int x, int y) {
+        return ((int64_t) x << 32) ^ (uint32_t) y;
+    }
+
+    const std::vector<cv::Point2f>& points_;
+    float cell_size_;
+    std::unordered_map<int64_t, std::vector<int>> cells_;
+};
+} // namespace
+
+CornerSolution solve_corners(const std::vector<cv::Point2f>& points, const cv::Point2f& bottom_right,
+                             const std::vector<cv::Point2f>& expected_corner_points) {
+    const int others[3] = { TOP_LEFT, TOP_RIGHT, BOTTOM_LEFT };
+    const cv::Point2f absent(0, 0);
+
+    int expected_mask = 0;
+    float diagonal = 0;
+    for (int corner : others) {
+        if (expected_corner_points.size() > BOTTOM_RIGHT && expected_corner_points[corner] != absent &&
+            expected_corner_points[BOTTOM_RIGHT] != absent) {
+            expected_mask |= (1 << corner);
+            const cv::Point2f offset = expected_corner_points[corner] - expected_corner_points[BOTTOM_RIGHT];
+            diagonal = std::max(diagonal, (float) cv::norm(offset));
+        }
+    }
+
+    // sans mise en page exploitable, ou si aucune hypothèse n'y retrouve assez de coins pour la transformation
+    // affine (le coin inférieur droit et deux autres) : choix sans géométrie attendue
+    auto fallback = [&]() {
+        std::vector<cv::Point2f> candidates = points;
+        CornerSolution solution{ {}, 0, 0.f };
+        solution.found_mask = found_other_point(candidates, solution.corner_points, bottom_right);
+        return solution;
+    };
+
+    if (sum_mask(expected_mask) < 2 || diagonal <= 0)
+        return fallback();
+
+    const float radius = MATCH_TOLERANCE * diagonal;
+    const PointHash hash(points, radius);
+    const Complex br = to_complex(bottom_right);
+    const Complex expected_br = to_complex(expected_corner_points[BOTTOM_RIGHT]);
+
+    CornerSolution best{ std::vector<cv::Point2f>(4, absent), 0, 0.f };
+    int best_count = 0;
+    float best_residual = 0;
+
+    for (int hypothesis : others) {
+        if (!((1 << hypothesis) & expected_mask))
+            continue;
+        const Complex expected_offset = to_complex(expected_corner_points[hypothesis]) - expected_br;
+
+        for (const auto& point : points) {
+            // similitude qui envoie le coin attendu sur le candidat, le coin inférieur droit étant fixe
+            const Complex similarity = (to_complex(point) - br) / expected_offset;
+            if (std::abs(std::abs(similarity) - 1.f) > SCALE_TOLERANCE)
+                continue;
+
+            std::vector<cv::Point2f> corner_points(4, absent);
+            corner_points[BOTTOM_RIGHT] = bottom_right;
+            corner_points[hypothesis] = point;
+            int mask = (1 << BOTTOM_RIGHT) | (1 << hypothesis);
+            int count = 1;
+            float residual = 0;
+
+            for (int corner : others) {
+                if (corner == hypothesis || !((1 << corner) & expected_mask))
+                    continue;
+                const cv::Point2f predicted = to_point(
+                    br + similarity * (to_complex(expected_corner_points[corner]) - expected_br));
+                float distance;
+                int index = hash.nearest(predicted, distance);
+                if (index < 0)
+                    continue;
+                corner_points[corner] = points[index];
+                mask |= (1 << corner);
+                count += 1;
+                residual += distance;
+            }
+
+            if (count > best_count || (count == best_count && residual < best_residual)) {
+                best = { corner_points, mask, 0.f };
+                best_count = count;
+                best_residual = residual;
+            }
+        }
+    }
+
+    if (sum_mask(best.found_mask) < 3)
+        return fallback();
+
+    // proportion de coins retrouvés, pondérée par l'écart moyen aux positions prédites
+    const int nb_expected = sum_mask(expected_mask);
+    const float mean_residual = best_count > 1 ? best_residual / (best_count - 1) : 0.f;
+    best.confidence = (float) best_count / nb_expected * (1.f - mean_residual / radius);
+    return best;
+}
+
+bool all_corners_solved(const CornerSolution& solution) {
+    const int all_corners = TOP_LEFT_BF | TOP_RIGHT_BF | BOTTOM_LEFT_BF | BOTTOM_RIGHT_BF;
+    return solution.found_mask == all_corners && solution.confidence > 0;
+}
@@ -0,0 +1,55 @@
+#ifndef CORNER_SOLVER_H
+#define CORNER_SOLVER_H
+
+/**
+ * @file corner_solver.h
+ * @brief Recherche des coins d'une copie par hachage géométrique.
+ *
+ * Le coin inférieur droit est connu (code-barres). Chaque candidat est successivement supposé être
+ * l'un des trois autres coins : avec le coin inférieur droit, il fixe une similitude (rotation et
+ * échelle) entre la mise en page attendue et l'image, qui prédit la position des deux coins restants.
+ * Ces positions sont cherchées dans une table de hachage spatiale des candidats, en temps constant.
+ * Le coût total est linéaire en nombre de candidats (plus la construction de la table), au lieu de
+ * l'énumération quadratique des paires de found_other_point.
+ */
+
+#include <vector>
+
+#include <common.h>
+
+/**
+ * @brief Coins trouvés par solve_corners
+ */
+struct CornerSolution {
+    std::vector<cv::Point2f> corner_points; ///< Positions des coins, indexées par Corner
+    int found_mask;                         ///< Coins trouvés (combinaison de CornerBF)
+    float confidence;                       ///< Confiance entre 0 (aucun coin retrouvé) et 1 (coins exacts)
+};
+
+/**
+ * @brief Retrouve les coins TL, TR et BL à partir du coin inférieur droit et de la mise en page attendue
+ *
+ * L'échelle de la similitude doit rester proche de 1 (les positions attendues sont exprimées dans un
+ * repère de même taille que l'image). La meilleure hypothèse est celle qui retrouve le plus de coins,
+ * puis celle dont les coins sont les plus proches des positions prédites. Si la mise en page attendue
+ * ne contient pas au moins deux coins en plus du coin inférieur droit, ou si la meilleure hypothèse ne
+ * retrouve pas deux coins en plus du coin inférieur droit (il en faut trois pour la transformation
+ * affine), found_other_point est utilisé et la confiance vaut 0.
+ *
+ * @param points Centres des marqueurs candidats
+ * @param bottom_right Position du coin inférieur droit dans l'image
+ * @param expected_corner_points Positions attendues des coins (indexées par Corner, (0, 0) si absent)
+ * @return CornerSolution Coins trouvés, masque et confiance
+ */
+CornerSolution solve_corners(const std::vector<cv::Point2f>& points, const cv::Point2f& bottom_right,
+                             const std::vector<cv::Point2f>& expected_corner_points);
+
+/**
+ * @brief Indique si une solution retrouve les coins TL, TR et BL à partir de la mise en page attendue
+ *
+ * Une solution obtenue par found_other_point (confiance nulle) n'est jamais validée : elle ne vérifie
+ * pas la géométrie de la page.
+ */
+bool all_corners_solved(const CornerSolution& solution);
+
+#endif // CORNER_SOLVER_H
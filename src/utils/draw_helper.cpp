@@ -6,7 +6,7 @@
 #include "parser_helper.h"
 #include "draw_helper.h"
 
-void draw_qrcode(std::vector<DetectedBarcode>& barcodes, cv::Mat& debug_img) {
+void draw_qrcode(const std::vector<DetectedBarcode>& barcodes, cv::Mat& debug_img) {
     for (const auto& barcode : barcodes) {
         std::vector<cv::Point> box;
 
@@ -20,7 +20,7 @@
  * @param barcodes Liste des codes-barres détectés avec leurs coordonnées
  * @param debug_img Image sur laquelle dessiner les contours (modifiée par la fonction)
  */
-void draw_qrcode(std::vector<DetectedBarcode>& barcodes, cv::Mat& debug_img);
+void draw_qrcode(const std::vector<DetectedBarcode>& barcodes, cv::Mat& debug_img);
 
 /**
  * @brief Sauvegarde l'image de débogage dans le répertoire spécifié
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "finder_pattern.h"
+
+// tolérance sur chaque plage : un demi-module (trois demi-modules pour la plage centrale)
+#define MODULE_TOLERANCE 0.5f
+// écart maximal entre la largeur du motif sur la ligne et sur la colonne
+#define CROSS_CHECK_TOLERANCE 0.4f
+// nombre minimal de lignes confirmant un même motif
+#define MIN_CONFIRMATIONS 2
+
+namespace {
+/**
+ * @brief Vérifie que cinq plages consécutives respectent le rapport 1:1:3:1:1
+ */
+bool is_finder_ratio(const int runs[5]) {
+    const int total = runs[0] + runs[1] + runs[2] + runs[3] + runs[4];
+    if (total < 7)
+        return false;
+
+    const float module = total / 7.0f;
+    const float tolerance = module * MODULE_TOLERANCE;
+    return std::abs(runs[0] - module) < tolerance && std::abs(runs[1] - module) < tolerance &&
+           std::abs(runs[2] - 3 * module) < 3 * tolerance && std::abs(runs[3] - module) < tolerance &&
+           std::abs(runs[4] - module) < tolerance;
+}
+
+/**
+ * @brief Positions des changements de couleur d'une ligne binarisée (valeurs 0 ou 255)
+ *
+ * Une position x est retenue si row[x] != row[x - 1]. Les blocs sans transition sont écartés
+ * en une seule comparaison vectorielle.
+ */
+void row_transitions(const uchar* row, int width, std::vector<int>& transitions) {
+    transitions.clear();
+    int x = 1;
+#if CV_SIMD
+    // les valeurs étant 0 ou 255, |a - b| vaut 255 exactement sur les transitions
+    const int lanes = CV_SIMD_WIDTH;
+    for (; x + lanes <= width; x += lanes) {
+        if (!cv::v_check_any(cv::v_absdiff(cv::vx_load(row + x - 1), cv::vx_load(row + x))))
+            continue;
+        for (int i = x; i < x + lanes; ++i) {
+            if (row[i] != row[i - 1])
+                transitions.push_back(i);
+        }
+    }
+    cv::vx_cleanup();
+#endif
+    for (; x < width; ++x) {
+        if (row[x] != row[x - 1])
+            transitions.push_back(x);
+    }
+}
+
+/**
+ * @brief Vérifie le motif le long d'une direction et recentre le candidat
+ *
+ * Parcourt l'image binarisée depuis center dans les deux sens de dir (horizontale ou verticale)
+ * pour mesurer les cinq plages du motif.
+ *
+ * @param binary Image binarisée (noir = 255)
+ * @param center Pixel au centre supposé du motif
+ * @param dir Direction de parcours, (1, 0) ou (0, 1)
+ * @param expected_total Largeur du motif mesurée sur la ligne d'origine
+ * @return std::optional<float> Coordonnée recentrée le long de dir, ou nullopt si le motif n'est pas confirmé
+ */
+std::optional<float> cross_check(const cv::Mat& binary, const cv::Point& center, const cv::Point& dir,
+                                 int expected_total) {
+    auto color_at = [&](int k) -> int {
+        const cv::Point p = center + dir * k;
+        if (p.x < 0 || p.y < 0 || p.x >= binary.cols || p.y >= binary.rows)
+            return -1;
+        return binary.at<uchar>(p) != 0 ? 1 : 0;
+    };
+
+    int runs[5] = { 0, 0, 0, 0, 0 };
+    int k = 0;
+    while (color_at(-k) == 1 && runs[2] <= expected_total) {
+        runs[2] += 1;
+        k += 1;
+    }
+    const int center_back = runs[2];
+    if (center_back == 0)
+        return {};
+    while (color_at(-k) == 0 && runs[1] <= expected_total) {
+        runs[1] += 1;
+        k += 1;
+    }
+    while (color_at(-k) == 1 && runs[0] <= expected_total) {
+        runs[0] += 1;
+        k += 1;
+    }
+
+    k = 1;
+    while (color_at(k) == 1 && runs[2] <= expected_total) {
+        runs[2] += 1;
+        k += 1;
+    }
+    const int center_forward = runs[2] - center_back;
+    while (color_at(k) == 0 && runs[3] <= expected_total) {
+        runs[3] += 1;
+        k += 1;
+    }
+    while (color_at(k) == 1 && runs[4] <= expected_total) {
+        runs[4] += 1;
+        k += 1;
+    }
+
+    const int total = runs[0] + runs[1] + runs[2] + runs[3] + runs[4];
+    if (std::abs(total - expected_total) > CROSS_CHECK_TOLERANCE * expected_total || !is_finder_ratio(runs))
+        return {};
+
+    // la plage centrale va du pixel c - center_back + 1 au pixel c + center_forward
+    const int origin = dir.x != 0 ? center.x : center.y;
+    return origin + (center_forward - center_back + 1) / 2.0f;
+}
+} // namespace
+
+std::vector<FinderPattern> find_finder_patterns(const cv::Mat& img) {
+    cv::Mat binary;
+    return find_finder_patterns(img, binary);
+}
+
+std::vector<FinderPattern> find_finder_patterns(const cv::Mat& img, cv::Mat& binary) {
+    if (img.type() != CV_8U)
+        throw std::invalid_argument("img has type != CV_8U while it should contain luminance information");
+
+    std::vector<FinderPattern> patterns;
+    if (img.cols < 7 || img.rows < 7)
+        return patterns;
+
+    cv::threshold(img, binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+
+    std::vector<int> transitions;
+    std::vector<int> bounds;
+    for (int y = 0; y < binary.rows; ++y) {
+        const uchar* row = binary.ptr<uchar>(y);
+        row_transitions(row, binary.cols, transitions);
+        if (transitions.size() < 4)
+            continue;
+
+        // bornes des plages : [bounds[i], bounds[i + 1][ ; les plages alternent de couleur
+        bounds.clear();
+        bounds.push_back(0);
+        bounds.insert(bounds.end(), transitions.begin(), transitions.end());
+        bounds.push_back(binary.cols);
+        const int nb_runs = (int) bounds.size() - 1;
+
+        for (int first = row[0] != 0 ? 0 : 1; first + 4 < nb_runs; first += 2) {
+            int runs[5];
+            for (int i = 0; i < 5; ++i) {
+                runs[i] = bounds[first + i + 1] - bounds[first + i];
+            }
+            if (!is_finder_ratio(runs))
+                continue;
+
+            const int total = bounds[first + 5] - bounds[first];
+            const int center_x = (bounds[first + 2] + bounds[first + 3]) / 2;
+            auto center_y = cross_check(binary, { center_x, y }, { 0, 1 }, total);
+            if (!center_y.has_value())
+                continue;
+            auto refined_x = cross_check(binary, { center_x, cvRound(center_y.value()) }, { 1, 0 }, total);
+            if (!refined_x.has_value())
+                continue;
+
+            const cv::Point2f center(refined_x.value(), center_y.value());
+            const float module_size = total / 7.0f;
+
+            // les lignes qui traversent le même motif donnent le même centre, à un module près
+            bool merged = false;
+            for (auto& pattern : patterns) {
+                const float tolerance = 2 * std::max(module_size, pattern.module_size);
+                if (cv::norm(pattern.center - center) < tolerance) {
+                    const float weight = 1.0f / (pattern.count + 1);
+                    pattern.center += (center - pattern.center) * weight;
+                    pattern.module_size += (module_size - pattern.module_size) * weight;
+                    pattern.count += 1;
+                    merged = true;
+                    break;
+                }
+            }
+            if (!merged)
+                patterns.push_back({ center, module_size, 1 });
+        }
+    }
+
+    std::vector<FinderPattern> confirmed;
+    for (const auto& pattern : patterns) {
+        if (pattern.count >= MIN_CONFIRMATIONS)
+            confirmed.push_back(pattern);
+    }
+    return confirmed;
+}
+
+std::vector<cv::Point2f> detect_finder_patterns(ScratchBuffers& scratch, const cv::Mat& img,
+                                                const cv::Point2i& offset) {
+    std::vector<cv::Point2f> centers;
+    for (const auto& pattern : find_finder_patterns(img, scratch.binary)) {
+        centers.emplace_back(pattern.center.x + offset.x, pattern.center.y + offset.y);
+    }
+    return centers;
+}
+
+// un code QR mesure de 21 (version 1) à 177 modules (version 40) : 14 à 170 modules entre deux motifs
+#define MIN_PATTERN_DISTANCE 10.0f
+#define MAX_PATTERN_DISTANCE 180.0f
+#define MAX_MODULE_RATIO 1.5f
+#define MAX_TRIANGLE_SCORE 0.3f
+
+std::optional<cv::Point2f> locate_qr_code(const std::vector<FinderPattern>& patterns) {
+    std::optional<cv::Point2f> best_center;
+    float best_score = MAX_TRIANGLE_SCORE;
+
+    const int nb_patterns = (int) patterns.size();
+    for (int corner = 0; corner < nb_patterns; ++corner) {
+        const auto& a = patterns[corner];
+        for (int i = 0; i < nb_patterns; ++i) {
+            for (int j = i + 1; j < nb_patterns; ++j) {
+                if (i == corner || j == corner)
+                    continue;
+                const auto& b = patterns[i];
+                const auto& c = patterns[j];
+
+                const float min_module = std::min({ a.module_size, b.module_size, c.module_size });
+                const float max_module = std::max({ a.module_size, b.module_size, c.module_size });
+                if (max_module > MAX_MODULE_RATIO * min_module)
+                    continue;
+
+                // a est le motif de l'angle droit : |ab| = |ac| et ab ⟂ ac
+                const cv::Point2f ab = b.center - a.center;
+                const cv::Point2f ac = c.center - a.center;
+                const float length_ab = std::hypot(ab.x, ab.y);
+                const float length_ac = std::hypot(ac.x, ac.y);
+                const float module = (a.module_size + b.module_size + c.module_size) / 3;
+                if (std::min(length_ab, length_ac) < MIN_PATTERN_DISTANCE * module ||
+                    std::max(length_ab, length_ac) > MAX_PATTERN_DISTANCE * module)
+                    continue;
+
+                const float length_score = std::abs(length_ab - length_ac) / std::max(length_ab, length_ac);
+                const float angle_score = std::abs(ab.dot(ac)) / (length_ab * length_ac);
+                const float score = length_score + angle_score;
+                if (score < best_score) {
+                    best_score = score;
+                    best_center = (b.center + c.center) * 0.5f;
+                }
+            }
+        }
+    }
+    return best_center;
+}
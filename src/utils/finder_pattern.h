@@ -0,0 +1,79 @@
+#ifndef FINDER_PATTERN_H
+#define FINDER_PATTERN_H
+
+/**
+ * @file finder_pattern.h
+ * @brief Détection des motifs de repérage (« yeux ») des codes QR par balayage de lignes.
+ *
+ * Un motif de repérage est un carré noir de 3×3 modules entouré d'un anneau blanc puis d'un anneau
+ * noir d'un module : toute ligne qui le traverse en son centre alterne noir, blanc, noir, blanc, noir
+ * avec des longueurs dans le rapport 1:1:3:1:1. L'image est binarisée, puis chaque ligne est découpée
+ * en plages de même couleur ; la recherche des transitions utilise les intrinsèques universelles
+ * d'OpenCV, ce qui permet de sauter en une comparaison les blocs de pixels uniformes (la majorité
+ * d'une page). Chaque candidat est ensuite vérifié verticalement puis recentré horizontalement.
+ *
+ * Aucun décodage n'est effectué : ces fonctions servent à localiser des marqueurs QR_EYE et des codes
+ * QR dont seule la position est utile.
+ */
+
+#include <optional>
+#include <vector>
+
+#include <common.h>
+
+#include "parser_context.h"
+
+/**
+ * @brief Motif de repérage détecté
+ */
+struct FinderPattern {
+    cv::Point2f center; ///< Centre du motif, en pixels
+    float module_size;  ///< Taille estimée d'un module, en pixels
+    int count;          ///< Nombre de lignes sur lesquelles le motif a été confirmé
+};
+
+/**
+ * @brief Cherche les motifs de repérage d'une image
+ *
+ * @param img Image en niveaux de gris (CV_8U)
+ * @return std::vector<FinderPattern> Motifs confirmés sur au moins deux lignes, dans le repère de img
+ * @throw std::invalid_argument Si l'image n'est pas au format CV_8U
+ */
+std::vector<FinderPattern> find_finder_patterns(const cv::Mat& img);
+
+/**
+ * @brief Variante de find_finder_patterns qui binarise l'image dans un tampon réutilisé
+ *
+ * @param img Image en niveaux de gris (CV_8U)
+ * @param binary Tampon de l'image binarisée, réalloué seulement si sa taille change
+ * @return std::vector<FinderPattern> Motifs confirmés sur au moins deux lignes, dans le repère de img
+ * @throw std::invalid_argument Si l'image n'est pas au format CV_8U
+ */
+std::vector<FinderPattern> find_finder_patterns(const cv::Mat& img, cv::Mat& binary);
+
+/**
+ * @brief Centres des motifs de repérage d'une image (ou d'un quadrant), dans le repère de l'image complète
+ *
+ * La signature correspond à celle attendue par smaller_parse(ctx, ...).
+ *
+ * @param scratch Tampons du quadrant (image binarisée)
+ * @param img Image (ou quadrant) en niveaux de gris à analyser
+ * @param offset Décalage de img dans l'image complète
+ * @return std::vector<cv::Point2f> Centres des motifs trouvés
+ */
+std::vector<cv::Point2f> detect_finder_patterns(ScratchBuffers& scratch, const cv::Mat& img,
+                                                const cv::Point2i& offset);
+
+/**
+ * @brief Localise un code QR à partir de ses trois motifs de repérage, sans le décoder
+ *
+ * Cherche le triplet de motifs de tailles de module proches qui forme le mieux un triangle rectangle
+ * isocèle. Le centre du code QR est le milieu de l'hypoténuse, entre les motifs haut droit et
+ * bas gauche du code.
+ *
+ * @param patterns Motifs de repérage candidats
+ * @return std::optional<cv::Point2f> Centre du code QR, ou nullopt si aucun triplet ne convient
+ */
+std::optional<cv::Point2f> locate_qr_code(const std::vector<FinderPattern>& patterns);
+
+#endif // FINDER_PATTERN_H
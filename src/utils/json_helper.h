@@ -8,14 +8,6 @@
 
 #include <common.h>
 #include <vector>
-#include <memory>
-
-/**
- * @brief Convertit le contenu JSON en une liste d'objets AtomicBox
- * @param content Contenu JSON à convertir
- * @return Vecteur d'objets AtomicBox partagés
- */
-std::vector<std::shared_ptr<AtomicBox>> json_to_atomicBox(const json& content);
 
 /**
  * @brief Analyse une chaîne de caractères pour en extraire les métadonnées
@@ -0,0 +1,77 @@
+#include <cmath>
+#include <stdexcept>
+
+#include "layout.h"
+#include "string_helper.h"
+
+/**
+ * @brief Coin (Corner) désigné par l'identifiant d'un marqueur, ou -1
+ */
+static int corner_of_marker(const std::string& id) {
+    if (starts_with(id, "hztl"))
+        return TOP_LEFT;
+    if (starts_with(id, "hztr"))
+        return TOP_RIGHT;
+    if (starts_with(id, "hzbl"))
+        return BOTTOM_LEFT;
+    if (starts_with(id, "hzbr"))
+        return BOTTOM_RIGHT;
+    if (starts_with(id, "hztc"))
+        return TOP_CENTER;
+    return -1;
+}
+
+Layout compile_layout(const json& content) {
+    Layout layout;
+
+    int max_page = 1;
+    for (const auto& [key, value] : content.items()) {
+        max_page = std::max(max_page, value["page"].get<int>());
+    }
+    layout.pages.resize(max_page);
+
+    for (const auto& [key, value] : content.items()) {
+        const LayoutRect rect = { value["x"], value["y"], value["width"], value["height"],
+                                  value.value("stroke-width", 0.0f) };
+
+        if (starts_with(key, "hz")) {
+            const int corner = corner_of_marker(key);
+            if (corner != -1)
+                layout.corners[corner] = rect;
+            continue;
+        }
+
+        const int page = value["page"];
+        if (page < 1)
+            throw std::invalid_argument("box '" + key + "' has an invalid page number");
+
+        PageBoxes& boxes = layout.pages[page - 1];
+        boxes.x.push_back(rect.x);
+        boxes.y.push_back(rect.y);
+        boxes.width.push_back(rect.width);
+        boxes.height.push_back(rect.height);
+        boxes.stroke_width.push_back(rect.stroke_width);
+        boxes.id.push_back((int) layout.ids.size());
+        layout.ids.push_back(key);
+    }
+    return layout;
+}
+
+void raster_rects(const PageBoxes& boxes, const cv::Point2f& src_size, const cv::Point2f& dst_size,
+                  std::vector<cv::Rect>& rects) {
+    const size_t nb_boxes = boxes.size();
+    rects.resize(nb_boxes);
+
+    const float* x = boxes.x.data();
+    const float* y = boxes.y.data();
+    const float* width = boxes.width.data();
+    const float* height = boxes.height.data();
+    for (size_t i = 0; i < nb_boxes; ++i) {
+        // même calcul que coord_scale suivi de l'arrondi de convert_to_raster
+        const int min_x = (int) std::round((x[i] / src_size.x) * dst_size.x);
+        const int min_y = (int) std::round((y[i] / src_size.y) * dst_size.y);
+        const int max_x = (int) std::round(((x[i] + width[i]) / src_size.x) * dst_size.x);
+        const int max_y = (int) std::round(((y[i] + height[i]) / src_size.y) * dst_size.y);
+        rects[i] = cv::Rect(min_x, min_y, max_x - min_x, max_y - min_y);
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+/**
+ * @file layout.h
+ * @brief Description compilée des zones d'une copie, rangée en structure de tableaux.
+ *
+ * La description JSON des zones (AtomicBox) est convertie une seule fois en Layout : les coordonnées
+ * des zones de chaque page sont stockées dans des tableaux contigus de floats (x, y, largeur, hauteur,
+ * bordure), les identifiants sont internés dans un tableau unique et les marqueurs de coin occupent un
+ * tableau de taille fixe indexé par Corner. Les boucles sur les zones parcourent des données contiguës,
+ * sans indirection ni allocation par zone.
+ *
+ * Un Layout n'est plus modifié après sa construction : il peut être partagé en lecture seule entre
+ * plusieurs threads.
+ */
+
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <common.h>
+
+/**
+ * @brief Rectangle d'une zone, en mm dans le repère de la page
+ */
+struct LayoutRect {
+    float x;
+    float y;
+    float width;
+    float height;
+    float stroke_width; ///< Épaisseur de la bordure (0 si absente)
+
+    /**
+     * @brief Centre du rectangle, en mm
+     */
+    cv::Point2f center() const {
+        return { x + width / 2, y + height / 2 };
+    }
+};
+
+/**
+ * @brief Zones utilisateur d'une page, une entrée par zone dans chaque tableau
+ */
+struct PageBoxes {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> width;
+    std::vector<float> height;
+    std::vector<float> stroke_width;
+    std::vector<int> id; ///< Indice de l'identifiant de la zone dans Layout::ids
+
+    size_t size() const {
+        return x.size();
+    }
+
+    LayoutRect rect(size_t i) const {
+        return { x[i], y[i], width[i], height[i], stroke_width[i] };
+    }
+};
+
+/**
+ * @brief Nombre de marqueurs de coin (TOP_LEFT, TOP_RIGHT, BOTTOM_LEFT, BOTTOM_RIGHT, TOP_CENTER)
+ */
+constexpr int NB_CORNER_MARKERS = 5;
+
+/**
+ * @brief Zones d'une copie : marqueurs de coin et zones utilisateur de chaque page
+ */
+struct Layout {
+    std::vector<std::string> ids;                                     ///< Identifiants internés des zones
+    std::vector<PageBoxes> pages;                                     ///< Zones utilisateur, page 1 à l'indice 0
+    std::array<std::optional<LayoutRect>, NB_CORNER_MARKERS> corners; ///< Marqueurs de coin, indexés par Corner
+
+    /**
+     * @brief Identifiant de la i-ème zone d'une page
+     */
+    const std::string& id(const PageBoxes& boxes, size_t i) const {
+        return ids[boxes.id[i]];
+    }
+};
+
+/**
+ * @brief Construit un Layout à partir de la description JSON des zones
+ *
+ * Les zones dont l'identifiant commence par "hztl", "hztr", "hzbl", "hzbr" ou "hztc" sont les
+ * marqueurs de coin ; les autres identifiants commençant par "hz" sont ignorés. Toutes les autres
+ * zones sont rangées par page, dans l'ordre du JSON. Il y a au moins une page.
+ *
+ * @param content Contenu JSON (objet associant à chaque identifiant page, x, y, width, height
+ *        et éventuellement stroke-width)
+ * @return Layout Zones compilées
+ * @throw std::invalid_argument Si une zone a un numéro de page inférieur à 1
+ */
+Layout compile_layout(const json& content);
+
+/**
+ * @brief Convertit toutes les zones d'une page en rectangles en pixels
+ *
+ * Les deux coins opposés de chaque zone sont mis à l'échelle puis arrondis comme avec
+ * convert_to_raster, en une seule boucle sur les tableaux de la page.
+ *
+ * @param boxes Zones de la page
+ * @param src_size Dimensions de la page (mm)
+ * @param dst_size Dimensions de l'image (pixels)
+ * @param rects Rectangles en pixels, un par zone dans l'ordre de boxes (redimensionné)
+ */
+void raster_rects(const PageBoxes& boxes, const cv::Point2f& src_size, const cv::Point2f& dst_size,
+                  std::vector<cv::Rect>& rects);
+
+#endif // LAYOUT_H
@@ -0,0 +1,245 @@
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+#include "layout_cache.h"
+
+// en-tête des fichiers ".layout" : "HZLY", le numéro de version du format, puis l'empreinte et la taille du JSON
+#define SIDECAR_MAGIC 0x594c5a48u
+#define SIDECAR_VERSION 2u
+
+namespace {
+template <typename T> void write_value(std::ostream& out, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T> bool read_value(std::istream& in, T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return (bool) in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+template <typename T> void write_array(std::ostream& out, const std::vector<T>& values) {
+    out.write(reinterpret_cast<const char*>(values.data()), (std::streamsize) (values.size() * sizeof(T)));
+}
+
+/**
+ * @brief Indique si le fichier contient encore au moins bytes octets après la position courante
+ *
+ * Les tailles lues dans un fichier corrompu sont vérifiées avant toute allocation.
+ */
+bool remains(std::istream& in, uint64_t file_size, uint64_t bytes) {
+    const std::streamoff position = in.tellg();
+    return position >= 0 && bytes <= file_size - (uint64_t) position;
+}
+
+template <typename T> bool read_array(std::istream& in, uint64_t file_size, std::vector<T>& values, uint32_t size) {
+    if (!remains(in, file_size, (uint64_t) size * sizeof(T)))
+        return false;
+    values.resize(size);
+    return (bool) in.read(reinterpret_cast<char*>(values.data()), (std::streamsize) (size * sizeof(T)));
+}
+
+std::string sidecar_path(const std::string& json_path) {
+    return std::filesystem::path(json_path).replace_extension(".layout").string();
+}
+
+/**
+ * @brief Écrit un Layout dans un fichier ".layout", via un fichier temporaire renommé
+ *
+ * Un échec d'écriture n'est pas une erreur : le Layout sera simplement recompilé la prochaine fois.
+ */
+void write_sidecar(const std::string& path, uint64_t hash, uint64_t content_size, const Layout& layout) {
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            return;
+
+        write_value(out, SIDECAR_MAGIC);
+        write_value(out, SIDECAR_VERSION);
+        write_value(out, hash);
+        write_value(out, content_size);
+
+        write_value(out, (uint32_t) layout.ids.size());
+        for (const auto& id : layout.ids) {
+            write_value(out, (uint32_t) id.size());
+            out.write(id.data(), (std::streamsize) id.size());
+        }
+
+        write_value(out, (uint32_t) layout.pages.size());
+        for (const auto& boxes : layout.pages) {
+            write_value(out, (uint32_t) boxes.size());
+            write_array(out, boxes.x);
+            write_array(out, boxes.y);
+            write_array(out, boxes.width);
+            write_array(out, boxes.height);
+            write_array(out, boxes.stroke_width);
+            write_array(out, boxes.id);
+        }
+
+        for (const auto& corner : layout.corners) {
+            write_value(out, (uint8_t) corner.has_value());
+            if (corner.has_value())
+                write_value(out, *corner);
+        }
+        if (!out)
+            return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmp_path, path, error);
+    if (error)
+        std::filesystem::remove(tmp_path, error);
+}
+
+/**
+ * @brief Relit un fichier ".layout", s'il existe et correspond à l'empreinte et à la taille du JSON
+ *
+ * Un fichier tronqué, corrompu ou suivi d'octets en trop est ignoré (nullptr).
+ */
+std::shared_ptr<const Layout> read_sidecar(const std::string& path, uint64_t expected_hash,
+                                           uint64_t expected_content_size) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open())
+        return nullptr;
+    const std::streamoff end = in.tellg();
+    if (end < 0)
+        return nullptr;
+    const uint64_t file_size = (uint64_t) end;
+    in.seekg(0);
+
+    uint32_t magic, version;
+    uint64_t hash, content_size;
+    if (!read_value(in, magic) || !read_value(in, version) || magic != SIDECAR_MAGIC || version != SIDECAR_VERSION ||
+        !read_value(in, hash) || !read_value(in, content_size) || hash != expected_hash ||
+        content_size != expected_content_size)
+        return nullptr;
+
+    auto layout = std::make_shared<Layout>();
+
+    // chaque identifiant occupe au moins sa longueur (4 octets), chaque page au moins son nombre de zones
+    uint32_t nb_ids;
+    if (!read_value(in, nb_ids) || !remains(in, file_size, (uint64_t) nb_ids * sizeof(uint32_t)))
+        return nullptr;
+    layout->ids.resize(nb_ids);
+    for (auto& id : layout->ids) {
+        uint32_t length;
+        if (!read_value(in, length) || !remains(in, file_size, length))
+            return nullptr;
+        id.resize(length);
+        if (!in.read(id.data(), length))
+            return nullptr;
+    }
+
+    uint32_t nb_pages;
+    if (!read_value(in, nb_pages) || !remains(in, file_size, (uint64_t) nb_pages * sizeof(uint32_t)))
+        return nullptr;
+    layout->pages.resize(nb_pages);
+    for (auto& boxes : layout->pages) {
+        uint32_t nb_boxes;
+        if (!read_value(in, nb_boxes) || !read_array(in, file_size, boxes.x, nb_boxes) ||
+            !read_array(in, file_size, boxes.y, nb_boxes) || !read_array(in, file_size, boxes.width, nb_boxes) ||
+            !read_array(in, file_size, boxes.height, nb_boxes) ||
+            !read_array(in, file_size, boxes.stroke_width, nb_boxes) || !read_array(in, file_size, boxes.id, nb_boxes))
+            return nullptr;
+        for (int id : boxes.id) {
+            if (id < 0 || (uint32_t) id >= nb_ids)
+                return nullptr;
+        }
+    }
+
+    for (auto& corner : layout->corners) {
+        uint8_t present;
+        if (!read_value(in, present))
+            return nullptr;
+        if (present) {
+            LayoutRect rect;
+            if (!read_value(in, rect))
+                return nullptr;
+            corner = rect;
+        }
+    }
+    if (!remains(in, file_size, 0) || (uint64_t) in.tellg() != file_size)
+        return nullptr;
+    return layout;
+}
+} // namespace
+
+uint64_t content_hash(const std::string& content) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : content) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::shared_ptr<const Layout> LayoutCache::load(const std::string& json_path) {
+    std::ifstream file(json_path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("could not open file '" + json_path + "'");
+    }
+    const std::string content{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    const uint64_t hash = content_hash(content);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = layouts_.find(hash);
+        if (it != layouts_.end() && it->second.content_size == content.size()) {
+            ++hits_;
+            return it->second.layout;
+        }
+    }
+
+    // le verrou n'est pas tenu pendant le chargement : deux threads peuvent compiler le même contenu,
+    // le premier Layout inséré est conservé
+    std::shared_ptr<const Layout> layout;
+    bool from_sidecar = false;
+    if (use_sidecar_) {
+        layout = read_sidecar(sidecar_path(json_path), hash, content.size());
+        from_sidecar = layout != nullptr;
+    }
+
+    if (!layout) {
+        json atomic_boxes_json;
+        try {
+            atomic_boxes_json = json::parse(content);
+        } catch (const json::exception& e) {
+            throw std::runtime_error("could not json parse file '" + json_path + "': " + e.what());
+        }
+        if (atomic_boxes_json.empty()) {
+            throw std::runtime_error("no atomic boxes in file '" + json_path + "'");
+        }
+
+        layout = std::make_shared<const Layout>(compile_layout(atomic_boxes_json));
+        if (use_sidecar_)
+            write_sidecar(sidecar_path(json_path), hash, content.size(), *layout);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = layouts_.emplace(hash, Entry{ content.size(), layout });
+    if (inserted && from_sidecar)
+        ++sidecar_loads_;
+    // collision d'empreinte entre deux contenus de tailles différentes : le Layout n'est pas partagé
+    if (it->second.content_size != content.size())
+        return layout;
+    return it->second.layout;
+}
+
+size_t LayoutCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+size_t LayoutCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return layouts_.size();
+}
+
+size_t LayoutCache::sidecar_loads() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sidecar_loads_;
+}
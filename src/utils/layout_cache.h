@@ -0,0 +1,88 @@
+#ifndef LAYOUT_CACHE_H
+#define LAYOUT_CACHE_H
+
+/**
+ * @file layout_cache.h
+ * @brief Cache des Layout indexé par le contenu des fichiers de description des zones.
+ *
+ * Les copies d'un même examen partagent presque toujours la même description JSON des zones. Plutôt
+ * que de parser puis compiler le JSON de chaque copie, le cache calcule une empreinte (FNV-1a 64 bits)
+ * des octets du fichier et réutilise le Layout déjà compilé pour cette empreinte et cette taille.
+ *
+ * Le cache peut aussi être conservé sur disque : un fichier binaire compact (suffixe ".layout") est
+ * écrit à côté du JSON et relu aux exécutions suivantes à la place du JSON, tant que l'empreinte qu'il
+ * contient, ainsi que la taille du JSON, correspondent au contenu actuel du JSON. Les tailles lues sont
+ * vérifiées par rapport à la longueur du fichier avant toute allocation. Le format dépend de
+ * l'architecture (ordre des octets natif) : un fichier illisible, corrompu ou périmé est simplement
+ * ignoré et réécrit.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "layout.h"
+
+/**
+ * @brief Empreinte FNV-1a 64 bits d'une suite d'octets
+ */
+uint64_t content_hash(const std::string& content);
+
+/**
+ * @brief Layout compilés, partagés entre les copies dont le JSON a le même contenu
+ *
+ * Les méthodes peuvent être appelées depuis plusieurs threads.
+ */
+class LayoutCache {
+  public:
+    /**
+     * @param use_sidecar Lire et écrire le fichier binaire ".layout" à côté de chaque JSON
+     */
+    explicit LayoutCache(bool use_sidecar = false) : use_sidecar_(use_sidecar) {
+    }
+
+    /**
+     * @brief Layout décrit par un fichier JSON, compilé au plus une fois par contenu distinct
+     *
+     * @param json_path Chemin du fichier JSON de description des zones
+     * @return std::shared_ptr<const Layout> Layout partagé, jamais nul
+     * @throw std::runtime_error Si le fichier ne peut pas être lu, n'est pas du JSON valide ou est vide
+     * @throw std::invalid_argument Si une zone a un numéro de page invalide (voir compile_layout)
+     */
+    std::shared_ptr<const Layout> load(const std::string& json_path);
+
+    /**
+     * @brief Nombre d'appels à load ayant réutilisé un Layout déjà en mémoire
+     */
+    size_t hits() const;
+
+    /**
+     * @brief Nombre de Layout distincts chargés (depuis le JSON ou depuis un fichier ".layout")
+     */
+    size_t size() const;
+
+    /**
+     * @brief Nombre de Layout relus depuis un fichier ".layout" au lieu du JSON
+     */
+    size_t sidecar_loads() const;
+
+  private:
+    bool use_sidecar_;
+
+    mutable std::mutex mutex_;
+    /**
+     * @brief Layout compilé et taille du JSON dont il provient
+     */
+    struct Entry {
+        size_t content_size;
+        std::shared_ptr<const Layout> layout;
+    };
+
+    std::unordered_map<uint64_t, Entry> layouts_; ///< Layout indexés par empreinte
+    size_t hits_ = 0;
+    size_t sidecar_loads_ = 0;
+};
+
+#endif // LAYOUT_CACHE_H
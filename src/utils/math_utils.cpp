@@ -27,10 +27,13 @@ std::vector<cv::Point> convert_to_raster(const std::vector<cv::Point2f>& vec_poi
     return raster_points;
 }
 
-cv::Point2f center_of_box(std::vector<cv::Point2f> bounding_box) {
-    cv::Mat mean_mat;
-    cv::reduce(bounding_box, mean_mat, 1, cv::REDUCE_AVG);
-    return cv::Point2f(mean_mat.at<float>(0, 0), mean_mat.at<float>(0, 1));
+cv::Point2f center_of_box(const std::vector<cv::Point2f>& bounding_box) {
+    // moyenne directe : cv::reduce allouerait une matrice à chaque appel
+    cv::Point2f sum(0, 0);
+    for (const auto& point : bounding_box) {
+        sum += point;
+    }
+    return bounding_box.empty() ? sum : sum / (float) bounding_box.size();
 }
 
 float angle(cv::Point2f a, cv::Point2f b, cv::Point2f c) {
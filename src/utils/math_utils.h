@@ -38,7 +38,7 @@ std::vector<cv::Point> convert_to_raster(const std::vector<cv::Point2f>& vec_poi
  * @param bounding_box Vecteur de points définissant le quadrilatère
  * @return Point central du quadrilatère
  */
-cv::Point2f center_of_box(std::vector<cv::Point2f> bounding_box);
+cv::Point2f center_of_box(const std::vector<cv::Point2f>& bounding_box);
 
 /**
  * @brief Calcule l'angle formé par trois points (a, b, c) avec b comme sommet
@@ -51,6 +51,10 @@ float angle(cv::Point2f a, cv::Point2f b, cv::Point2f c);
 
 /**
  * @brief Trouve les autres coins d'un quadrilatère à partir d'un coin connu
+ *
+ * Sans connaissance de la mise en page ; lorsque les positions attendues des coins sont connues,
+ * solve_corners (corner_solver.h) est préférable.
+ *
  * @param points Liste de tous les points candidats
  * @param corner_points Vecteur qui contiendra les coins trouvés (modifié par la fonction)
  * @param corner_barcode Point de coin déjà connu
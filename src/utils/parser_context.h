@@ -0,0 +1,120 @@
+#ifndef PARSER_CONTEXT_H
+#define PARSER_CONTEXT_H
+
+/**
+ * @file parser_context.h
+ * @brief Contexte d'exécution des parseurs : tampons de travail et décodeur réutilisés d'une copie à l'autre.
+ *
+ * Sans contexte, chaque appel de parseur réalloue l'image de Canny, les vecteurs de contours, la liste
+ * des codes-barres et l'état du décodeur de codes-barres, soit plusieurs allocations de la taille d'une page par
+ * copie. Un ParserContext est créé une fois par thread de travail et passé à chaque parseur : une fois
+ * les tampons dimensionnés par les premières copies, les appels suivants les réutilisent.
+ *
+ * Un contexte ne doit être utilisé que par un seul thread à la fois. Les quadrants analysés en parallèle
+ * par smaller_parse disposent chacun de leurs propres tampons (ParserContext::quadrants) ; les parseurs
+ * SHAPE, CENTER_PARSER, CIRCLE, CROSS, QR_EYE, CUSTOM et ZXING (localisation des codes QR de coin) les
+ * utilisent. Seul le parseur ARUCO (détecteur OpenCV sans tampons exposés) n'en a pas l'usage.
+ *
+ * Le contexte porte aussi les réglages des parseurs (ParserContext::settings) : deux contextes peuvent
+ * analyser les mêmes copies avec des réglages différents, et un benchmark compare plusieurs méthodes en
+ * modifiant les réglages de son contexte entre deux passes, sans état global au processus.
+ */
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <common.h>
+
+#include "barcode_backend.h"
+#include "template_matcher.h"
+
+/**
+ * @brief Méthode de détection des marqueurs de forme pleins (parseurs SHAPE et CENTER_PARSER)
+ */
+enum class ShapeDetector {
+    CONTOURS,   ///< Contours de Canny puis findContours (par défaut)
+    COMPONENTS, ///< Seuillage d'Otsu puis composantes connexes
+};
+
+/**
+ * @brief Méthode de détection des marqueurs circulaires (parseur CIRCLE)
+ */
+enum class CircleDetector {
+    HOUGH, ///< cv::HoughCircles (par défaut)
+    BLOBS, ///< Composantes connexes filtrées sur leur circularité
+};
+
+/**
+ * @brief Réglages des parseurs, propres à un contexte
+ *
+ * Les valeurs par défaut reproduisent le comportement d'origine des parseurs.
+ */
+struct ParserSettings {
+    ShapeDetector shape_detector = ShapeDetector::CONTOURS; ///< Détection des parseurs SHAPE et CENTER_PARSER
+    CircleDetector circle_detector = CircleDetector::HOUGH; ///< Détection du parseur CIRCLE
+    BarcodeBackend barcode_backend = BarcodeBackend::ZXING; ///< Décodage des codes-barres (voir decoder)
+    /// Réduction de la détection grossière : 1 (désactivée), 2 ou 4 (voir pyramid_scale_factor)
+    int pyramid_scale = 1;
+    /// Demi-côté (en pixels) des fenêtres de identify_barcodes_near, 0 : image entière
+    int barcode_search_radius = 0;
+    bool qr_locate_only = false;        ///< Localise les codes QR de coin sans les décoder (parseur ZXING)
+    bool parallel_quadrants = false;    ///< Analyse les quatre quadrants de smaller_parse en parallèle
+    bool early_quadrant_stop = false;   ///< Ignore le quadrant BR si les trois autres sont acceptés
+    bool corner_layout_pruning = false; ///< Élague le choix des coins de CENTER_PARSER par la mise en page
+};
+
+/**
+ * @brief Tampons de travail d'une fonction de détection appliquée à un quadrant
+ */
+struct ScratchBuffers {
+    cv::Mat edges;                                ///< Contours de Canny
+    cv::Mat binary;                               ///< Image binarisée
+    cv::Mat labels;                               ///< Étiquettes des composantes connexes
+    cv::Mat stats;                                ///< Statistiques des composantes connexes
+    cv::Mat centroids;                            ///< Centroïdes des composantes connexes
+    cv::Mat mask;                                 ///< Masque des composantes, écrit dans la boîte de chacune
+    cv::Mat horizontal;                           ///< Ouverture horizontale d'un masque (parseur CROSS)
+    cv::Mat vertical;                             ///< Ouverture verticale d'un masque (parseur CROSS)
+    cv::Mat core;                                 ///< Intersection des deux ouvertures (parseur CROSS)
+    cv::Mat darkness;                             ///< Noirceur des pixels d'une composante (parseur CROSS)
+    std::vector<cv::Point> points;                ///< Pixels non nuls d'un masque
+    std::vector<std::vector<cv::Point>> contours; ///< Contours trouvés par cv::findContours
+    std::vector<cv::Vec4i> hierarchy;             ///< Hiérarchie des contours
+    TemplateMatchBuffers matching;                ///< Tampons de la corrélation avec un modèle (parseur CUSTOM)
+};
+
+/**
+ * @brief Tampons, décodeurs et réglages réutilisés par un thread de travail pour toutes ses copies
+ */
+struct ParserContext {
+    ParserSettings settings; ///< Réglages des parseurs appelés avec ce contexte
+
+    ScratchBuffers quadrants[4]; ///< Tampons des quadrants de smaller_parse, indexés par Corner
+
+    std::vector<DetectedBarcode> barcodes;        ///< Résultat du dernier décodage de codes-barres
+    std::vector<DetectedBarcode> coarse_barcodes; ///< Codes-barres trouvés sur l'image réduite
+    int barcode_fallbacks = 0;                    ///< Replis de identify_barcodes_near sur l'image entière
+
+    cv::Point2f page_size{ 0, 0 }; ///< Taille (en mm) de la page attendue, 0 si inconnue (voir set_page_geometry)
+    float corner_marker_size = 0;  ///< Côté (en mm) des marqueurs de coin de la mise en page, 0 si inconnu
+    std::string template_dir;      ///< Répertoire des modèles rendus (parseur CUSTOM), vide : répertoire temporaire
+
+    /// Décodeurs de codes-barres, indexés par BarcodeBackend et créés au premier usage
+    std::array<std::unique_ptr<BarcodeDecoder>, NB_BARCODE_BACKENDS> decoders;
+
+    /**
+     * @brief Décodeur de ce contexte pour une bibliothèque, créé au premier appel
+     *
+     * @throw std::invalid_argument Si la bibliothèque n'est pas disponible dans cette compilation
+     */
+    BarcodeDecoder& decoder(BarcodeBackend backend) {
+        auto& decoder = decoders[(int) backend];
+        if (!decoder)
+            decoder = make_barcode_decoder(backend);
+        return *decoder;
+    }
+};
+
+#endif // PARSER_CONTEXT_H
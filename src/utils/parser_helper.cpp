@@ -1,6 +1,7 @@
 #include <vector>
 #include <string>
 #include <optional>
+#include <algorithm>
 
 #include <common.h>
 #include "parser_helper.h"
@@ -14,74 +15,193 @@
 #include "center_marker_parser.h"
 #include "aruco_parser.h"
 #include "shape_parser.h"
+#include "qr_eye_parser.h"
+#include "cross_parser.h"
+#include "custom_parser.h"
 #include "cli_helper.h"
 
-std::unordered_map<ParserType, Parser> parsers = {
+// Table en lecture seule : peut être consultée depuis plusieurs threads sans synchronisation
+const std::unordered_map<ParserType, Parser> parsers = {
     { ParserType::DEFAULT_PARSER, { default_parser } },
     { ParserType::ZXING, { zxing_parser } },
     { ParserType::CIRCLE, { circle_parser } },
     { ParserType::ARUCO, { aruco_parser } },
     { ParserType::SHAPE, { shape_parser } },
     { ParserType::CENTER_PARSER, { center_marker_parser } },
+    { ParserType::QR_EYE, { qr_eye_parser } },
+    { ParserType::CROSS, { cross_parser } },
+    { ParserType::CUSTOM, { custom_parser } },
     { ParserType::EMPTY, { qrcode_empty_parser } },
 };
 
-std::vector<DetectedBarcode> identify_barcodes(const cv::Mat& img,
-#ifdef ENABLE_ZBAR
-                                               zbar_symbol_type_t flags
-#else
-                                               ZXing::BarcodeFormats flags
-#endif
-) {
-    std::vector<DetectedBarcode> barcodes = {};
-
+/**
+ * @brief Décode les codes-barres d'une image et les ajoute à barcodes, décalés de offset
+ *
+ * Le décodeur de la bibliothèque choisie par ctx.settings.barcode_backend est celui du contexte, qui conserve
+ * son état d'un appel à l'autre.
+ */
+static void decode_barcodes(ParserContext& ctx, const cv::Mat& img, const cv::Point2i& offset,
+                            ZXing::BarcodeFormats flags, std::vector<DetectedBarcode>& barcodes) {
     if (img.type() != CV_8U)
         throw std::invalid_argument(
             "img has type != CV_8U while it should contain luminance information on 8-bit unsigned integers");
 
     if (img.cols < 2 || img.rows < 2)
-        return {};
+        return;
 
-#ifdef ENABLE_ZBAR
-    zbar::Image image(img.cols, img.rows, "Y800", (uchar*) img.data, img.cols * img.rows);
-    zbar::ImageScanner scanner;
+    ctx.decoder(ctx.settings.barcode_backend).decode(img, offset, flags, barcodes);
+}
 
-    // Configure scanner
-    scanner.set_config(flags, zbar::ZBAR_CFG_ENABLE, 1);
+const std::vector<DetectedBarcode>& identify_barcodes(ParserContext& ctx, const cv::Mat& img,
+                                                      ZXing::BarcodeFormats flags) {
+    ctx.barcodes.clear();
+    decode_barcodes(ctx, img, { 0, 0 }, flags, ctx.barcodes);
+    return ctx.barcodes;
+}
 
-    // Scan the image for barcodes and QRCodes
-    int n = scanner.scan(image);
+int pyramid_scale_factor(int scale) {
+    int factor = 1;
+    while (factor * 2 <= std::min(scale, 4))
+        factor *= 2;
+    return factor;
+}
 
-    // Print results
-    for (zbar::Image::SymbolIterator symbol = image.symbol_begin(); symbol != image.symbol_end(); ++symbol) {
-        DetectedBarcode barcode;
-        barcode.content = symbol->get_data();
+cv::Mat pyramid_downscale(const cv::Mat& img, int scale) {
+    cv::Mat small_img = img;
+    for (int factor = scale; factor > 1; factor /= 2) {
+        cv::Mat half;
+        cv::pyrDown(small_img, half);
+        small_img = half;
+    }
+    return small_img;
+}
+
+std::vector<cv::Rect> pyramid_refine_windows(const std::vector<cv::Rect>& coarse_rects, int scale, int margin,
+                                             const cv::Size& img_size) {
+    const cv::Rect img_rect(0, 0, img_size.width, img_size.height);
+    std::vector<cv::Rect> windows;
+    windows.reserve(coarse_rects.size());
+
+    for (const auto& rect : coarse_rects) {
+        cv::Rect window = cv::Rect(rect.x * scale - margin, rect.y * scale - margin, rect.width * scale + 2 * margin,
+                                   rect.height * scale + 2 * margin) &
+                          img_rect;
+        if (window.area() == 0)
+            continue;
 
-        // Obtain location
-        for (int i = 0; i < symbol->get_location_size(); i++) {
-            barcode.bounding_box.emplace_back(cv::Point2f(symbol->get_location_x(i), symbol->get_location_y(i)));
+        // une fenêtre absorbe toutes celles qu'elle chevauche, jusqu'à ce qu'il n'y en ait plus
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (auto it = windows.begin(); it != windows.end(); ++it) {
+                if ((*it & window).area() > 0) {
+                    window |= *it;
+                    windows.erase(it);
+                    merged = true;
+                    break;
+                }
+            }
         }
+        windows.emplace_back(window);
+    }
+    return windows;
+}
 
-        barcodes.emplace_back(barcode);
+/**
+ * @brief Décode les codes-barres sur l'image réduite puis relit chacun à pleine résolution
+ *
+ * Si moins de min_found codes-barres sont trouvés sur l'image réduite, ou si l'un d'eux ne peut
+ * pas être relu à pleine résolution, l'image entière est décodée (repli comptabilisé).
+ */
+static const std::vector<DetectedBarcode>& identify_barcodes_pyramid(ParserContext& ctx, const cv::Mat& img,
+                                                                     int min_found,
+                                                                     ZXing::BarcodeFormats flags) {
+    const int scale = ctx.settings.pyramid_scale;
+    if (scale <= 1)
+        return identify_barcodes(ctx, img, flags);
+
+    ctx.coarse_barcodes.clear();
+    decode_barcodes(ctx, pyramid_downscale(img, scale), { 0, 0 }, flags, ctx.coarse_barcodes);
+    if ((int) ctx.coarse_barcodes.size() < min_found) {
+        ctx.barcode_fallbacks += 1;
+        return identify_barcodes(ctx, img, flags);
     }
-#else
-    auto iv =
-        ZXing::ImageView(reinterpret_cast<const uint8_t*>(img.ptr()), img.cols, img.rows, ZXing::ImageFormat::Lum);
-    auto options = ZXing::ReaderOptions().setFormats(flags);
-    auto z_barcodes = ZXing::ReadBarcodes(iv, options);
-    for (const auto& b : z_barcodes) {
-        DetectedBarcode barcode;
-        barcode.content = b.text();
-
-        std::vector<cv::Point> corners;
-        for (int j = 0; j < 4; ++j) {
-            const auto& p = b.position()[j];
-            barcode.bounding_box.emplace_back(cv::Point2f(p.x, p.y));
+
+    const cv::Rect img_rect(0, 0, img.cols, img.rows);
+    auto& barcodes = ctx.barcodes;
+    barcodes.clear();
+    for (const auto& coarse : ctx.coarse_barcodes) {
+        cv::Rect window = cv::boundingRect(coarse.bounding_box);
+        // la marge couvre l'imprécision du niveau réduit et la zone de silence du code-barres
+        const int margin = std::max(window.width, window.height) / 2 + 2;
+        window = cv::Rect((window.x - margin) * scale, (window.y - margin) * scale, (window.width + 2 * margin) * scale,
+                          (window.height + 2 * margin) * scale) &
+                 img_rect;
+
+        // seul le code-barres relu avec le même contenu est gardé parmi ceux de la fenêtre
+        const size_t first = barcodes.size();
+        decode_barcodes(ctx, img(window), window.tl(), flags, barcodes);
+        auto refined = std::find_if(barcodes.begin() + first, barcodes.end(),
+                                    [&](const DetectedBarcode& barcode) { return barcode.content == coarse.content; });
+        if (refined == barcodes.end()) {
+            ctx.barcode_fallbacks += 1;
+            return identify_barcodes(ctx, img, flags);
+        }
+        if (refined != barcodes.begin() + first)
+            std::swap(*refined, barcodes[first]);
+        barcodes.resize(first + 1);
+    }
+    return barcodes;
+}
+
+const std::vector<DetectedBarcode>& identify_barcodes_near(ParserContext& ctx, const cv::Mat& img,
+                                                           const std::vector<cv::Point2f>& expected_corner_points,
+                                                           int corner_mask, int min_found,
+                                                           ZXing::BarcodeFormats flags) {
+    const int radius = ctx.settings.barcode_search_radius;
+    if (radius <= 0)
+        return identify_barcodes_pyramid(ctx, img, min_found, flags);
+
+    const cv::Rect img_rect(0, 0, img.cols, img.rows);
+    auto& barcodes = ctx.barcodes;
+    barcodes.clear();
+    int nb_found = 0;
+
+    for (int corner = 0; corner < (int) expected_corner_points.size(); ++corner) {
+        if (!((1 << corner) & corner_mask))
+            continue;
+
+        const cv::Point center = expected_corner_points[corner];
+        const cv::Rect window = cv::Rect(center.x - radius, center.y - radius, 2 * radius, 2 * radius) & img_rect;
+
+        const size_t first = barcodes.size();
+        decode_barcodes(ctx, img(window), window.tl(), flags, barcodes);
+        if (barcodes.size() > first)
+            nb_found += 1;
+
+        // deux fenêtres qui se chevauchent peuvent décoder le même code-barres
+        for (size_t i = first; i < barcodes.size();) {
+            const auto& barcode = barcodes[i];
+            bool duplicate = false;
+            for (size_t j = 0; j < first; ++j) {
+                const auto& other = barcodes[j];
+                if (other.content == barcode.content &&
+                    cv::norm(center_of_box(other.bounding_box) - center_of_box(barcode.bounding_box)) < 1.0) {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (duplicate)
+                barcodes.erase(barcodes.begin() + i);
+            else
+                ++i;
         }
-        barcodes.emplace_back(barcode);
     }
-#endif
 
+    if (nb_found < min_found) {
+        ctx.barcode_fallbacks += 1;
+        return identify_barcodes(ctx, img, flags);
+    }
     return barcodes;
 }
 
@@ -116,70 +236,16 @@ std::optional<cv::Mat> get_affine_transform(int found_corner_mask,
     return cv::getAffineTransform(src, dst);
 }
 
-void differentiate_atomic_boxes(std::vector<std::shared_ptr<AtomicBox>>& boxes,
-                                std::vector<std::optional<std::shared_ptr<AtomicBox>>>& corner_markers,
-                                std::vector<std::vector<std::shared_ptr<AtomicBox>>>& user_boxes_per_page) {
-    corner_markers.resize(5);
-    user_boxes_per_page.clear();
-
-    if (boxes.empty())
-        return;
-    int max_page = 1;
-
-    for (const auto& box : boxes) {
-        max_page = std::max(max_page, box->page);
-    }
-    user_boxes_per_page.resize(max_page);
-
-    int corner_mask = 0;
-    for (auto box : boxes) {
-        if (starts_with(box->id, "hz")) {
-            int corner = -1;
-            if (starts_with(box->id, "hztl"))
-                corner = TOP_LEFT;
-            else if (starts_with(box->id, "hztr"))
-                corner = TOP_RIGHT;
-            else if (starts_with(box->id, "hzbl"))
-                corner = BOTTOM_LEFT;
-            else if (starts_with(box->id, "hzbr"))
-                corner = BOTTOM_RIGHT;
-            else if (starts_with(box->id, "hztc"))
-                corner = TOP_CENTER;
-            if (corner != -1) {
-                corner_markers[corner] = box;
-                corner_mask |= (1 << corner);
-            }
-        } else {
-            user_boxes_per_page.at(box->page - 1).emplace_back(box);
-        }
-    }
-
-    /// TODO: Adapter le code pour gérer les marqueurs de coin manquants
-    // if (sum_mask(corner_mask) < 3)
-    //     throw std::invalid_argument("some corner markers are missing in the atomic box JSON description");
-}
-
-std::vector<cv::Point2f>
-calculate_center_of_marker(const std::vector<std::optional<std::shared_ptr<AtomicBox>>>& corner_markers,
-                           const cv::Point2f& src_img_size, const cv::Point2f& dst_img_size) {
+std::vector<cv::Point2f> calculate_center_of_marker(const Layout& layout, const cv::Point2f& src_img_size,
+                                                    const cv::Point2f& dst_img_size) {
     std::vector<cv::Point2f> corner_points;
     corner_points.resize(4);
     for (int corner = 0; corner < 4; ++corner) {
-        if (corner_markers[corner].has_value() == false) {
+        const auto& marker = layout.corners[corner];
+        if (!marker.has_value())
             continue;
-        }
-        auto marker = corner_markers[corner].value();
-        const std::vector<cv::Point2f> marker_bounding_box = {
-            cv::Point2f{ marker->x, marker->y }, cv::Point2f{ marker->x + marker->width, marker->y },
-            cv::Point2f{ marker->x + marker->width, marker->y + marker->height },
-            cv::Point2f{ marker->x, marker->y + marker->height }
-        };
-
-        // compute the center of the marker
-        auto mean_point = center_of_box(marker_bounding_box);
-        // printf("corner[%d] mean point: (%f, %f)\n", corner, mean_point.x, mean_point.y);
-
-        corner_points[corner] = coord_scale(mean_point, src_img_size, dst_img_size);
+
+        corner_points[corner] = coord_scale(marker->center(), src_img_size, dst_img_size);
     }
     return corner_points;
 }
@@ -194,6 +260,21 @@ cv::Mat redress_image(cv::Mat img, cv::Mat affine_transform) {
     return calibrated_img_col;
 }
 
+cv::Mat redress_roi(const cv::Mat& img, const cv::Mat& affine_transform, const cv::Rect& roi) {
+    // warpAffine inverse lui-même la transformation : il suffit de translater la destination
+    cv::Mat roi_transform;
+    affine_transform.convertTo(roi_transform, CV_64F);
+    roi_transform.at<double>(0, 2) -= roi.x;
+    roi_transform.at<double>(1, 2) -= roi.y;
+
+    cv::Mat calibrated_roi;
+    warpAffine(img, calibrated_roi, roi_transform, roi.size(), cv::INTER_LINEAR);
+
+    cv::Mat calibrated_roi_col;
+    cv::cvtColor(calibrated_roi, calibrated_roi_col, cv::COLOR_GRAY2BGR);
+    return calibrated_roi_col;
+}
+
 int copy_config_to_flag(const CopyMarkerConfig& copy_marker_config) {
     int flag = 0;
 
@@ -232,6 +313,12 @@ std::string parser_type_to_string(ParserType parser_type) {
             return "CENTER_PARSER";
         case ParserType::DEFAULT_PARSER:
             return "DEFAULT_PARSER";
+        case ParserType::QR_EYE:
+            return "QR_EYE";
+        case ParserType::CROSS:
+            return "CROSS";
+        case ParserType::CUSTOM:
+            return "CUSTOM";
         case ParserType::EMPTY:
             return "EMPTY";
         default:
@@ -247,6 +334,9 @@ ParserType string_to_parser_type(const std::string& parser_type_str) {
         { "SHAPE", ParserType::SHAPE },
         { "CENTER_PARSER", ParserType::CENTER_PARSER },
         { "DEFAULT_PARSER", ParserType::DEFAULT_PARSER },
+        { "QR_EYE", ParserType::QR_EYE },
+        { "CROSS", ParserType::CROSS },
+        { "CUSTOM", ParserType::CUSTOM },
         { "EMPTY", ParserType::EMPTY }
     };
 
@@ -258,14 +348,14 @@ ParserType string_to_parser_type(const std::string& parser_type_str) {
     return ParserType::ZXING; // Valeur par défaut
 }
 
-std::optional<cv::Mat> run_parser(const ParserType& parser_type, cv::Mat img,
+std::optional<cv::Mat> run_parser(ParserContext& ctx, const ParserType& parser_type, cv::Mat img,
 #ifdef DEBUG
                                   cv::Mat debug_img,
 #endif
                                   Metadata& meta, std::vector<cv::Point2f>& dst_corner_points, int flag_barcode) {
     printf("run_parser: %s\n", parser_type_to_string(parser_type).c_str());
-    auto parser = parsers[parser_type];
-    return parser.parser(img,
+    const auto& parser = parsers.at(parser_type);
+    return parser.parser(ctx, img,
 #ifdef DEBUG
                          debug_img,
 #endif
@@ -279,4 +369,37 @@ std::optional<DetectedBarcode> select_bottom_right_corner(const std::vector<Dete
         }
     }
     return {};
+}
+
+cv::Rect corner_quadrant(const cv::Size& img_size, int corner, float size) {
+    const int width = img_size.width * size;
+    const int height = img_size.height * size;
+    const int x = (corner == TOP_RIGHT || corner == BOTTOM_RIGHT) ? (int) (img_size.width * (1 - size)) : 0;
+    const int y = (corner == BOTTOM_LEFT || corner == BOTTOM_RIGHT) ? (int) (img_size.height * (1 - size)) : 0;
+    return cv::Rect(x, y, width, height);
+}
+
+void set_page_geometry(ParserContext& ctx, const Layout& layout, const cv::Point2f& page_size) {
+    ctx.page_size = page_size;
+    ctx.corner_marker_size = layout.corners[TOP_LEFT].has_value() ? layout.corners[TOP_LEFT]->width : 0.f;
+}
+
+std::optional<ShapeDetector> string_to_shape_detector(const std::string& name) {
+    if (name == "contours")
+        return ShapeDetector::CONTOURS;
+    if (name == "components")
+        return ShapeDetector::COMPONENTS;
+    return {};
+}
+
+std::optional<CircleDetector> string_to_circle_detector(const std::string& name) {
+    if (name == "hough")
+        return CircleDetector::HOUGH;
+    if (name == "blobs")
+        return CircleDetector::BLOBS;
+    return {};
+}
+
+std::string circle_detector_to_string(CircleDetector detector) {
+    return detector == CircleDetector::BLOBS ? "blobs" : "hough";
 }
\ No newline at end of file
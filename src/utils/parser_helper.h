@@ -12,12 +12,14 @@
  * pour le traitement des images et la gestion des transformations géométriques.
  */
 
-#ifdef ENABLE_ZBAR
-#include <zbar.h>
-#else
 #include <ZXing/ReadBarcode.h>
-#endif
 #include <common.h>
+#include <atomic>
+#include <functional>
+
+#include "parser_context.h"
+#include "corner_solver.h"
+#include "layout.h"
 
 /**
  * @brief Convertit un type de parseur (ParserType) en chaîne de caractères
@@ -36,28 +38,50 @@ std::string parser_type_to_string(ParserType parser_type);
 ParserType string_to_parser_type(const std::string& parser_type_str);
 
 /**
- * @brief Structure représentant un code-barres détecté dans l'image
+ * @brief Identifie tous les codes-barres présents dans une image
+ *
+ * Le décodage utilise la bibliothèque choisie par ctx.settings.barcode_backend (ZXing par défaut).
+ * Le résultat est écrit dans ctx.barcodes, dont la capacité est réutilisée d'un appel à l'autre ;
+ * la référence retournée reste valide jusqu'au prochain décodage avec le même contexte.
+ *
+ * @param ctx Contexte du thread appelant
+ * @param img Image en niveau de gris (CV_8U) à analyser
+ * @param flags Formats de codes-barres à rechercher
+ * @return const std::vector<DetectedBarcode>& Liste des codes-barres détectés avec leur contenu et position
+ * @throw std::invalid_argument Si l'image n'est pas au format CV_8U
  */
-struct DetectedBarcode {
-    std::string content;                   ///< Contenu décodé du code-barres
-    std::vector<cv::Point2f> bounding_box; ///< Points délimitant le contour du code-barres
-};
+const std::vector<DetectedBarcode>& identify_barcodes(ParserContext& ctx, const cv::Mat& img,
+                                                      ZXing::BarcodeFormats flags = ZXing::BarcodeFormat::QRCode);
 
 /**
- * @brief Identifie tous les codes-barres présents dans une image
+ * @brief Masque (CornerBF) des quatre coins de la page.
+ */
+constexpr int ALL_CORNERS_BF = TOP_LEFT_BF | TOP_RIGHT_BF | BOTTOM_LEFT_BF | BOTTOM_RIGHT_BF;
+
+/**
+ * @brief Identifie les codes-barres dans des fenêtres centrées sur les positions attendues des marqueurs
+ *
+ * Seules les fenêtres de rayon ctx.settings.barcode_search_radius autour des coins de corner_mask sont
+ * décodées, puis les positions sont ramenées dans le repère de l'image. Si moins de min_found
+ * fenêtres contiennent un code-barres, l'image entière est décodée (repli, comptabilisé dans
+ * ctx.barcode_fallbacks). Si le rayon de recherche est nul, l'image entière est décodée
+ * directement, ou en deux niveaux si ctx.settings.pyramid_scale est supérieur à 1 : décodage sur l'image
+ * réduite puis relecture de chaque code-barres à pleine résolution, avec le même repli.
+ *
+ * Comme pour identify_barcodes, le résultat est écrit dans ctx.barcodes.
  *
+ * @param ctx Contexte du thread appelant
  * @param img Image en niveau de gris (CV_8U) à analyser
- * @param flags Type de code-barres à rechercher (dépend de la bibliothèque utilisée)
- * @return std::vector<DetectedBarcode> Liste des codes-barres détectés avec leur contenu et position
- * @throw std::invalid_argument Si l'image n'est pas au format CV_8U
+ * @param expected_corner_points Positions attendues des coins dans l'image (indexées par Corner)
+ * @param corner_mask Coins (CornerBF) portant un code-barres
+ * @param min_found Nombre minimal de fenêtres contenant un code-barres pour éviter le repli
+ * @param flags Formats de codes-barres à rechercher
+ * @return const std::vector<DetectedBarcode>& Liste des codes-barres détectés avec leur contenu et position
  */
-std::vector<DetectedBarcode> identify_barcodes(const cv::Mat& img,
-#ifdef ENABLE_ZBAR
-                                               zbar_symbol_type_t flags = zbar::ZBAR_ZXING
-#else
-                                               ZXing::BarcodeFormats flags = ZXing::BarcodeFormat::QRCode
-#endif
-);
+const std::vector<DetectedBarcode>& identify_barcodes_near(ParserContext& ctx, const cv::Mat& img,
+                                                           const std::vector<cv::Point2f>& expected_corner_points,
+                                                           int corner_mask, int min_found,
+                                                           ZXing::BarcodeFormats flags = ZXing::BarcodeFormat::QRCode);
 
 /**
  * @brief Calcule la transformation affine à partir des points de coin trouvés et attendus
@@ -71,43 +95,20 @@ std::optional<cv::Mat> get_affine_transform(int found_corner_mask,
                                             const std::vector<cv::Point2f>& expected_corner_points,
                                             const std::vector<cv::Point2f>& found_corner_points);
 
-/**
- * @brief Différencie les AtomicBox en les classant par type et page.
- *
- * La fonction sépare les boîtes en trois catégories :
- * - Les marqueurs généraux (markers) dont l'identifiant commence par "marker barcode ".
- * - Les marqueurs de coin (corner_markers) pour lesquels l'identifiant contient les suffixes tl, tr, bl, br, tc.
- * - Les boîtes utilisateur (user_boxes_per_page), regroupées par numéro de page.
- *
- * Un contrôle est effectué pour s'assurer que tous les marqueurs de coin sont présents. En cas d'absence,
- * une exception std::invalid_argument est levée.
- *
- * @param boxes Vecteur de pointeurs partagés sur les AtomicBox à différencier.
- * @param corner_markers Vecteur de pointeurs partagés (de taille 5) où chaque index correspond à un coin :
- *        TOP_LEFT, TOP_RIGHT, BOTTOM_LEFT, BOTTOM_RIGHT, TOP_CENTER.
- * @param user_boxes_per_page Vecteur de vecteurs de pointeurs partagés qui regroupe les boîtes utilisateur par page.
- *
- * @throw std::invalid_argument Si un ou plusieurs marqueurs de coin sont manquants dans la description JSON.
- */
-void differentiate_atomic_boxes(std::vector<std::shared_ptr<AtomicBox>>& boxes,
-                                std::vector<std::optional<std::shared_ptr<AtomicBox>>>& corner_markers,
-                                std::vector<std::vector<std::shared_ptr<AtomicBox>>>& user_boxes_per_page);
-
 /**
  * @brief Calcule le centre des marqueurs de coin
  *
- * Pour chaque marqueur de coin fourni, la fonction calcule le centre de sa boîte englobante
- * puis applique une transformation de redimensionnement pour adapter ce centre aux dimensions
- * de l'image destination
+ * Pour chaque marqueur de coin de la mise en page, la fonction calcule le centre de sa boîte
+ * englobante puis applique une transformation de redimensionnement pour adapter ce centre aux
+ * dimensions de l'image destination
  *
- * @param corner_markers Vecteur de pointeurs partagés sur les marqueurs de coin dans l'image source
+ * @param layout Mise en page compilée (voir compile_layout)
  * @param src_img_size Taille de l'image source (largeur, hauteur)
  * @param dst_img_size Taille de l'image destination (largeur, hauteur)
- * @return std::vector<cv::Point2f> Vecteur contenant les points centraux des marqueurs redimensionnés
+ * @return std::vector<cv::Point2f> Points centraux des marqueurs redimensionnés, indexés par Corner (4 coins)
  */
-std::vector<cv::Point2f>
-calculate_center_of_marker(const std::vector<std::optional<std::shared_ptr<AtomicBox>>>& corner_markers,
-                           const cv::Point2f& src_img_size, const cv::Point2f& dst_img_size);
+std::vector<cv::Point2f> calculate_center_of_marker(const Layout& layout, const cv::Point2f& src_img_size,
+                                                    const cv::Point2f& dst_img_size);
 
 /**
  * @brief Redresse une image en appliquant une transformation affine.
@@ -121,9 +122,24 @@ calculate_center_of_marker(const std::vector<std::optional<std::shared_ptr<Atomi
  */
 cv::Mat redress_image(cv::Mat img, cv::Mat affine_transform);
 
+/**
+ * @brief Redresse uniquement une zone rectangulaire de l'image.
+ *
+ * Équivalent à redress_image(img, affine_transform)(roi), sans redresser la page entière :
+ * la transformation est décalée pour que le coin haut gauche de la zone devienne l'origine,
+ * puis seuls les pixels de la zone sont rééchantillonnés depuis l'image source.
+ *
+ * @param img Image en niveaux de gris à redresser
+ * @param affine_transform Matrice de transformation affine à appliquer
+ * @param roi Zone à extraire, en pixels dans l'image redressée
+ * @return cv::Mat Zone redressée et convertie en couleur BGR
+ */
+cv::Mat redress_roi(const cv::Mat& img, const cv::Mat& affine_transform, const cv::Rect& roi);
+
 /**
  * @brief Exécute le parseur spécifié sur l'image donnée
  *
+ * @param ctx Contexte du thread appelant, réutilisé d'une copie à l'autre
  * @param parser_type Type de parseur à utiliser
  * @param img Image à analyser
  * @param meta Métadonnées à remplir pendant l'analyse
@@ -131,7 +147,7 @@ cv::Mat redress_image(cv::Mat img, cv::Mat affine_transform);
  * @param flag_barcode Type de code-barres à rechercher (par défaut : QRCode)
  * @return std::optional<cv::Mat> Matrice de transformation affine si trouvée, sinon nullopt
  */
-std::optional<cv::Mat> run_parser(const ParserType& parser_type, cv::Mat img,
+std::optional<cv::Mat> run_parser(ParserContext& ctx, const ParserType& parser_type, cv::Mat img,
 #ifdef DEBUG
                                   cv::Mat debug_img,
 #endif
@@ -148,67 +164,388 @@ int copy_config_to_flag(const CopyMarkerConfig& copy_marker_config);
  */
 std::optional<DetectedBarcode> select_bottom_right_corner(const std::vector<DetectedBarcode>& barcodes);
 
+/**
+ * @brief Quadrants dont smaller_parse soumet les résultats à la fonction d'acceptation.
+ *
+ * Le coin inférieur droit est donné par le code-barres : seuls les trois autres coins sont cherchés.
+ */
+constexpr int QUADRANTS_EXCEPT_BOTTOM_RIGHT = TOP_LEFT_BF | TOP_RIGHT_BF | BOTTOM_LEFT_BF;
+
+/**
+ * @brief Fonction d'acceptation des résultats des quadrants TL, TR et BL (voir smaller_parse)
+ *
+ * Le type est imbriqué pour que l'argument ne participe pas à la déduction de T.
+ */
 template <typename T>
-std::vector<T> smaller_parse(const cv::Mat& img,
+struct QuadrantAcceptance {
+    using type = std::function<bool(const std::vector<T>&)>;
+};
+
+/**
+ * @brief Convertit un nom de méthode ("hough" ou "blobs") en CircleDetector
+ *
+ * @param name Nom de la méthode
+ * @return std::optional<CircleDetector> Méthode correspondante, ou nullopt si le nom est inconnu
+ */
+std::optional<CircleDetector> string_to_circle_detector(const std::string& name);
+
+/**
+ * @brief Convertit un CircleDetector en nom de méthode ("hough" ou "blobs")
+ */
+std::string circle_detector_to_string(CircleDetector detector);
+
+/**
+ * @brief Convertit un nom de méthode ("contours" ou "components") en ShapeDetector
+ *
+ * @param name Nom de la méthode
+ * @return std::optional<ShapeDetector> Méthode correspondante, ou nullopt si le nom est inconnu
+ */
+std::optional<ShapeDetector> string_to_shape_detector(const std::string& name);
+
+/**
+ * @brief Renseigne dans le contexte la géométrie de la page attendue
+ *
+ * La taille de la page permet d'estimer la résolution d'une copie à partir de sa largeur ; la taille
+ * des marqueurs de coin est celle du marqueur haut gauche de la mise en page (0 s'il est absent).
+ * Le parseur CUSTOM en a besoin pour rendre son modèle à l'échelle de la copie.
+ *
+ * @param ctx Contexte du thread appelant
+ * @param layout Mise en page de la copie
+ * @param page_size Taille de la page, en mm
+ */
+void set_page_geometry(ParserContext& ctx, const Layout& layout, const cv::Point2f& page_size);
+
+/**
+ * @brief Retourne le quadrant d'un coin de l'image, tel qu'analysé par smaller_parse
+ *
+ * @param img_size Taille de l'image
+ * @param corner Coin (Corner) : TOP_LEFT, TOP_RIGHT, BOTTOM_LEFT ou BOTTOM_RIGHT
+ * @param size Taille relative du quadrant
+ * @return cv::Rect Quadrant du coin, en pixels
+ */
+cv::Rect corner_quadrant(const cv::Size& img_size, int corner, float size = 0.2);
+
+/**
+ * @brief Implémentation commune des variantes de smaller_parse
+ *
+ * @param settings Réglages du contexte appelant (analyse parallèle et arrêt anticipé)
+ * @param parse_quadrant_func Analyse d'un quadrant, appelée avec (corner, quadrant, décalage du quadrant)
+ * @param accept Fonction d'acceptation des résultats TL, TR et BL (vide : analyse toujours les quatre)
+ */
+template <typename T, typename ParseQuadrant>
+std::vector<T> parse_quadrants(const ParserSettings& settings, const cv::Mat& img,
 #ifdef DEBUG
-                             cv::Mat debug_img,
+                               cv::Mat debug_img,
 #endif
-                             std::vector<T> (*parse_func)(const cv::Mat&, const cv::Point2i&), float size = 0.2) {
+                               ParseQuadrant parse_quadrant_func, float size,
+                               const typename QuadrantAcceptance<T>::type& accept) {
+    // indexés par Corner : TOP_LEFT, TOP_RIGHT, BOTTOM_LEFT, BOTTOM_RIGHT
+    const cv::Rect quadrants[4] = { corner_quadrant(img.size(), TOP_LEFT, size),
+                                    corner_quadrant(img.size(), TOP_RIGHT, size),
+                                    corner_quadrant(img.size(), BOTTOM_LEFT, size),
+                                    corner_quadrant(img.size(), BOTTOM_RIGHT, size) };
+
+#ifdef DEBUG
+    for (const auto& quadrant : quadrants) {
+        cv::rectangle(debug_img, quadrant, cv::Scalar(255, 0, 0), 2);
+    }
+#endif
+
+    std::vector<T> parsed[4];
+    std::atomic<int> found_mask{ 0 };
+    std::atomic<bool> stop{ false };
+    const bool may_stop = accept && settings.early_quadrant_stop;
+
+    auto parse_quadrant = [&](int corner) {
+        if (stop.load())
+            return;
+        parsed[corner] = parse_quadrant_func(corner, img(quadrants[corner]), quadrants[corner].tl());
+        if (parsed[corner].empty())
+            return;
+        const int previous = found_mask.fetch_or(1 << corner);
+        const int mask = previous | (1 << corner);
+        // seul le thread qui complète les trois quadrants soumet leurs résultats, une seule fois
+        if (may_stop && (previous & QUADRANTS_EXCEPT_BOTTOM_RIGHT) != QUADRANTS_EXCEPT_BOTTOM_RIGHT &&
+            (mask & QUADRANTS_EXCEPT_BOTTOM_RIGHT) == QUADRANTS_EXCEPT_BOTTOM_RIGHT) {
+            std::vector<T> candidates;
+            for (int other : { TOP_LEFT, TOP_RIGHT, BOTTOM_LEFT }) {
+                candidates.insert(candidates.end(), parsed[other].begin(), parsed[other].end());
+            }
+            if (accept(candidates))
+                stop = true;
+        }
+    };
+
+    if (settings.parallel_quadrants) {
+        cv::parallel_for_(
+            cv::Range(0, 4),
+            [&](const cv::Range& range) {
+                for (int corner = range.start; corner < range.end; ++corner) {
+                    parse_quadrant(corner);
+                }
+            },
+            4);
+    } else {
+        for (int corner = 0; corner < 4; ++corner) {
+            parse_quadrant(corner);
+        }
+    }
+
+    const bool accepted = stop.load();
+
     std::vector<T> parsed_data;
+    for (int corner = 0; corner < 4; ++corner) {
+        if (accepted && !((1 << corner) & QUADRANTS_EXCEPT_BOTTOM_RIGHT))
+            continue;
+        parsed_data.insert(parsed_data.end(), parsed[corner].begin(), parsed[corner].end());
+    }
 
-    // top-left corner
-    cv::Mat img_tl = img(cv::Rect(0, 0, img.cols * size, img.rows * size));
+    return parsed_data;
+}
+
+/**
+ * @brief Applique une fonction d'analyse aux quatre coins de l'image.
+ *
+ * Les quadrants TL, TR, BL et BR (chacun de taille size × la taille de l'image) sont analysés
+ * séquentiellement ou en parallèle (ctx.settings.parallel_quadrants), puis les résultats sont
+ * fusionnés dans cet ordre fixe.
+ *
+ * Si l'arrêt anticipé est activé (ctx.settings.early_quadrant_stop), que les quadrants TL, TR et BL
+ * produisent chacun au moins un résultat et que accept valide leur réunion, le quadrant BR est
+ * annulé. Son résultat est alors ignoré même s'il a déjà été calculé, pour que le résultat ne
+ * dépende pas de l'ordonnancement des threads. Sinon, les résultats des quatre quadrants sont
+ * retournés.
+ *
+ * @param ctx Contexte du thread appelant, dont seuls les réglages sont utilisés
+ * @param img Image à analyser
+ * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
+ * @param parse_func Fonction d'analyse d'un quadrant, recevant le décalage du quadrant dans l'image
+ * @param size Taille relative des quadrants
+ * @param accept Validation des résultats TL, TR et BL, par exemple par solve_corners (vide : analyse
+ * toujours les quatre quadrants)
+ * @return std::vector<T> Résultats des quadrants, dans l'ordre TL, TR, BL, BR
+ */
+template <typename T>
+std::vector<T> smaller_parse(const ParserContext& ctx, const cv::Mat& img,
+#ifdef DEBUG
+                             cv::Mat debug_img,
+#endif
+                             std::vector<T> (*parse_func)(const cv::Mat&, const cv::Point2i&), float size = 0.2,
+                             const typename QuadrantAcceptance<T>::type& accept = {}) {
+    return parse_quadrants<T>(
+        ctx.settings, img,
+#ifdef DEBUG
+        debug_img,
+#endif
+        [parse_func](int, const cv::Mat& quadrant, const cv::Point2i& offset) { return parse_func(quadrant, offset); },
+        size, accept);
+}
+
+/**
+ * @brief Variante de smaller_parse dont la fonction d'analyse reçoit les tampons de son quadrant.
+ *
+ * Chaque quadrant utilise ctx.quadrants[corner] : les tampons sont réutilisés d'une copie à l'autre
+ * et ne sont jamais partagés entre deux quadrants analysés en parallèle.
+ *
+ * @param ctx Contexte du thread appelant
+ * @param img Image à analyser
+ * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
+ * @param parse_func Fonction d'analyse d'un quadrant, recevant ses tampons et le décalage du quadrant dans l'image
+ * @param size Taille relative des quadrants
+ * @param accept Validation des résultats TL, TR et BL, par exemple par solve_corners (vide : analyse
+ * toujours les quatre quadrants)
+ * @return std::vector<T> Résultats des quadrants, dans l'ordre TL, TR, BL, BR
+ */
+template <typename T>
+std::vector<T> smaller_parse(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
-    cv::polylines(debug_img,
-                  std::vector<cv::Point2i>{ { 0, 0 },
-                                            { (int) (img.cols * size), 0 },
-                                            { (int) (img.cols * size), (int) (img.rows * size) },
-                                            { 0, (int) (img.rows * size) } },
-                  true, cv::Scalar(255, 0, 0), 2);
+                             cv::Mat debug_img,
 #endif
-    auto parsed_tl = parse_func(img_tl, { 0, 0 });
-    parsed_data.insert(parsed_data.end(), parsed_tl.begin(), parsed_tl.end());
+                             std::vector<T> (*parse_func)(ScratchBuffers&, const cv::Mat&, const cv::Point2i&),
+                             float size = 0.2, const typename QuadrantAcceptance<T>::type& accept = {}) {
+    return parse_quadrants<T>(
+        ctx.settings, img,
+#ifdef DEBUG
+        debug_img,
+#endif
+        [&ctx, parse_func](int corner, const cv::Mat& quadrant, const cv::Point2i& offset) {
+            return parse_func(ctx.quadrants[corner], quadrant, offset);
+        },
+        size, accept);
+}
+
+/**
+ * @brief Position d'un marqueur réduit à son centre (voir locate_corners)
+ */
+inline cv::Point2f marker_position(const cv::Point2f& point) {
+    return point;
+}
 
-    // top-right corner
-    cv::Mat img_tr = img(cv::Rect(img.cols * (1 - size), 0, img.cols * size, img.rows * size));
+/**
+ * @brief Variante de locate_corners dont la fonction d'analyse reçoit aussi le coin de son quadrant
+ *
+ * Pour les détecteurs qui dépendent du coin, par exemple un modèle tourné différemment dans chaque
+ * quadrant (parseur CUSTOM), ou d'un réglage du contexte capturé par la fonction d'analyse (facteur
+ * de la pyramide des parseurs SHAPE et CIRCLE). Les étapes sont celles de locate_corners.
+ *
+ * @param parse_corner_func Analyse d'un quadrant : (coin, tampons du quadrant, quadrant, décalage) -> marqueurs
+ */
+template <typename T, typename ParseCorner>
+std::optional<cv::Mat> locate_corners_per_quadrant(ParserContext& ctx, const cv::Mat& img,
 #ifdef DEBUG
-    cv::polylines(debug_img,
-                  std::vector<cv::Point2i>{ { (int) (img.cols * (1 - size)), 0 },
-                                            { img.cols, 0 },
-                                            { img.cols, (int) (img.rows * size) },
-                                            { (int) (img.cols * (1 - size)), (int) (img.rows * size) } },
-                  true, cv::Scalar(255, 0, 0), 2);
+                                                   cv::Mat debug_img,
 #endif
-    auto parsed_tr = parse_func(img_tr, { (int) (img.cols * (1 - size)), 0 });
-    parsed_data.insert(parsed_data.end(), parsed_tr.begin(), parsed_tr.end());
+                                                   ParseCorner parse_corner_func,
+                                                   cv::Point2f (*marker_center)(const T&),
+                                                   const cv::Point2f& bottom_right,
+                                                   const std::vector<cv::Point2f>& dst_corner_points,
+                                                   std::vector<T>& markers) {
+    auto centers = [marker_center](const std::vector<T>& found) {
+        std::vector<cv::Point2f> points;
+        points.reserve(found.size());
+        for (const auto& marker : found) {
+            points.push_back(marker_center(marker));
+        }
+        return points;
+    };
+    auto accept = [&](const std::vector<T>& found) {
+        return all_corners_solved(solve_corners(centers(found), bottom_right, dst_corner_points));
+    };
 
-    // bottom-left corner
-    cv::Mat img_bl = img(cv::Rect(0, img.rows * (1 - size), img.cols * size, img.rows * size));
+    markers = parse_quadrants<T>(
+        ctx.settings, img,
 #ifdef DEBUG
-    cv::polylines(debug_img,
-                  std::vector<cv::Point2i>{ { 0, (int) (img.rows * (1 - size)) },
-                                            { (int) (img.cols * size), (int) (img.rows * (1 - size)) },
-                                            { (int) (img.cols * size), (int) (img.rows) },
-                                            { 0, img.rows } },
-                  true, cv::Scalar(255, 0, 0), 2);
+        debug_img,
 #endif
-    auto parsed_bl = parse_func(img_bl, { 0, (int) (img.rows * (1 - size)) });
-    parsed_data.insert(parsed_data.end(), parsed_bl.begin(), parsed_bl.end());
+        [&ctx, &parse_corner_func](int corner, const cv::Mat& quadrant, const cv::Point2i& offset) {
+            return parse_corner_func(corner, ctx.quadrants[corner], quadrant, offset);
+        },
+        0.2, accept);
+    if (markers.empty())
+        return {};
+
+    auto solution = solve_corners(centers(markers), bottom_right, dst_corner_points);
 
-    // bottom-right corner
-    cv::Mat img_br = img(cv::Rect(img.cols * (1 - size), img.rows * (1 - size), img.cols * size, img.rows * size));
 #ifdef DEBUG
-    cv::polylines(debug_img,
-                  std::vector<cv::Point2i>{ { (int) (img.cols * (1 - size)), (int) (img.rows * (1 - size)) },
-                                            { img.cols, (int) (img.rows * (1 - size)) },
-                                            { img.cols, img.rows },
-                                            { (int) (img.cols * (1 - size)), img.rows } },
-                  true, cv::Scalar(255, 0, 0), 2);
+    for (int i = 0; i < 4; ++i) {
+        if ((1 << i) & solution.found_mask)
+            cv::circle(debug_img, solution.corner_points[i], 10, cv::Scalar(0, 255, 255), -1);
+    }
 #endif
-    auto parsed_br = parse_func(img_br, { (int) (img.cols * (1 - size)), (int) (img.rows * (1 - size)) });
-    parsed_data.insert(parsed_data.end(), parsed_br.begin(), parsed_br.end());
 
-    return parsed_data;
+    return get_affine_transform(solution.found_mask, dst_corner_points, solution.corner_points);
+}
+
+/**
+ * @brief Localise les coins TL, TR et BL d'une copie dont le coin inférieur droit est donné par le code-barres
+ *
+ * Étapes communes des parseurs à marqueurs de coin : les marqueurs sont cherchés dans les quatre
+ * quadrants comme par smaller_parse (l'arrêt anticipé n'étant accepté que si solve_corners retrouve
+ * les trois coins), puis solve_corners choisit les coins parmi leurs centres et la transformation
+ * affine est calculée.
+ *
+ * @param ctx Contexte du thread appelant
+ * @param img Image à analyser
+ * @param debug_img Image de débogage (disponible uniquement en mode DEBUG)
+ * @param parse_func Fonction d'analyse d'un quadrant, recevant ses tampons et le décalage du quadrant dans l'image
+ * @param marker_center Centre d'un marqueur détecté
+ * @param bottom_right Position du code-barres du coin inférieur droit dans l'image
+ * @param dst_corner_points Positions attendues des coins (indexées par Corner)
+ * @param markers Marqueurs détectés dans les quadrants, vide si aucun n'a été trouvé
+ * @return std::optional<cv::Mat> Transformation affine, ou nullopt si moins de trois coins sont retrouvés
+ */
+template <typename T>
+std::optional<cv::Mat> locate_corners(ParserContext& ctx, const cv::Mat& img,
+#ifdef DEBUG
+                                      cv::Mat debug_img,
+#endif
+                                      std::vector<T> (*parse_func)(ScratchBuffers&, const cv::Mat&, const cv::Point2i&),
+                                      cv::Point2f (*marker_center)(const T&),
+                                      const cv::Point2f& bottom_right,
+                                      const std::vector<cv::Point2f>& dst_corner_points, std::vector<T>& markers) {
+    return locate_corners_per_quadrant(
+        ctx, img,
+#ifdef DEBUG
+        debug_img,
+#endif
+        [parse_func](int, ScratchBuffers& scratch, const cv::Mat& quadrant, const cv::Point2i& offset) {
+            return parse_func(scratch, quadrant, offset);
+        },
+        marker_center, bottom_right, dst_corner_points, markers);
+}
+
+/**
+ * @brief Facteur de réduction de la détection grossière (pyramide à deux niveaux) pour une valeur demandée.
+ *
+ * Avec 1 (par défaut), la détection se fait directement à la résolution native. Avec 2 ou 4, les
+ * candidats sont cherchés sur l'image réduite d'autant dans chaque dimension, puis affinés sur de
+ * petites fenêtres à pleine résolution. Le résultat est destiné à ParserSettings::pyramid_scale.
+ *
+ * @param scale Facteur demandé
+ * @return int Facteur de réduction (1, 2 ou 4 : puissance de 2 inférieure, au plus 4)
+ */
+int pyramid_scale_factor(int scale);
+
+/**
+ * @brief Réduit une image d'un facteur scale par applications successives de cv::pyrDown.
+ *
+ * @param img Image à réduire
+ * @param scale Facteur de réduction (puissance de 2)
+ * @return cv::Mat Image réduite (l'image elle-même si scale <= 1)
+ */
+cv::Mat pyramid_downscale(const cv::Mat& img, int scale);
+
+/**
+ * @brief Convertit des candidats trouvés sur l'image réduite en fenêtres à pleine résolution.
+ *
+ * Chaque rectangle est agrandi du facteur scale puis d'une marge, tronqué aux bords de l'image,
+ * et les fenêtres qui se chevauchent sont fusionnées pour qu'un même marqueur ne soit pas
+ * affiné deux fois.
+ *
+ * @param coarse_rects Candidats dans le repère de l'image réduite
+ * @param scale Facteur de réduction
+ * @param margin Marge en pixels (pleine résolution) ajoutée de chaque côté
+ * @param img_size Taille de l'image à pleine résolution
+ * @return std::vector<cv::Rect> Fenêtres à pleine résolution, disjointes
+ */
+std::vector<cv::Rect> pyramid_refine_windows(const std::vector<cv::Rect>& coarse_rects, int scale, int margin,
+                                             const cv::Size& img_size);
+
+/**
+ * @brief Détection en deux niveaux : candidats sur l'image réduite, affinage à pleine résolution.
+ *
+ * Si scale vaut 1, appelle directement refine_func sur l'image entière. Sinon, find_candidates
+ * reçoit l'image réduite et le facteur de réduction et retourne les rectangles englobants des
+ * candidats (dans le repère réduit) ; refine_func est ensuite appliquée à chaque fenêtre à pleine
+ * résolution, ce qui conserve la précision des positions.
+ *
+ * Appelée depuis la fonction d'analyse d'un quadrant (voir locate_corners_per_quadrant), qui lui
+ * transmet le facteur de son contexte. find_candidates et refine_func peuvent être des fonctions ou
+ * des lambdas, par exemple pour leur transmettre les tampons (ScratchBuffers) du quadrant analysé.
+ *
+ * @param img Image (ou quadrant) à analyser
+ * @param offset Décalage de img dans l'image complète
+ * @param find_candidates Recherche des candidats sur l'image réduite : (image réduite, facteur) -> rectangles
+ * @param refine_func Détection à pleine résolution, recevant le décalage de la fenêtre
+ * @param scale Facteur de réduction (ParserSettings::pyramid_scale du contexte appelant)
+ * @param margin Marge en pixels (pleine résolution) autour de chaque candidat
+ * @return Résultats de refine_func sur toutes les fenêtres
+ */
+template <typename FindCandidates, typename Refine>
+auto coarse_to_fine_parse(const cv::Mat& img, const cv::Point2i& offset, FindCandidates find_candidates,
+                          Refine refine_func, int scale, int margin) -> decltype(refine_func(img, offset)) {
+    if (scale <= 1)
+        return refine_func(img, offset);
+
+    const cv::Mat small_img = pyramid_downscale(img, scale);
+    const auto windows = pyramid_refine_windows(find_candidates(small_img, scale), scale, margin, img.size());
+
+    decltype(refine_func(img, offset)) refined;
+    for (const auto& window : windows) {
+        auto found = refine_func(img(window), offset + window.tl());
+        refined.insert(refined.end(), found.begin(), found.end());
+    }
+    return refined;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include <ctime>
+
+#include "random_stream.h"
+
+// constantes de Philox4x32 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", 2011)
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+uint64_t resolve_master_seed(int seed) {
+    return seed ? (uint32_t) seed : (uint64_t) time(0);
+}
+
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+    for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+        const uint64_t product0 = (uint64_t) PHILOX_M0 * counter[0];
+        const uint64_t product1 = (uint64_t) PHILOX_M1 * counter[2];
+        counter = { (uint32_t) (product1 >> 32) ^ counter[1] ^ key[0], (uint32_t) product1,
+                    (uint32_t) (product0 >> 32) ^ counter[3] ^ key[1], (uint32_t) product0 };
+        key[0] += PHILOX_W0;
+        key[1] += PHILOX_W1;
+    }
+    return counter;
+}
+
+uint64_t stream_seed(uint64_t master_seed, uint64_t sheet, uint32_t operation, uint32_t index) {
+    const auto block = philox4x32({ (uint32_t) sheet, (uint32_t) (sheet >> 32), operation, index },
+                                  { (uint32_t) master_seed, (uint32_t) (master_seed >> 32) });
+    return ((uint64_t) block[0] << 32) | block[1];
+}
+
+cv::RNG stream_rng(uint64_t master_seed, uint64_t sheet, uint32_t operation, uint32_t index) {
+    return cv::RNG(stream_seed(master_seed, sheet, operation, index));
+}
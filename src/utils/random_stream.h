@@ -0,0 +1,53 @@
+#ifndef RANDOM_STREAM_H
+#define RANDOM_STREAM_H
+
+/**
+ * @file random_stream.h
+ * @brief Flux aléatoires indépendants et reproductibles, dérivés d'un générateur à compteur (Philox4x32-10).
+ *
+ * Un générateur à compteur calcule le n-ième tirage directement à partir de (clé, n), sans état
+ * partagé : la graine de chaque flux est le bloc Philox de la clé (graine maîtresse) et du compteur
+ * (copie, opération, indice). Deux flux distincts ne dépendent donc ni l'un de l'autre ni de l'ordre
+ * dans lequel ils sont créés, et une même graine maîtresse produit les mêmes tirages quel que soit le
+ * nombre de threads qui traitent les copies ou les opérations.
+ *
+ * Les tirages d'une opération restent faits par un cv::RNG initialisé par stream_rng, ce qui permet
+ * aux fonctions de modification de garder leur interface.
+ */
+
+#include <array>
+#include <cstdint>
+
+#include <common.h>
+
+/**
+ * @brief Graine maîtresse des flux aléatoires : seed, ou l'heure courante si seed vaut 0
+ */
+uint64_t resolve_master_seed(int seed);
+
+/**
+ * @brief Bloc Philox4x32-10 : quatre mots de 32 bits pseudo-aléatoires pour un compteur et une clé
+ *
+ * @param counter Compteur de 128 bits
+ * @param key Clé de 64 bits
+ */
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key);
+
+/**
+ * @brief Graine de 64 bits du flux (copie, opération, indice) d'une graine maîtresse
+ *
+ * @param master_seed Graine maîtresse (clé de Philox)
+ * @param sheet Indice de la copie
+ * @param operation Identifiant de l'opération
+ * @param index Indice libre (sous-flux d'une opération, par exemple une bande de lignes)
+ */
+uint64_t stream_seed(uint64_t master_seed, uint64_t sheet, uint32_t operation, uint32_t index = 0);
+
+/**
+ * @brief Générateur cv::RNG initialisé par la graine du flux (copie, opération, indice)
+ *
+ * @see stream_seed
+ */
+cv::RNG stream_rng(uint64_t master_seed, uint64_t sheet, uint32_t operation, uint32_t index = 0);
+
+#endif // RANDOM_STREAM_H
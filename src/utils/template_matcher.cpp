@@ -0,0 +1,143 @@
+#include <cmath>
+#include <stdexcept>
+
+#include "template_matcher.h"
+
+// écart-type minimal (par pixel) d'une fenêtre pour que la corrélation y soit définie
+#define MIN_WINDOW_STDDEV 1.0
+
+namespace {
+/**
+ * @brief Décalage sous-pixel du sommet de la parabole passant par trois valeurs consécutives
+ */
+float parabolic_offset(float before, float peak, float after) {
+    const float curvature = before - 2 * peak + after;
+    if (curvature >= 0)
+        return 0;
+    return 0.5f * (before - after) / curvature;
+}
+
+/**
+ * @brief Somme d'une image intégrale sur un rectangle
+ */
+double rect_sum(const cv::Mat& integral, int x, int y, int width, int height) {
+    return integral.at<double>(y + height, x + width) - integral.at<double>(y, x + width) -
+           integral.at<double>(y + height, x) + integral.at<double>(y, x);
+}
+} // namespace
+
+TemplateMatcher::TemplateMatcher(const cv::Mat& templ, const std::vector<float>& scales) {
+    if (templ.empty() || templ.type() != CV_8U)
+        throw std::invalid_argument("template must be a non-empty CV_8U image");
+
+    for (float scale : scales) {
+        const cv::Size size((int) std::lround(templ.cols * scale), (int) std::lround(templ.rows * scale));
+        if (size.width < 2 || size.height < 2)
+            continue;
+
+        cv::Mat scaled;
+        cv::resize(templ, scaled, size, 0, 0, scale < 1 ? cv::INTER_AREA : cv::INTER_LINEAR);
+
+        ScaledTemplate scaled_template;
+        scaled.convertTo(scaled_template.centered, CV_32F);
+        cv::subtract(scaled_template.centered, cv::mean(scaled_template.centered), scaled_template.centered);
+        scaled_template.norm = cv::norm(scaled_template.centered);
+        scaled_template.scale = scale;
+        if (scaled_template.norm > 0)
+            templates_.emplace_back(std::move(scaled_template));
+    }
+}
+
+const cv::Mat& TemplateMatcher::spectrum(size_t index, const cv::Size& dft_size) const {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = spectra_.find({ dft_size.width, dft_size.height });
+    if (it == spectra_.end()) {
+        // les spectres de toutes les échelles sont calculés ensemble : l'entrée n'est plus modifiée ensuite
+        std::vector<cv::Mat> spectra;
+        for (const auto& scaled_template : templates_) {
+            cv::Mat padded = cv::Mat::zeros(dft_size, CV_32F);
+            const cv::Mat& centered = scaled_template.centered;
+            if (centered.cols <= dft_size.width && centered.rows <= dft_size.height) {
+                cv::Mat templ_area = padded(cv::Rect(0, 0, centered.cols, centered.rows));
+                centered.copyTo(templ_area);
+            }
+
+            cv::Mat templ_spectrum;
+            cv::dft(padded, templ_spectrum, 0);
+            spectra.emplace_back(std::move(templ_spectrum));
+        }
+        it = spectra_.emplace(std::make_pair(dft_size.width, dft_size.height), std::move(spectra)).first;
+    }
+    return it->second[index];
+}
+
+std::optional<TemplateMatch> TemplateMatcher::match(TemplateMatchBuffers& buffers, const cv::Mat& roi,
+                                                    const cv::Point2i& offset) const {
+    if (roi.type() != CV_8U)
+        throw std::invalid_argument("roi must be a CV_8U image");
+
+    // corrélation circulaire : sans repli pour les positions où le modèle est entièrement dans la zone
+    const cv::Size dft_size(cv::getOptimalDFTSize(roi.cols), cv::getOptimalDFTSize(roi.rows));
+
+    cv::Mat& padded_roi = buffers.padded;
+    padded_roi.create(dft_size, CV_32F);
+    padded_roi.setTo(0);
+    cv::Mat roi_area = padded_roi(cv::Rect(0, 0, roi.cols, roi.rows));
+    roi.convertTo(roi_area, CV_32F);
+    cv::Mat& roi_spectrum = buffers.spectrum;
+    cv::dft(padded_roi, roi_spectrum, 0, roi.rows);
+
+    const cv::Mat& sum = buffers.sum;
+    const cv::Mat& sqsum = buffers.sqsum;
+    cv::integral(roi, buffers.sum, buffers.sqsum, CV_64F, CV_64F);
+
+    std::optional<TemplateMatch> best;
+    for (size_t index = 0; index < templates_.size(); ++index) {
+        const auto& scaled_template = templates_[index];
+        const int width = scaled_template.centered.cols;
+        const int height = scaled_template.centered.rows;
+        if (width > roi.cols || height > roi.rows)
+            continue;
+
+        cv::Mat& correlation = buffers.correlation;
+        cv::mulSpectrums(roi_spectrum, spectrum(index, dft_size), correlation, 0, true);
+        cv::idft(correlation, correlation, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+
+        // le modèle étant de moyenne nulle, seule la variance de la fenêtre reste à normaliser
+        const int nb_pixels = width * height;
+        const double min_variance = MIN_WINDOW_STDDEV * MIN_WINDOW_STDDEV * nb_pixels;
+        cv::Mat& scores = buffers.scores;
+        scores.create(roi.rows - height + 1, roi.cols - width + 1, CV_32F);
+        for (int y = 0; y < scores.rows; ++y) {
+            const float* correlation_row = correlation.ptr<float>(y);
+            float* score_row = scores.ptr<float>(y);
+            for (int x = 0; x < scores.cols; ++x) {
+                const double window_sum = rect_sum(sum, x, y, width, height);
+                const double variance = rect_sum(sqsum, x, y, width, height) - window_sum * window_sum / nb_pixels;
+                score_row[x] = variance < min_variance
+                                   ? 0.0f
+                                   : (float) (correlation_row[x] / (std::sqrt(variance) * scaled_template.norm));
+            }
+        }
+
+        double max_score;
+        cv::Point peak;
+        cv::minMaxLoc(scores, nullptr, &max_score, nullptr, &peak);
+        if (best.has_value() && max_score <= best->score)
+            continue;
+
+        cv::Point2f refined(peak.x, peak.y);
+        if (peak.x > 0 && peak.x < scores.cols - 1) {
+            refined.x += parabolic_offset(scores.at<float>(peak.y, peak.x - 1), (float) max_score,
+                                          scores.at<float>(peak.y, peak.x + 1));
+        }
+        if (peak.y > 0 && peak.y < scores.rows - 1) {
+            refined.y += parabolic_offset(scores.at<float>(peak.y - 1, peak.x), (float) max_score,
+                                          scores.at<float>(peak.y + 1, peak.x));
+        }
+
+        const cv::Point2f center(refined.x + (width - 1) / 2.0f + offset.x, refined.y + (height - 1) / 2.0f + offset.y);
+        best = TemplateMatch{ center, (float) max_score, scaled_template.scale };
+    }
+    return best;
+}
@@ -0,0 +1,92 @@
+#ifndef TEMPLATE_MATCHER_H
+#define TEMPLATE_MATCHER_H
+
+/**
+ * @file template_matcher.h
+ * @brief Recherche d'un modèle par corrélation croisée normalisée calculée dans le domaine fréquentiel.
+ *
+ * La corrélation d'une zone avec un modèle de taille w × h coûte O(W·H·w·h) dans le domaine spatial,
+ * mais seulement quelques transformées de Fourier dans le domaine fréquentiel. La transformée de la
+ * zone est calculée une seule fois puis réutilisée pour toutes les échelles du modèle, dont les
+ * spectres sont mis en cache pour chaque taille de transformée. La normalisation (moyenne et
+ * écart-type de la zone sous chaque position du modèle) est obtenue par images intégrales.
+ */
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <common.h>
+
+/**
+ * @brief Meilleure position d'un modèle dans une zone
+ */
+struct TemplateMatch {
+    cv::Point2f center; ///< Centre du modèle à la position du pic, au sous-pixel
+    float score;        ///< Corrélation croisée normalisée au pic, entre -1 et 1
+    float scale;        ///< Échelle du modèle ayant donné le meilleur score
+};
+
+/**
+ * @brief Tampons de travail de TemplateMatcher::match, réutilisés d'une zone à l'autre
+ *
+ * Tant que les zones analysées gardent la même taille, aucun appel ne réalloue ses tampons.
+ */
+struct TemplateMatchBuffers {
+    cv::Mat padded;      ///< Zone convertie en CV_32F et complétée à la taille de la transformée
+    cv::Mat spectrum;    ///< Transformée de la zone
+    cv::Mat sum;         ///< Image intégrale de la zone
+    cv::Mat sqsum;       ///< Image intégrale des carrés de la zone
+    cv::Mat correlation; ///< Corrélation de la zone avec une échelle du modèle
+    cv::Mat scores;      ///< Corrélation normalisée de chaque position du modèle
+};
+
+/**
+ * @brief Modèle décliné en plusieurs échelles, recherché par corrélation dans le domaine fréquentiel
+ *
+ * Les méthodes constantes peuvent être appelées depuis plusieurs threads : le cache des spectres
+ * est protégé par un mutex.
+ */
+class TemplateMatcher {
+  public:
+    /**
+     * @brief Prépare un modèle à plusieurs échelles
+     *
+     * @param templ Modèle en niveaux de gris (CV_8U)
+     * @param scales Facteurs d'échelle appliqués au modèle
+     * @throw std::invalid_argument Si le modèle est vide ou n'est pas au format CV_8U
+     */
+    TemplateMatcher(const cv::Mat& templ, const std::vector<float>& scales);
+
+    /**
+     * @brief Cherche la meilleure position du modèle dans une zone, toutes échelles confondues
+     *
+     * Le pic de corrélation est affiné au sous-pixel par interpolation parabolique dans chaque
+     * direction. Les échelles dont le modèle est plus grand que la zone sont ignorées.
+     *
+     * @param buffers Tampons de travail de l'appelant (un jeu par thread)
+     * @param roi Zone en niveaux de gris (CV_8U)
+     * @param offset Décalage de la zone dans l'image complète, ajouté au centre retourné
+     * @return std::optional<TemplateMatch> Meilleure position, ou nullopt si aucune échelle ne tient dans la zone
+     */
+    std::optional<TemplateMatch> match(TemplateMatchBuffers& buffers, const cv::Mat& roi,
+                                       const cv::Point2i& offset = { 0, 0 }) const;
+
+  private:
+    struct ScaledTemplate {
+        cv::Mat centered; ///< Modèle de moyenne nulle (CV_32F)
+        double norm;      ///< Norme euclidienne du modèle centré
+        float scale;
+    };
+
+    const cv::Mat& spectrum(size_t index, const cv::Size& dft_size) const;
+
+    std::vector<ScaledTemplate> templates_;
+
+    mutable std::mutex cache_mutex_;
+    /// Spectres des modèles, indexés par (largeur, hauteur) de la transformée puis par échelle
+    mutable std::map<std::pair<int, int>, std::vector<cv::Mat>> spectra_;
+};
+
+#endif // TEMPLATE_MATCHER_H
@@ -0,0 +1,133 @@
+#include <algorithm>
+
+#include "thread_pool.h"
+
+namespace {
+// Identité du worker courant, pour que les sous-tâches restent dans la file locale
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local int current_index = -1;
+} // namespace
+
+ThreadPool::ThreadPool(int nb_threads) {
+    if (nb_threads <= 0)
+        nb_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    queues_.reserve(nb_threads);
+    for (int i = 0; i < nb_threads; ++i) {
+        queues_.emplace_back(std::make_unique<WorkerQueue>());
+    }
+
+    workers_.reserve(nb_threads);
+    for (int i = 0; i < nb_threads; ++i) {
+        workers_.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        done_cv_.wait(lock, [this]() { return pending_ == 0; });
+        stop_ = true;
+    }
+    wake_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+int ThreadPool::size() const {
+    return (int) workers_.size();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t index;
+    if (current_pool == this) {
+        index = current_index;
+    } else {
+        index = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        pending_ += 1;
+        queued_ += 1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.emplace_back(std::move(task));
+    }
+    wake_cv_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    done_cv_.wait(lock, [this]() { return pending_ == 0; });
+
+    if (first_exception_) {
+        auto exception = first_exception_;
+        first_exception_ = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+bool ThreadPool::pop_task(int index, std::function<void()>& task) {
+    // file locale : dernier entré, premier sorti (meilleure localité de cache)
+    {
+        auto& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // vol : on prend la tâche la plus ancienne des autres files
+    const int nb_queues = (int) queues_.size();
+    for (int offset = 1; offset < nb_queues; ++offset) {
+        auto& victim = *queues_[(index + offset) % nb_queues];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run_task(std::function<void()>& task) {
+    std::exception_ptr exception;
+    try {
+        task();
+    } catch (...) { exception = std::current_exception(); }
+
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    if (exception && !first_exception_)
+        first_exception_ = exception;
+    pending_ -= 1;
+    if (pending_ == 0)
+        done_cv_.notify_all();
+}
+
+void ThreadPool::worker_loop(int index) {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+        std::function<void()> task;
+        if (pop_task(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                queued_ -= 1;
+            }
+            run_task(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_cv_.wait(lock, [this]() { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0)
+            return;
+    }
+}
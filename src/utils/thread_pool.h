@@ -0,0 +1,93 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/**
+ * @file thread_pool.h
+ * @brief Pool de threads à vol de tâches (work-stealing) pour le traitement par lot.
+ *
+ * Chaque worker possède sa propre file de tâches. Un worker dépile d'abord ses propres tâches
+ * (par l'arrière) puis, lorsqu'il n'a plus rien à faire, vole des tâches en tête de la file
+ * des autres workers. Cela répartit naturellement la charge lorsque les tâches ont des durées
+ * très variables (copies difficiles à analyser, images de tailles différentes, etc.).
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Pool de threads à vol de tâches
+ *
+ * Les tâches sont soumises avec submit() puis on attend leur terminaison avec wait().
+ * Si une tâche lève une exception, la première exception capturée est relancée par wait().
+ */
+class ThreadPool {
+  public:
+    /**
+     * @brief Construit un pool de threads
+     *
+     * @param nb_threads Nombre de workers (si <= 0, utilise le nombre de cœurs disponibles)
+     */
+    explicit ThreadPool(int nb_threads);
+
+    /**
+     * @brief Attend la fin des tâches en cours puis arrête les workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Soumet une tâche au pool
+     *
+     * Si l'appel provient d'un worker du pool, la tâche est placée dans sa propre file ;
+     * sinon les tâches sont réparties à tour de rôle entre les files des workers.
+     *
+     * @param task Tâche à exécuter
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Bloque jusqu'à ce que toutes les tâches soumises soient terminées
+     *
+     * @throw Relance la première exception levée par une tâche, le cas échéant
+     */
+    void wait();
+
+    /**
+     * @brief Retourne le nombre de workers du pool
+     */
+    int size() const;
+
+  private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void worker_loop(int index);
+    bool pop_task(int index, std::function<void()>& task);
+    void run_task(std::function<void()>& task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    size_t queued_ = 0;  ///< Tâches en attente dans les files (protégé par wake_mutex_)
+    size_t pending_ = 0; ///< Tâches soumises et non terminées (protégé par wake_mutex_)
+    bool stop_ = false;
+
+    std::atomic<size_t> next_queue_{ 0 };
+    std::exception_ptr first_exception_;
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,9 @@
+/**
+ * Rend un marqueur SVG seul, sans marge, pour servir de modèle à la détection par corrélation.
+ * Entrées : marker (chemin relatif à ce fichier), size (taille du marqueur en mm)
+ */
+#let marker = sys.inputs.at("marker", default: "assets/marker-custom.svg")
+#let size = float(sys.inputs.at("size", default: "10")) * 1mm
+
+#set page(width: size, height: size, margin: 0mm)
+#image(marker, width: size, height: size)